@@ -7,6 +7,7 @@
 #include "skybox.h"
 #include "player.h"
 #include "testing.h"
+#include "entity/entity_scheduler.h"
 
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_sdl2.h"
@@ -293,6 +294,11 @@ public:
 	{
 		CL_SendConVar( sName, srArgs );
 	}
+
+	void SetEntityWorkerCount( u32 sCount ) override
+	{
+		EntSched_SetWorkerCount( sCount );
+	}
 };
 
 
@@ -21,8 +21,11 @@ class IClientSystem : public ISystem
 
 	// Sends this convar over to the server to execute
 	virtual void SendConVar( std::string_view sName, const std::vector< std::string >& srArgs = {} ) = 0;
+
+	// Amount of worker threads the client can use for entity systems, call before connecting to a server
+	virtual void SetEntityWorkerCount( u32 sCount )                                                  = 0;
 };
 
 
 #define ICLIENT_NAME "Client"
-#define ICLIENT_VER  2
+#define ICLIENT_VER  3
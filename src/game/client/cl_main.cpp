@@ -6,6 +6,7 @@
 #include "player.h"
 #include "steam.h"
 #include "network/net_main.h"
+#include "entity/entity_interp.h"
 
 #include "flatbuffers/sidury_generated.h"
 
@@ -34,6 +35,7 @@ LOG_CHANNEL_REGISTER( Client, ELogColor_White );
 
 static Socket_t                   gClientSocket = CH_INVALID_SOCKET;
 ch_sockaddr                       gClientAddr;
+static NetChannel_t               gClientChannel;
 
 EClientState                      gClientState = EClientState_Idle;
 CL_ServerData_t                   gClientServerData;
@@ -49,10 +51,36 @@ static bool                       gClientWait_ComponentList         = false;
 static bool                       gClientWait_ServerInfo            = false;
 // static bool                       gClientWait_ComponentRegistryInfo = false;
 
+// Server tick of the last entity and component lists we applied, older ones arriving late are ignored
+// The lower of the two is sent back to the server, so it knows what it can delta encode against
+static u32                        gClientEntityListTick             = 0;
+static u32                        gClientComponentListTick          = 0;
+
 // Console Commands to send to the server to process, like noclip
 static std::vector< std::string > gCommandsToSend;
 UserCmd_t                         gClientUserCmd{};
 
+// Commands we sent recently, indexed by command number, older ones are sent again with new ones in case they were lost
+static constexpr u32              CH_USERCMD_HISTORY = 128;
+static UserCmd_t                  gClientUserCmdHistory[ CH_USERCMD_HISTORY ]{};
+static u32                        gClientCommandNumber = 0;
+
+// Client Side Prediction
+// States of the local player after each predicted command, indexed by command number like the command history
+static PlayerMoveState_t          gClientPredictedStates[ CH_USERCMD_HISTORY ]{};
+
+// Last state of the local player the server sent us, server updates are delta encoded so they're applied on top of this
+static PlayerMoveState_t          gClientServerMoveState{};
+static bool                       gClientServerMoveStateValid = false;
+
+// Newest command the server ran, and the tick of the component list that has the result of it
+static u32                        gClientAckCommandNumber = 0;
+static u32                        gClientAckTick          = 0;
+
+// Newest command we predicted, and the newest one that has already been predicted once before a replay
+static u32                        gClientPredictedCommand = 0;
+static u32                        gClientReplayCommand    = 0;
+
 std::vector< CL_Client_t >        gClClients;
 
 extern EntitySystem*              entities;
@@ -76,6 +104,9 @@ CONCMD_VA( cl_map_list_rebuild, "Rebuild the map list now" )
 CONVAR_FLOAT( cl_connect_timeout_duration, 30.f, "How long we will wait for the server to send us connection information" );
 CONVAR_FLOAT( cl_timeout_duration, 120.f, "How long we will wait for the server to start responding again before disconnecting" );
 CONVAR_FLOAT( cl_timeout_threshold, 4.f, "If the server doesn't send anything after this amount of time, show the connection problem message" );
+CONVAR_RANGE_INT( cl_cmd_backup, 2, 0, 8, CVARF_ARCHIVE, "Amount of older commands sent again with each new one, so the server can fill in lost packets" );
+CONVAR_BOOL( cl_predict, 1, CVARF_ARCHIVE, "Run local player movement right away instead of waiting for the server" );
+CONVAR_RANGE_FLOAT( cl_predict_error, 0.05, 0, 10, "How far the predicted position can be from the server's before commands are replayed on top of the server's state" );
 
 INPUT_CONVAR( in_forward, "" );
 INPUT_CONVAR( in_back, "" );
@@ -106,6 +137,14 @@ CONVAR_BOOL_CMD( cl_username_use_steam, 1, CVARF_ARCHIVE, "Use username from ste
 }
 
 
+CONVAR_INT_CMD( rate, 131072, CVARF_ARCHIVE, "Most bytes per second we want the server to send us, 0 for no limit, the server may limit this further" )
+{
+	// Let the server know if we are connected to one
+	if ( gClientState == EClientState_Connecting || gClientState == EClientState_Connected )
+		CL_SendClientInfo();
+}
+
+
 CONCMD( cl_request_full_update )
 {
 	CL_SendFullUpdateRequest();
@@ -183,7 +222,7 @@ void CL_WriteMsgData( flatbuffers::FlatBufferBuilder& srRootBuilder, flatbuffers
 
 
 // Same as CL_WriteMsgData, but also sends it to the server
-void CL_WriteMsgDataToServer( flatbuffers::FlatBufferBuilder& srDataBuffer, EMsgSrc_Client sType )
+void CL_WriteMsgDataToServer( flatbuffers::FlatBufferBuilder& srDataBuffer, EMsgSrc_Client sType, bool sReliable = true )
 {
 	PROF_SCOPE();
 
@@ -195,7 +234,7 @@ void CL_WriteMsgDataToServer( flatbuffers::FlatBufferBuilder& srDataBuffer, EMsg
 	root.add_data( vector );
 	builder.Finish( root.Finish() );
 
-	CL_WriteToServer( builder );
+	CL_WriteToServer( builder, sReliable );
 }
 
 
@@ -226,28 +265,8 @@ void CL_Update( float frameTime )
 			// I HATE THIS
 			if ( gClientWait_EntityList && gClientWait_ComponentList && gClientWait_ServerInfo )
 			{
-				// Try to load the map if we aren't hosting the server
-				// if ( !Game_IsHosting() )
-#if 0
-				{
-					// Do we have the map?
-					if ( !MapManager_FindMap( gClientServerData.aMapName ) )
-					{
-						// Maybe one day we can download the map from the server
-						Log_ErrorF( gLC_Client, "Failed to Find Map: \"%s\"\n", gClientServerData.aMapName.c_str() );
-						CL_Disconnect( true, "Missing Map" );
-						break;
-					}
-
-					// Load Map (MAKE THIS ASYNC)
-					if ( !MapManager_LoadMap( gClientServerData.aMapName ) )
-					{
-						Log_ErrorF( gLC_Client, "Failed to Load Map: \"%s\"\n", gClientServerData.aMapName.c_str() );
-						CL_Disconnect( true, "Failed to Load Map" );
-						break;
-					}
-				}
-#endif
+				// The client doesn't load the map, every map entity comes from the server in the entity list
+				// Loading it here would create local copies of all of them, the server does the async load
 
 				gClientState = EClientState_Connected;
 
@@ -265,13 +284,25 @@ void CL_Update( float frameTime )
 
 		case EClientState_Connected:
 		{
-			// Process Stuff from server
+			// Process Stuff from server, with the local player and interpolated entities rolled back to the last state the server sent
+			PlayerMoveState_t predictedState;
+			u32               componentListTick = gClientComponentListTick;
+			bool              predicting        = CL_PredictBegin( predictedState );
+
+			EntInterp_RestoreLatest();
+
 			CL_GetServerMessages();
 
+			if ( predicting )
+				CL_PredictEnd( predictedState, componentListTick );
+
+			EntInterp_Update();
+
 			if ( !Game_IsPaused() && input->WindowHasFocus() && !CL_IsMenuShown() )
 				players.DoMouseLook( gLocalPlayer );
 
 			CL_UpdateUserCmd();
+			CL_PredictUserCmds();
 
 			CL_GameUpdate( frameTime );
 
@@ -287,6 +318,13 @@ void CL_Update( float frameTime )
 		}
 	}
 
+	// Resend anything reliable the server hasn't acked yet
+	if ( gClientState != EClientState_Idle && !NetChannel_Resend( gClientChannel, gClientSocket, gClientAddr ) )
+	{
+		Log_Msg( gLC_Client, "Disconnecting From Server - Too many reliable messages waiting on the server\n" );
+		CL_Disconnect();
+	}
+
 	// Update Entity and Component States
 	if ( EntSysData().aActive )
 		Entity_UpdateStates();
@@ -440,6 +478,7 @@ void CL_Disconnect( bool sSendReason, const char* spReason )
 		gClientSocket = CH_INVALID_SOCKET;
 	}
 
+	Net_ClearFragments();
 	memset( &gClientAddr, 0, sizeof( gClientAddr ) );
 
 	if ( gClientState != EClientState_Idle )
@@ -457,6 +496,23 @@ void CL_Disconnect( bool sSendReason, const char* spReason )
 	gClientWait_ComponentList = false;
 	gClientWait_ServerInfo    = false;
 
+	gClientEntityListTick     = 0;
+	gClientComponentListTick  = 0;
+
+	// The server starts over on command numbers for a new connection
+	gClientCommandNumber      = 0;
+	gClientUserCmd            = {};
+
+	gClientServerMoveStateValid = false;
+	gClientAckCommandNumber     = 0;
+	gClientAckTick              = 0;
+	gClientPredictedCommand     = 0;
+	gClientReplayCommand        = 0;
+
+	for ( PlayerMoveState_t& state : gClientPredictedStates )
+		state = {};
+
+	EntInterp_Clear();
 	Entity_Shutdown();
 }
 
@@ -499,8 +555,11 @@ void CL_Connect( const char* spAddress )
 	if ( connectRet != 0 )
 		return;
 
+	// Sent reliably, so it's sent again if the server doesn't get it
+	NetChannel_Reset( gClientChannel );
+
 	builder.Finish( msgClientConnect );
-	int write = Net_WriteFlatBuffer( gClientSocket, gClientAddr, builder );
+	int write = NetChannel_WriteFlatBuffer( gClientChannel, gClientSocket, gClientAddr, builder, true );
 
 	if ( write > 0 )
 	{
@@ -516,9 +575,9 @@ void CL_Connect( const char* spAddress )
 }
 
 
-int CL_WriteToServer( flatbuffers::FlatBufferBuilder& srBuilder )
+int CL_WriteToServer( flatbuffers::FlatBufferBuilder& srBuilder, bool sReliable )
 {
-	return Net_WriteFlatBuffer( gClientSocket, gClientAddr, srBuilder );
+	return NetChannel_WriteFlatBuffer( gClientChannel, gClientSocket, gClientAddr, srBuilder, sReliable );
 }
 
 
@@ -575,15 +634,19 @@ void CL_UpdateUserCmd()
 	PROF_SCOPE();
 
 	// Get the transform component from the camera entity on the local player, and get the angles from it
-	auto playerInfo = Ent_GetComponent< CPlayerInfo >( gLocalPlayer, "playerInfo" );
+	auto playerInfo = Ent_GetComponent< CPlayerInfo >( gLocalPlayer );
 
 	if ( !playerInfo )
 		return;
 
-	auto camTransform = Ent_GetComponent< CTransform >( playerInfo->aCamera, "transform" );
+	auto camTransform = Ent_GetComponent< CTransform >( playerInfo->aCamera );
 
 	CH_ASSERT( camTransform );
 
+	// Every frame is a new command, the server runs each one over the time it was held for
+	gClientUserCmd.aCommandNumber = ++gClientCommandNumber;
+	gClientUserCmd.aFrameTime     = gFrameTime;
+
 	// Reset Values
 	gClientUserCmd.aButtons    = 0;
 	gClientUserCmd.aFlashlight = false;
@@ -616,32 +679,177 @@ void CL_UpdateUserCmd()
 }
 
 
-void CL_BuildUserCmd( flatbuffers::FlatBufferBuilder& srBuilder )
+const UserCmd_t* CL_GetUserCmd( u32 sCommandNumber )
+{
+	if ( sCommandNumber == 0 || sCommandNumber > gClientCommandNumber || gClientCommandNumber - sCommandNumber >= CH_USERCMD_HISTORY )
+		return nullptr;
+
+	return &gClientUserCmdHistory[ sCommandNumber % CH_USERCMD_HISTORY ];
+}
+
+
+// --------------------------------------------------------------------
+// Client Side Prediction
+
+
+bool CL_PredictBegin( PlayerMoveState_t& srPredicted )
 {
 	PROF_SCOPE();
 
-	flatbuffers::Offset< Vec3 > anglesOffset{};
-	// CH_NET_WRITE_VEC3( angles, gClientUserCmd.aAng );
+	if ( !cl_predict || !players.SaveMoveState( gLocalPlayer, srPredicted ) )
+	{
+		// Anything saved is out of date by the time this is turned back on
+		gClientServerMoveStateValid = false;
+		return false;
+	}
 
-#if 0
-	Vec3Builder vec3Build( srBuilder );
-	NetHelper_WriteVec3( vec3Build, gClientUserCmd.aAng );
-	anglesOffset = vec3Build.Finish();
-#endif
-	
+	if ( gClientServerMoveStateValid )
+		players.RestoreMoveState( gLocalPlayer, gClientServerMoveState );
+
+	return true;
+}
+
+
+void CL_PredictEnd( const PlayerMoveState_t& srPredicted, u32 sPrevComponentListTick )
+{
+	PROF_SCOPE();
+
+	if ( gClientComponentListTick == sPrevComponentListTick )
+	{
+		players.RestoreMoveState( gLocalPlayer, srPredicted );
+		return;
+	}
+
+	// Always keep what the server sent, the next update is delta encoded against it
+	gClientServerMoveStateValid = players.SaveMoveState( gLocalPlayer, gClientServerMoveState );
+
+	// Without an ack for this update, we don't know which of our commands it's from, so keep our prediction
+	if ( !gClientServerMoveStateValid || gClientAckTick != gClientComponentListTick )
+	{
+		players.RestoreMoveState( gLocalPlayer, srPredicted );
+		return;
+	}
+
+	u32 ackCommand                        = gClientAckCommandNumber;
+	gClientServerMoveState.aCommandNumber = ackCommand;
+
+	const PlayerMoveState_t& predicted    = gClientPredictedStates[ ackCommand % CH_USERCMD_HISTORY ];
+
+	if ( predicted.aCommandNumber == ackCommand &&
+	     predicted.aMoveType == gClientServerMoveState.aMoveType &&
+	     predicted.aPlayerFlags == gClientServerMoveState.aPlayerFlags &&
+	     glm::distance( predicted.aPos, gClientServerMoveState.aPos ) <= cl_predict_error )
+	{
+		players.RestoreMoveState( gLocalPlayer, srPredicted );
+		return;
+	}
+
+	Log_DevF( gLC_Client, 1, "Prediction Error on Command %u, Replaying %u Commands\n", ackCommand, gClientCommandNumber - ackCommand );
+
+	// The local player is on the server's state now, run every command it hasn't gotten to yet on top of it
+	gClientReplayCommand    = gClientPredictedCommand;
+	gClientPredictedCommand = ackCommand;
+
+	players.RestoreMoveState( gLocalPlayer, gClientServerMoveState );
+}
+
+
+void CL_PredictUserCmds()
+{
+	PROF_SCOPE();
+
+	// Don't run commands made while prediction was off once it's turned back on
+	if ( !cl_predict || !GetPlayerMoveData( gLocalPlayer ) )
+	{
+		gClientPredictedCommand = gClientCommandNumber;
+		return;
+	}
+
+	for ( u32 commandNumber = gClientPredictedCommand + 1; commandNumber <= gClientCommandNumber; commandNumber++ )
+	{
+		// The newest command isn't in the history until it's sent
+		const UserCmd_t* userCmd = commandNumber == gClientUserCmd.aCommandNumber ? &gClientUserCmd : CL_GetUserCmd( commandNumber );
+
+		if ( !userCmd )
+			continue;
+
+		players.PredictUserCmd( gLocalPlayer, *userCmd, commandNumber <= gClientReplayCommand );
+
+		PlayerMoveState_t& state = gClientPredictedStates[ commandNumber % CH_USERCMD_HISTORY ];
+		players.SaveMoveState( gLocalPlayer, state );
+		state.aCommandNumber = commandNumber;
+	}
+
+	gClientPredictedCommand = gClientCommandNumber;
+}
+
+
+static void CL_HandleMsg_UserCmdAck( const NetMsg_UserCmdAck* spMessage )
+{
+	// Only useful with the component list it was sent with, if that was dropped we don't have the state this is for
+	if ( spMessage->tick() != gClientComponentListTick )
+		return;
+
+	gClientAckCommandNumber = spMessage->command_number();
+	gClientAckTick          = spMessage->tick();
+}
+
+
+static flatbuffers::Offset< NetMsg_UserCmd > CL_WriteUserCmd( flatbuffers::FlatBufferBuilder& srBuilder, const UserCmd_t& srUserCmd )
+{
 	NetMsg_UserCmdBuilder builder( srBuilder );
 
-	Vec3                  posVec( gClientUserCmd.aAng.x, gClientUserCmd.aAng.y, gClientUserCmd.aAng.z );
-	builder.add_angles( &posVec );
+	Vec3                  angles( srUserCmd.aAng.x, srUserCmd.aAng.y, srUserCmd.aAng.z );
+	builder.add_angles( &angles );
 
-	Net_EPlayerMoveType moveType = static_cast< Net_EPlayerMoveType >( gClientUserCmd.aMoveType );
+	Net_EPlayerMoveType moveType = static_cast< Net_EPlayerMoveType >( srUserCmd.aMoveType );
 
-	CH_NET_WRITE_OFFSET( builder, angles );
-	builder.add_buttons( gClientUserCmd.aButtons );
-	builder.add_flashlight( gClientUserCmd.aFlashlight );
+	builder.add_buttons( srUserCmd.aButtons );
+	builder.add_flashlight( srUserCmd.aFlashlight );
 	builder.add_move_type( moveType );
+	builder.add_command_number( srUserCmd.aCommandNumber );
+	builder.add_frame_time( srUserCmd.aFrameTime );
 
-	srBuilder.Finish( builder.Finish() );
+	return builder.Finish();
+}
+
+
+void CL_BuildUserCmd( flatbuffers::FlatBufferBuilder& srBuilder )
+{
+	PROF_SCOPE();
+
+	// Older commands first, the server queues anything it missed before the new one
+	// Kept around so this doesn't allocate every frame
+	static std::vector< flatbuffers::Offset< NetMsg_UserCmd > > backup;
+	backup.clear();
+
+	for ( u32 i = cl_cmd_backup; i > 0; i-- )
+	{
+		if ( gClientUserCmd.aCommandNumber <= i )
+			continue;
+
+		if ( const UserCmd_t* backupCmd = CL_GetUserCmd( gClientUserCmd.aCommandNumber - i ) )
+			backup.push_back( CL_WriteUserCmd( srBuilder, *backupCmd ) );
+	}
+
+	flatbuffers::Offset< flatbuffers::Vector< flatbuffers::Offset< NetMsg_UserCmd > > > backupOffset;
+
+	if ( backup.size() )
+		backupOffset = srBuilder.CreateVector( backup );
+
+	Vec3                  angles( gClientUserCmd.aAng.x, gClientUserCmd.aAng.y, gClientUserCmd.aAng.z );
+	Net_EPlayerMoveType   moveType = static_cast< Net_EPlayerMoveType >( gClientUserCmd.aMoveType );
+
+	srBuilder.Finish( CreateNetMsg_UserCmd(
+	  srBuilder,
+	  &angles,
+	  gClientUserCmd.aButtons,
+	  moveType,
+	  gClientUserCmd.aFlashlight,
+	  std::min( gClientEntityListTick, gClientComponentListTick ),
+	  gClientUserCmd.aCommandNumber,
+	  gClientUserCmd.aFrameTime,
+	  backupOffset ) );
 }
 
 
@@ -649,9 +857,14 @@ void CL_SendUserCmd()
 {
 	PROF_SCOPE();
 
+	if ( gClientUserCmd.aCommandNumber )
+		gClientUserCmdHistory[ gClientUserCmd.aCommandNumber % CH_USERCMD_HISTORY ] = gClientUserCmd;
+
 	flatbuffers::FlatBufferBuilder userCmdBuilder;
 	CL_BuildUserCmd( userCmdBuilder );
-	CL_WriteMsgDataToServer( userCmdBuilder, EMsgSrc_Client_UserCmd );
+
+	// A new one is sent every frame with the last few as backups, so there's no point in resending a lost one
+	CL_WriteMsgDataToServer( userCmdBuilder, EMsgSrc_Client_UserCmd, false );
 }
 
 
@@ -723,6 +936,12 @@ void CL_HandleMsg_ServerConnectResponse( const NetMsg_ServerConnectResponse* spM
 	gClientState = EClientState_Connecting;
 
 	// Send them our client info now
+	CL_SendClientInfo();
+}
+
+
+void CL_SendClientInfo()
+{
 	flatbuffers::FlatBufferBuilder dataBuilder;
 	auto                           name = dataBuilder.CreateString( CL_GetUserName() );
 
@@ -730,6 +949,7 @@ void CL_HandleMsg_ServerConnectResponse( const NetMsg_ServerConnectResponse* spM
 
 	clientInfo.add_name( name );
 	clientInfo.add_steam_id( IsSteamLoaded() ? steam->GetSteamID() : 0 );
+	clientInfo.add_rate( std::max( (int)rate, 0 ) );
 	dataBuilder.Finish( clientInfo.Finish() );
 
 	CL_WriteMsgDataToServer( dataBuilder, EMsgSrc_Client_ClientInfo );
@@ -781,169 +1001,215 @@ inline const T* CL_ReadMsg( EMsgSrc_Server sMsgType, flatbuffers::Verifier& srVe
 }
 
 
-void CL_GetServerMessages()
+// Returns false if this message disconnected us
+static bool CL_ProcessServerMsg( const char* spData, int sLen )
 {
-	PROF_SCOPE();
+	// Read the message sent from the server
+	auto                  serverMsg = flatbuffers::GetRoot< MsgSrc_Server >( spData );
+	flatbuffers::Verifier verifyMsg( reinterpret_cast< const u8* >( spData ), sLen );
 
-	while ( true )
+	if ( !serverMsg->Verify( verifyMsg ) )
 	{
-		// TODO: SETUP FRAGMENT COMPRESSION !!!!!!!!
-		ChVector< char > data( 81920 );
-		int              len = Net_Read( gClientSocket, data.data(), data.size(), &gClientAddr );
+		Log_Warn( gLC_Client, "Error Parsing Message from Server\n" );
+		return true;
+	}
 
-		if ( len <= 0 )
-		{
-			gClientTimeout -= gFrameTime;
 
-			// The server hasn't sent anything in a while, so just disconnect
-			if ( gClientTimeout < 0.0 )
-			{
-				Log_Msg( gLC_Client, "Disconnecting From Server - Timeout period expired\n" );
-				CL_Disconnect();
-			}
+	EMsgSrc_Server msgType = serverMsg->type();
 
-			return;
-		}
+	CH_ASSERT( msgType <= EMsgSrc_Server_MAX );
+	CH_ASSERT( msgType >= EMsgSrc_Server_MIN );
 
-		data.resize( len );
+	if ( msgType > EMsgSrc_Server_MAX )
+	{
+		Log_WarnF( gLC_Client, "Unknown Message Type from Server: %zd\n", msgType );
+		return true;
+	}
 
-		// Reset the connection timer
-		gClientTimeout = cl_timeout_duration;
+	// Check Messages without message data first
+	// switch ( msgType )
+	// {
+	// 	// Server is Disconnecting Us, either because it's shutting down or we are kicked, etc.
+	// 	// TODO:
+	// 	case EMsgSrcServer::DISCONNECT:
+	// 	{
+	// 		CL_Disconnect();
+	// 		return;
+	// 	}
+	// 
+	// 	default:
+	// 		break;
+	// }
 
-		// Read the message sent from the server
-		auto                  serverMsg = flatbuffers::GetRoot< MsgSrc_Server >( data.begin() );
-		flatbuffers::Verifier verifyMsg( (u8*)data.data(), data.size_bytes() );
+	// Now check messages with message data
+	auto msgData = serverMsg->data();
 
-		if ( !serverMsg->Verify( verifyMsg ) )
+	if ( !msgData || !msgData->size() )
+	{
+		// Must be one of these messages to have a chance to contain no data
+		switch ( msgType )
 		{
-			Log_Warn( gLC_Client, "Error Parsing Message from Server\n" );
-			continue;
-		}
+			case EMsgSrc_Server_Disconnect:
+				Log_Msg( gLC_Client, "Disconnected from server: \n" );
+				CL_Disconnect( false );
+				return false;
 
+			case EMsgSrc_Server_ConVar:
+				return true;
 
-		EMsgSrc_Server msgType = serverMsg->type();
+			default:
+				Log_WarnF( gLC_Client, "Received Server Message Without Data: %s\n", SV_MsgToString( msgType ) );
+				return true;
+		}
+
+		return true;
+	}
 
-		CH_ASSERT( msgType < EMsgSrc_Server_MAX );
-		CH_ASSERT( msgType >= EMsgSrc_Server_MIN );
+	flatbuffers::Verifier msgDataVerify( msgData->data(), msgData->size() );
 
-		if ( msgType >= EMsgSrc_Server_MAX )
+	switch ( msgType )
+	{
+		case EMsgSrc_Server_Disconnect:
 		{
-			Log_WarnF( gLC_Client, "Unknown Message Type from Server: %zd\n", msgType );
-			continue;
+			//auto msgDisconnect = dataReader.getRoot< NetMsgDisconnect >();
+			//Log_MsgF( gLC_Client, "Disconnected from server: %s\n", msgDisconnect.getReason().cStr() );
+			Log_Msg( gLC_Client, "Disconnected from server: \n" );
+			CL_Disconnect( false );
+			return false;
 		}
 
-		// Check Messages without message data first
-		// switch ( msgType )
-		// {
-		// 	// Server is Disconnecting Us, either because it's shutting down or we are kicked, etc.
-		// 	// TODO:
-		// 	case EMsgSrcServer::DISCONNECT:
-		// 	{
-		// 		CL_Disconnect();
-		// 		return;
-		// 	}
-		// 
-		// 	default:
-		// 		break;
-		// }
-
-		// Now check messages with message data
-		auto msgData = serverMsg->data();
+		case EMsgSrc_Server_ConnectResponse:
+		{
+			if ( auto msg = CL_ReadMsg< NetMsg_ServerConnectResponse >( msgType, msgDataVerify, msgData ) )
+				CL_HandleMsg_ServerConnectResponse( msg );
+			break;
+		}
 
-		if ( !msgData || !msgData->size() )
+		case EMsgSrc_Server_ClientInfo:
 		{
-			// Must be one of these messages to have a chance to contain no data
-			switch ( msgType )
-			{
-				case EMsgSrc_Server_Disconnect:
-				case EMsgSrc_Server_ConVar:
-					continue;
+			if ( auto msg = CL_ReadMsg< NetMsg_ServerClientInfo >( msgType, msgDataVerify, msgData ) )
+				CL_HandleMsg_ClientInfo( msg );
+			break;
+		}
+		
+		case EMsgSrc_Server_ServerInfo:
+		{
+			if ( auto msg = CL_ReadMsg< NetMsg_ServerInfo >( msgType, msgDataVerify, msgData ) )
+				CL_HandleMsg_ServerInfo( msg );
+			break;
+		}
 
-				default:
-					Log_WarnF( gLC_Client, "Received Server Message Without Data: %s\n", SV_MsgToString( msgType ) );
-					continue;
-			}
+		case EMsgSrc_Server_ConVar:
+		{
+			auto msg = flatbuffers::GetRoot< NetMsg_ConVar >( msgData->data() );
+			if ( CL_VerifyMsg( msgType, msgDataVerify, msg ) && msg->command() )
+				Game_ExecCommandsSafe( ECommandSource_Server, msg->command()->str() );
 
-			continue;
+			break;
 		}
 
-		flatbuffers::Verifier msgDataVerify( msgData->data(), msgData->size() );
-
-		switch ( msgType )
+		case EMsgSrc_Server_ComponentList:
 		{
-			case EMsgSrc_Server_Disconnect:
+			if ( auto msg = CL_ReadMsg< NetMsg_ComponentUpdates >( msgType, msgDataVerify, msgData ) )
 			{
-				//auto msgDisconnect = dataReader.getRoot< NetMsgDisconnect >();
-				//Log_MsgF( gLC_Client, "Disconnected from server: %s\n", msgDisconnect.getReason().cStr() );
-				Log_Msg( gLC_Client, "Disconnected from server: \n" );
-				CL_Disconnect( false );
-				return;
+				// Applying an older update would undo newer changes
+				if ( msg->tick() <= gClientComponentListTick )
+					break;
+
+				gClientWait_ComponentList = true;
+				gClientComponentListTick  = msg->tick();
+				Entity_ReadComponentUpdates( msg );
+				EntInterp_FinishUpdate( msg->server_time(), msg->partial() );
 			}
+			break;
+		}
 
-			case EMsgSrc_Server_ConnectResponse:
+		case EMsgSrc_Server_EntityList:
+		{
+			if ( auto msg = CL_ReadMsg< NetMsg_EntityUpdates >( msgType, msgDataVerify, msgData ) )
 			{
-				if ( auto msg = CL_ReadMsg< NetMsg_ServerConnectResponse >( msgType, msgDataVerify, msgData ) )
-					CL_HandleMsg_ServerConnectResponse( msg );
-				break;
-			}
+				if ( msg->tick() <= gClientEntityListTick )
+					break;
 
-			case EMsgSrc_Server_ClientInfo:
-			{
-				if ( auto msg = CL_ReadMsg< NetMsg_ServerClientInfo >( msgType, msgDataVerify, msgData ) )
-					CL_HandleMsg_ClientInfo( msg );
-				break;
+				gClientWait_EntityList = true;
+				gClientEntityListTick  = msg->tick();
+				Entity_ReadEntityUpdates( msg );
 			}
-			
-			case EMsgSrc_Server_ServerInfo:
+			break;
+		}
+
+		case EMsgSrc_Server_UserCmdAck:
+		{
+			if ( auto msg = CL_ReadMsg< NetMsg_UserCmdAck >( msgType, msgDataVerify, msgData ) )
+				CL_HandleMsg_UserCmdAck( msg );
+			break;
+		}
+
+		case EMsgSrc_Server_Paused:
+		{
+			if ( auto msg = CL_ReadMsg< NetMsg_Paused >( msgType, msgDataVerify, msgData ) )
 			{
-				if ( auto msg = CL_ReadMsg< NetMsg_ServerInfo >( msgType, msgDataVerify, msgData ) )
-					CL_HandleMsg_ServerInfo( msg );
-				break;
+				Game_SetPaused( msg->paused() );
+				audio->SetPaused( msg->paused() );
 			}
+			break;
+		}
 
-			case EMsgSrc_Server_ConVar:
-			{
-				auto msg = flatbuffers::GetRoot< NetMsg_ConVar >( msgData->data() );
-				if ( CL_VerifyMsg( msgType, msgDataVerify, msg ) && msg->command() )
-					Game_ExecCommandsSafe( ECommandSource_Server, msg->command()->str() );
+		default:
+			Log_WarnF( gLC_Client, "Unknown Message Type from Server: %s\n", SV_MsgToString( msgType ) );
+			break;
+	}
 
-				break;
-			}
+	// A rejected connect response or a replicated command can disconnect us too
+	return gClientSocket != CH_INVALID_SOCKET;
+}
 
-			case EMsgSrc_Server_ComponentList:
-			{
-				if ( auto msg = CL_ReadMsg< NetMsg_ComponentUpdates >( msgType, msgDataVerify, msgData ) )
-				{
-					gClientWait_ComponentList = true;
-					Entity_ReadComponentUpdates( msg );
-				}
-				break;
-			}
 
-			case EMsgSrc_Server_EntityList:
-			{
-				if ( auto msg = CL_ReadMsg< NetMsg_EntityUpdates >( msgType, msgDataVerify, msgData ) )
-				{
-					gClientWait_EntityList = true;
-					Entity_ReadEntityUpdates( msg );
-				}
-				break;
-			}
+void CL_GetServerMessages()
+{
+	PROF_SCOPE();
+
+	while ( true )
+	{
+		// Kept around so we don't allocate this every read, aligned so the message after the packet header can be verified in place
+		alignas( 8 ) static char data[ CH_NET_PACKET_SIZE ];
+		int                      len = Net_Read( gClientSocket, data, CH_NET_PACKET_SIZE, &gClientAddr );
+
+		if ( len <= 0 )
+		{
+			gClientTimeout -= gFrameTime;
 
-			case EMsgSrc_Server_Paused:
+			// The server hasn't sent anything in a while, so just disconnect
+			if ( gClientTimeout < 0.0 )
 			{
-				if ( auto msg = CL_ReadMsg< NetMsg_Paused >( msgType, msgDataVerify, msgData ) )
-				{
-					Game_SetPaused( msg->paused() );
-					audio->SetPaused( msg->paused() );
-				}
-				break;
+				Log_Msg( gLC_Client, "Disconnecting From Server - Timeout period expired\n" );
+				CL_Disconnect();
 			}
 
-			default:
-				Log_WarnF( gLC_Client, "Unknown Message Type from Server: %s\n", SV_MsgToString( msgType ) );
-				break;
+			return;
 		}
+
+		// Reset the connection timer
+		gClientTimeout = cl_timeout_duration;
+
+		// Wait until we have every fragment of the message
+		int         msgLen = 0;
+		const char* msg    = Net_ReadMessage( gClientAddr, data, len, msgLen );
+
+		if ( !msg || msgLen <= 0 )
+			continue;
+
+		// Read the messages it had, reliable ones that were waiting on this one come with it
+		bool connected = true;
+
+		NetChannel_Read( gClientChannel, msg, msgLen, [ & ]( const char* spData, int sLen )
+		{
+			if ( connected )
+				connected = CL_ProcessServerMsg( spData, sLen );
+		} );
+
+		if ( !connected )
+			return;
 	}
 }
 
@@ -11,6 +11,7 @@ using SteamID64_t = u64;
 using Entity = size_t;
 
 struct UserCmd_t;
+struct PlayerMoveState_t;
 
 enum ESteamAvatarSize;
 
@@ -85,15 +86,31 @@ bool                   CL_SendConVarIfClient( std::string_view sName, const std:
 void                   CL_SendConVar( std::string_view sName, const std::vector< std::string >& srArgs = {} );
 void                   CL_SendConVars();
 
-int                    CL_WriteToServer( flatbuffers::FlatBufferBuilder& srBuilder );
+// Messages are sent reliably unless they're sent again every frame anyway
+int                    CL_WriteToServer( flatbuffers::FlatBufferBuilder& srBuilder, bool sReliable = true );
 
 void                   CL_HandleMsg_ClientInfo( const NetMsg_ServerClientInfo* spMessage );
+
+// Send our name and rate to the server
+void                   CL_SendClientInfo();
 void                   CL_HandleMsg_ServerInfo( const NetMsg_ServerInfo* spReader );
 
 bool                   CL_WaitForAccept();
 void                   CL_UpdateUserCmd();
 void                   CL_BuildUserCmd( flatbuffers::FlatBufferBuilder& srBuilder );
 void                   CL_SendUserCmd();
+
+// Get a command we sent recently, nullptr if it's too old or hasn't been made yet
+const UserCmd_t*       CL_GetUserCmd( u32 sCommandNumber );
+
+// Client side prediction of the local player
+// Begin puts the last state the server sent back on the local player before reading server messages, and returns our predicted state
+// End checks what the server sent against what we predicted, and either keeps our prediction or sets up a replay of unacked commands
+bool                   CL_PredictBegin( PlayerMoveState_t& srPredicted );
+void                   CL_PredictEnd( const PlayerMoveState_t& srPredicted, u32 sPrevComponentListTick );
+
+// Run movement for any commands we haven't predicted yet
+void                   CL_PredictUserCmds();
 void                   CL_SendFullUpdateRequest();
 void                   CL_GetServerMessages();
 
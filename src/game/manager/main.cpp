@@ -15,6 +15,10 @@
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_sdl2.h"
 
+#include <iostream>
+#include <mutex>
+#include <thread>
+
 
 #if CH_USE_MIMALLOC
 	#include "mimalloc-new-delete.h"
@@ -34,6 +38,7 @@ static bool                gMaxWindow         = args_register( "Maximize the mai
 static bool                gArgNoSteam        = args_register( "Don't try to load the steam abstraction", "--no-steam" );
 static bool                gWaitForDebugger   = args_register( "Upon Program Startup, Wait for the Debugger to attach", "--debugger" );
 static bool                gDedicatedServer   = args_register( "Host a Dedicated Server", "--server" );
+static bool                gHeadless          = args_register( "Host a Dedicated Server without a window, ui or input, console commands are read from stdin", "--headless" );
 // static bool    gDedicatedServer = false;
 static bool                gRunning           = true;
 
@@ -132,6 +137,12 @@ static AppModule_t gAppModulesClient[] =
 };
 
 
+// No window, so no gui, input or graphics, physics loads collision shapes from their own files
+static AppModule_t gAppModulesHeadless[] = {
+	{ (ISystem**)&physics,   "ch_physics", IPHYSICS_NAME, IPHYSICS_VER },
+};
+
+
 static AppModule_t gAppModulesServer[] = {
 	{ (ISystem**)&input,     "ch_input", IINPUTSYSTEM_NAME, IINPUTSYSTEM_VER },
 	{ (ISystem**)&render,    "ch_graphics_api_vk", IRENDER_NAME, IRENDER_VER },
@@ -327,6 +338,20 @@ bool LoadGameSystems()
 		return false;
 	}
 
+	// Split the spare cores for entity system workers between the client and server,
+	// the main thread already runs one of them and both update on it one after the other
+	u32 spareThreads = std::max( std::thread::hardware_concurrency(), 1u ) - 1;
+
+	if ( gDedicatedServer )
+	{
+		server->SetEntityWorkerCount( spareThreads );
+	}
+	else
+	{
+		server->SetEntityWorkerCount( spareThreads / 2 );
+		client->SetEntityWorkerCount( spareThreads - ( spareThreads / 2 ) );
+	}
+
 	return true;
 }
 
@@ -419,30 +444,105 @@ bool HandleEvents()
 }
 
 
-// Return true if we skip this frame
-bool UpdateFrameTime( std::chrono::steady_clock::time_point& startTime, std::chrono::steady_clock::time_point& currentTime, float& time )
+// Sleep until the wake time, sys_sleep can oversleep, so it's only used while there's plenty of time left, and the rest is spent yielding
+void SleepUntil( std::chrono::steady_clock::time_point wakeTime )
 {
-	currentTime = std::chrono::high_resolution_clock::now();
+	PROF_SCOPE();
+
+	while ( true )
+	{
+		auto remaining = wakeTime - std::chrono::steady_clock::now();
+
+		if ( remaining <= std::chrono::steady_clock::duration::zero() )
+			return;
+
+		if ( remaining > std::chrono::milliseconds( 2 ) )
+			sys_sleep( 1 );
+		else
+			std::this_thread::yield();
+	}
+}
+
+
+// Wait until both the max fps allows another frame and wakeTime has passed, then get the frame time
+void UpdateFrameTime( std::chrono::steady_clock::time_point& startTime, std::chrono::steady_clock::time_point& currentTime, float& time, std::chrono::steady_clock::time_point wakeTime )
+{
+	if ( host_fps_max > 0.f )
+	{
+		float maxFps       = glm::clamp( host_fps_max, 10.f, 5000.f );
+		auto  minFrameTime = std::chrono::duration_cast< std::chrono::steady_clock::duration >( std::chrono::duration< float >( 1.0f / maxFps ) );
+
+		wakeTime           = std::max( wakeTime, startTime + minFrameTime );
+	}
+
+	SleepUntil( wakeTime );
+
+	currentTime = std::chrono::steady_clock::now();
 	time        = std::chrono::duration< float, std::chrono::seconds::period >( currentTime - startTime ).count();
 
 	// don't let the time go too crazy, usually happens when in a breakpoint
 	time        = glm::min( time, host_max_frametime );
+}
 
-	if ( host_fps_max > 0.f )
+
+// When the server will want to run its next tick, used so a dedicated server can sleep between ticks instead of spinning
+std::chrono::steady_clock::time_point GetNextServerTickTime()
+{
+	auto  now      = std::chrono::steady_clock::now();
+	float tickTime = server->GetTimeUntilNextTick();
+
+	// Server time doesn't move forward while the timescale is 0, so fall back to the max fps
+	if ( tickTime <= 0.f || host_timescale <= 0.f )
+		return now;
+
+	return now + std::chrono::duration_cast< std::chrono::steady_clock::duration >( std::chrono::duration< float >( tickTime / host_timescale ) );
+}
+
+
+// ---------------------------------------------------------------------------------------------
+// Headless Console - commands typed into stdin, log output already goes to stdout
+
+static std::mutex                 gHeadlessInputMutex;
+static std::vector< std::string > gHeadlessInput;
+
+
+static void HeadlessConsole_ReadThread()
+{
+	std::string line;
+
+	// Stops on EOF, like when stdin isn't attached to anything, the server keeps running without a console then
+	while ( std::getline( std::cin, line ) )
 	{
-		float maxFps       = glm::clamp( host_fps_max, 10.f, 5000.f );
+		std::unique_lock< std::mutex > lock( gHeadlessInputMutex );
+		gHeadlessInput.push_back( std::move( line ) );
+	}
+}
 
-		// check if we still have more than 2ms till next frame and if so, wait for "1ms"
-		float minFrameTime = 1.0f / maxFps;
-		if ( ( minFrameTime - time ) > ( 2.0f / 1000.f ) )
-			sys_sleep( 1 );
 
-		// framerate is above max
-		if ( time < minFrameTime )
-			return true;
+static void HeadlessConsole_Init()
+{
+	// Detached since a blocking read on stdin can't be interrupted portably, it's cleaned up when the process exits
+	std::thread( HeadlessConsole_ReadThread ).detach();
+}
+
+
+// Queue commands read from stdin, this is on the main thread so commands run in the same place as they do with the ui console
+static void HeadlessConsole_Update()
+{
+	static std::vector< std::string > lines;
+
+	{
+		std::unique_lock< std::mutex > lock( gHeadlessInputMutex );
+		lines.swap( gHeadlessInput );
 	}
 
-	return false;
+	for ( const std::string& line : lines )
+	{
+		if ( line.size() )
+			Con_QueueCommand( line.data(), line.size() );
+	}
+
+	lines.clear();
 }
 
 
@@ -450,7 +550,7 @@ void MainLoop()
 {
 	Log_Msg( "Entering Main Update Loop\n" );
 
-	auto  startTime   = std::chrono::high_resolution_clock::now();
+	auto  startTime   = std::chrono::steady_clock::now();
 	auto  currentTime = startTime;
 	float time        = 0.f;
 
@@ -458,8 +558,8 @@ void MainLoop()
 	{
 		PROF_SCOPE_NAMED( "Main Loop" );
 
-		if ( UpdateFrameTime( startTime, currentTime, time ) )
-			continue;
+		// The client renders every frame, so this only waits on the max fps, the server catches up on ticks in its update
+		UpdateFrameTime( startTime, currentTime, time, startTime );
 
 		// ftl::TaskCounter taskCounter( &gTaskScheduler );
 
@@ -505,16 +605,17 @@ void MainLoopDedicated()
 {
 	Log_Msg( "Entering Main Update Loop for Dedicated Server\n" );
 
-	auto  startTime   = std::chrono::high_resolution_clock::now();
+	auto  startTime   = std::chrono::steady_clock::now();
 	auto  currentTime = startTime;
+	auto  wakeTime    = startTime;
 	float time        = 0.f;
 
 	while ( gRunning )
 	{
 		PROF_SCOPE_NAMED( "Main Loop Dedicated" );
 
-		if ( UpdateFrameTime( startTime, currentTime, time ) )
-			continue;
+		// Nothing happens between server ticks, so sleep until the next one is due
+		UpdateFrameTime( startTime, currentTime, time, wakeTime );
 
 		// ftl::TaskCounter taskCounter( &gTaskScheduler );
 
@@ -562,6 +663,50 @@ void MainLoopDedicated()
 		// gTaskScheduler.WaitForCounter( &taskCounter );
 
 		startTime = currentTime;
+		wakeTime  = GetNextServerTickTime();
+
+#ifdef TRACY_ENABLE
+		FrameMark;
+#endif
+	}
+}
+
+
+void MainLoopHeadless()
+{
+	Log_Msg( "Entering Main Update Loop for Headless Dedicated Server\n" );
+
+	HeadlessConsole_Init();
+
+	auto  startTime   = std::chrono::steady_clock::now();
+	auto  currentTime = startTime;
+	auto  wakeTime    = startTime;
+	float time        = 0.f;
+
+	while ( gRunning )
+	{
+		PROF_SCOPE_NAMED( "Main Loop Headless" );
+
+		// Nothing happens between server ticks, so sleep until the next one is due
+		UpdateFrameTime( startTime, currentTime, time, wakeTime );
+
+		HeadlessConsole_Update();
+
+		Map_UpdateTimer( time );
+
+		float frameTimeScaled = time * host_timescale;
+		gCurrentModule        = ECurrentModule_Server;
+
+		// Update Game Logic
+		server->Update( frameTimeScaled );
+
+		gCurrentModule = ECurrentModule_None;
+
+		Con_Update();
+		Resource_Update();
+
+		startTime = currentTime;
+		wakeTime  = GetNextServerTickTime();
 
 #ifdef TRACY_ENABLE
 		FrameMark;
@@ -586,6 +731,10 @@ extern "C"
 
 		IMGUI_CHECKVERSION();
 
+		// Headless is only a dedicated server without the window
+		if ( gHeadless )
+			gDedicatedServer = true;
+
 		if ( gDedicatedServer )
 			Con_SetDefaultArchive( "cfg" PATH_SEP_STR "config_dedicated.cfg", "cfg" PATH_SEP_STR "config_dedicated_default.cfg" );
 
@@ -607,7 +756,15 @@ extern "C"
 		// Load Systems
 
 		// Load Modules and Initialize them in this order
-		if ( gDedicatedServer )
+		if ( gHeadless )
+		{
+			if ( !Mod_AddSystems( gAppModulesHeadless, ARR_SIZE( gAppModulesHeadless ) ) )
+			{
+				Log_Error( "Failed to Load Systems\n" );
+				return 1;
+			}
+		}
+		else if ( gDedicatedServer )
 		{
 			if ( !Mod_AddSystems( gAppModulesServer, ARR_SIZE( gAppModulesServer ) ) )
 			{
@@ -630,7 +787,7 @@ extern "C"
 			Mod_LoadSystem( steamModule );
 		}
 
-		if ( !CreateMainWindow() )
+		if ( !gHeadless && !CreateMainWindow() )
 		{
 			return 1;
 		}
@@ -640,16 +797,19 @@ extern "C"
 			return 1;
 		}
 
-		// Create the Graphics API Window
-		gGraphicsWindow = render->CreateWindow( gpWindow, gpSysWindow );
-
-		if ( gGraphicsWindow == CH_INVALID_HANDLE )
+		if ( !gHeadless )
 		{
-			Log_Fatal( "Failed to Create GraphicsAPI Window\n" );
-			return 1;
-		}
+			// Create the Graphics API Window
+			gGraphicsWindow = render->CreateWindow( gpWindow, gpSysWindow );
 
-		gui->StyleImGui();
+			if ( gGraphicsWindow == CH_INVALID_HANDLE )
+			{
+				Log_Fatal( "Failed to Create GraphicsAPI Window\n" );
+				return 1;
+			}
+
+			gui->StyleImGui();
+		}
 
 		if ( !LoadGameSystems() )
 		{
@@ -667,14 +827,15 @@ extern "C"
 		// gTaskScheduler.Init( schedOptions );
 
 		// Hack for Dedicated Server For now
-		if ( gDedicatedServer )
+		if ( gDedicatedServer && !gHeadless )
 		{
 			gDedicatedViewport = graphics->CreateViewport();
 		}
 
 		// always only one window
 		// TODO: if we launch the in the toolkit process, move this
-		input->SetCurrentWindow( gpWindow );
+		if ( !gHeadless )
+			input->SetCurrentWindow( gpWindow );
 
 		// IDEA: put autoexec built it again, and just store all convars in a list
 		// Then, when each convar is registered, we check what we read from config.cfg and autoexec.cfg
@@ -686,7 +847,9 @@ extern "C"
 		// ---------------------------------------------------------------------------------------------
 		// Main Loop
 
-		if ( gDedicatedServer )
+		if ( gHeadless )
+			MainLoopHeadless();
+		else if ( gDedicatedServer )
 			MainLoopDedicated();
 		else
 			MainLoop();
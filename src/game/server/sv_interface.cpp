@@ -4,6 +4,7 @@
 #include "testing.h"
 #include "mapmanager.h"
 #include "main.h"
+#include "entity/entity_scheduler.h"
 
 
 class ServerSystem : public IServerSystem
@@ -12,11 +13,14 @@ class ServerSystem : public IServerSystem
 	bool Init() override
 	{
 		// Get Modules
-		CH_GET_SYSTEM( input, IInputSystem, IINPUTSYSTEM_NAME, IINPUTSYSTEM_VER );
+		// Input isn't loaded on a headless server, and the server doesn't use it
+		//CH_GET_SYSTEM( input, IInputSystem, IINPUTSYSTEM_NAME, IINPUTSYSTEM_VER );
 		//CH_GET_SYSTEM( render, IRender, IRENDER_NAME, IRENDER_VER );
 		//CH_GET_SYSTEM( audio, IAudioSystem, IADUIO_NAME, IADUIO_VER );
 		CH_GET_SYSTEM( ch_physics, Ch_IPhysics, IPHYSICS_NAME, IPHYSICS_VER );
-		CH_GET_SYSTEM( graphics, IGraphics, IGRAPHICS_NAME, IGRAPHICS_VER );
+
+		// Graphics isn't loaded on a headless server, it's only used for physics debug drawing here
+		graphics = Mod_GetSystemCast< IGraphics >( IGRAPHICS_NAME, IGRAPHICS_VER );
 		//CH_GET_SYSTEM( gui, IGuiSystem, IGUI_NAME, IGUI_HASH );
 
 		Phys_Init();
@@ -61,16 +65,17 @@ class ServerSystem : public IServerSystem
 		if ( !SV_IsHosting() )
 			return;
 
-		gFrameTime = sDT;
-
-		if ( Game_IsPaused() )
-		{
-			gFrameTime = 0.f;
-		}
+		SV_RunFrame( sDT );
+	}
 
-		gCurTime += gFrameTime;
+	float GetTimeUntilNextTick() override
+	{
+		return SV_GetTimeUntilNextTick();
+	}
 
-		SV_Update( sDT );
+	void SetEntityWorkerCount( u32 sCount ) override
+	{
+		EntSched_SetWorkerCount( sCount );
 	}
 
 	// ----------------------------------------------------------------------------
@@ -101,7 +106,8 @@ class ServerSystem : public IServerSystem
 		if ( !SV_StartServer() )
 			return;
 
-		if ( MapManager_LoadMap( srMap ) )
+		// Entities from the map are created over the next few frames in MapManager_Update()
+		if ( MapManager_LoadMapAsync( srMap ) )
 			return;
 
 		Log_Error( "Failed to Load map - Failed to Start Server\n" );
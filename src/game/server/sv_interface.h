@@ -12,8 +12,14 @@ class IServerSystem : public ISystem
 	virtual void CloseServer()                           = 0;
 
 	virtual void PrintStatus()                           = 0;
+
+	// Game time in seconds until the next server tick, 0 if one is due now or the server ticks every frame
+	virtual float GetTimeUntilNextTick()                 = 0;
+
+	// Amount of worker threads the server can use for entity systems, call before starting a server
+	virtual void  SetEntityWorkerCount( u32 sCount )     = 0;
 };
 
 
 #define ISERVER_NAME "Server"
-#define ISERVER_VER  1
+#define ISERVER_VER  3
@@ -1,4 +1,5 @@
 #include "sv_main.h"
+#include "sv_relevance.h"
 #include "game_shared.h"
 #include "main.h"
 #include "mapmanager.h"
@@ -23,6 +24,14 @@ CONVAR_STRING( sv_server_name, "taco", CVARF_SERVER | CVARF_ARCHIVE, "Server Nam
 CONVAR_FLOAT( sv_client_timeout, 30.f, CVARF_SERVER | CVARF_ARCHIVE );
 CONVAR_BOOL( sv_client_timeout_enable, 1, CVARF_SERVER | CVARF_ARCHIVE );
 CONVAR_BOOL( sv_pause, 0, CVARF_SERVER, "Pauses the Server Code" );
+CONVAR_RANGE_FLOAT( sv_tickrate, 64, 0, 1000, CVARF_SERVER | CVARF_ARCHIVE, "Server ticks per second, 0 to tick once every frame with a variable frame time" );
+CONVAR_RANGE_INT( sv_max_ticks_per_frame, 8, 1, 128, CVARF_SERVER, "Max ticks to run in one frame when catching up, any time past this is dropped" );
+CONVAR_RANGE_FLOAT( sv_usercmd_max_frametime, 0.1, 0.001, 1, CVARF_SERVER, "Max time in seconds a single client command can simulate movement for" );
+CONVAR_RANGE_INT( sv_max_rate, 0, 0, 1073741824, CVARF_SERVER | CVARF_ARCHIVE, "Most bytes per second sent to a client, 0 for no limit" );
+CONVAR_RANGE_INT( sv_min_rate, 16384, 0, 1073741824, CVARF_SERVER | CVARF_ARCHIVE, "Least bytes per second sent to a client, no matter how low their rate is" );
+
+// Most seconds worth of a client's rate that can build up while we have nothing to send them
+constexpr double CH_SV_RATE_BURST = 0.25;
 
 CONVAR_INT_CMD( sv_max_clients, 32, CVARF_SERVER, "Max Clients the Server Allows" )
 {
@@ -79,6 +88,9 @@ ServerData_t        gServerData;
 
 static Socket_t     gServerSocket   = CH_INVALID_SOCKET;
 
+// Datagrams broadcast this tick, sent all at once at the end of SV_Update()
+static NetWriteQueue_t gServerWriteQueue;
+
 static SV_Client_t* gpCommandClient = nullptr;
 
 
@@ -97,21 +109,27 @@ int SV_Client_t::Read( char* spData, int sLen )
 }
 
 
-int SV_Client_t::Write( const char* spData, int sLen )
+int SV_Client_t::Write( const char* spData, int sLen, bool sReliable )
 {
-	return Net_Write( gServerSocket, aAddr, spData, sLen );
+	return NetChannel_Write( aChannel, gServerSocket, aAddr, spData, sLen, sReliable );
 }
 
 
-int SV_Client_t::Write( const ChVector< char >& srData )
+int SV_Client_t::Write( const ChVector< char >& srData, bool sReliable )
 {
-	return Net_Write( gServerSocket, aAddr, srData.begin(), srData.size_bytes() );
+	return NetChannel_Write( aChannel, gServerSocket, aAddr, srData.begin(), srData.size_bytes(), sReliable );
 }
 
 
-int SV_Client_t::WriteFlatBuffer( flatbuffers::FlatBufferBuilder& srBuilder )
+int SV_Client_t::WriteFlatBuffer( flatbuffers::FlatBufferBuilder& srBuilder, bool sReliable )
 {
-	return Net_WriteFlatBuffer( gServerSocket, aAddr, srBuilder );
+	return NetChannel_WriteFlatBuffer( aChannel, gServerSocket, aAddr, srBuilder, sReliable );
+}
+
+
+void SV_Client_t::QueueFlatBuffer( flatbuffers::FlatBufferBuilder& srBuilder, bool sReliable )
+{
+	NetChannel_QueueFlatBuffer( aChannel, gServerWriteQueue, aAddr, srBuilder, sReliable );
 }
 
 
@@ -143,6 +161,107 @@ void SV_Shutdown()
 }
 
 
+// Get the entity and component lists for this client, against the last tick they acknowledged
+// These are only built once per tick for each baseline, falls back to a full update if we can't delta encode against it
+// With entity relevance on or a rate set, every client has their own entities, so they each get their own lists
+static SV_SnapshotMsgs_t* SV_GetSnapshotMsgs( SV_Client_t& srClient )
+{
+	PROF_SCOPE();
+
+	u32             baselineTick = Entity_CanDeltaFrom( srClient.aAckTick ) ? srClient.aAckTick : 0;
+	EntRelevance_t* relevance    = SV_GetRelevance( srClient );
+
+	for ( SV_SnapshotMsgs_t& snapshot : gServerData.aSnapshotMsgs )
+	{
+		if ( snapshot.aBaselineTick == baselineTick && snapshot.apRelevance == relevance )
+			return &snapshot;
+	}
+
+	SV_SnapshotMsgs_t snapshot;
+	snapshot.aBaselineTick   = baselineTick;
+	snapshot.apRelevance     = relevance;
+	snapshot.apEntityList    = &gServerData.aMsgPool.Get();
+	snapshot.apComponentList = &gServerData.aMsgPool.Get();
+
+	if ( relevance )
+	{
+		// Fill up what's left of their rate, at least one entity is always written so everything gets sent eventually
+		u32 rate               = SV_GetClientRate( srClient );
+		relevance->aByteBudget = rate ? std::max( (u32)srClient.aRateBytes, 1u ) : 0;
+
+		// The component list picks which entities fit, so it's built first, and the entity list only has those
+		if ( !SV_BuildServerMsg( *snapshot.apComponentList, EMsgSrc_Server_ComponentList, false, baselineTick, relevance ) )
+			return nullptr;
+
+		if ( !SV_BuildServerMsg( *snapshot.apEntityList, EMsgSrc_Server_EntityList, false, baselineTick, relevance ) )
+			return nullptr;
+
+		SV_RelevanceSent( srClient );
+	}
+	else
+	{
+		if ( !SV_BuildServerMsg( *snapshot.apEntityList, EMsgSrc_Server_EntityList, false, baselineTick, relevance ) )
+			return nullptr;
+
+		if ( !SV_BuildServerMsg( *snapshot.apComponentList, EMsgSrc_Server_ComponentList, false, baselineTick, relevance ) )
+			return nullptr;
+	}
+
+	Log_DevF( gLC_Server, 2, "Built Snapshot for Tick %u against Tick %u: %u bytes\n",
+	          gServerData.aTick, baselineTick, snapshot.apEntityList->GetSize() + snapshot.apComponentList->GetSize() );
+
+	gServerData.aSnapshotMsgs.push_back( snapshot );
+	return &gServerData.aSnapshotMsgs.back();
+}
+
+
+// Tell a client the newest command of theirs we ran this tick, so they can check their prediction against it
+static void SV_BuildUserCmdAck( flatbuffers::FlatBufferBuilder& srBuilder, SV_Client_t& srClient )
+{
+	// Kept around between calls so it holds onto its memory
+	static flatbuffers::FlatBufferBuilder messageBuilder;
+	messageBuilder.Clear();
+
+	messageBuilder.Finish( CreateNetMsg_UserCmdAck( messageBuilder, gServerData.aTick, srClient.aUserCmd.aCommandNumber ) );
+
+	auto                 dataVector = srBuilder.CreateVector( messageBuilder.GetBufferPointer(), messageBuilder.GetSize() );
+
+	MsgSrc_ServerBuilder serverMsg( srBuilder );
+	serverMsg.add_type( EMsgSrc_Server_UserCmdAck );
+	serverMsg.add_data( dataVector );
+
+	srBuilder.Finish( serverMsg.Finish() );
+}
+
+
+// Send everything broadcast this tick, and disconnect any client we failed to write to
+static void SV_FlushWrites()
+{
+	PROF_SCOPE();
+
+	if ( gServerWriteQueue.aPackets.empty() )
+		return;
+
+	Net_FlushWrites( gServerSocket, gServerWriteQueue );
+
+	for ( NetWriteQueue_t::Packet_t& packet : gServerWriteQueue.aPackets )
+	{
+		if ( !packet.aError )
+			continue;
+
+		SV_Client_t* client = SV_GetClientFromAddr( packet.aAddr );
+
+		if ( !client || client->aState == ESV_ClientState_Disconnected )
+			continue;
+
+		Log_ErrorF( gLC_Server, "Failed to write network data to client, marking client as disconnected: %s\n", Net_ErrorString( packet.aError ) );
+		client->aState = ESV_ClientState_Disconnected;
+	}
+
+	gServerWriteQueue.Clear();
+}
+
+
 void SV_Update( float frameTime )
 {
 	PROF_SCOPE();
@@ -152,10 +271,10 @@ void SV_Update( float frameTime )
 
 	Game_SetCommandSource( ECommandSource_Client );
 
-	// for ( auto& client : gServerData.aClients )
-	for ( size_t i = 0; i < gServerData.aClients.size(); i++ )
+	for ( auto it = gServerData.aClients.begin(); it != gServerData.aClients.end(); )
 	{
-		SV_Client_t& client = gServerData.aClients[ i ];
+		// Move on first, freeing the client removes it from the list
+		SV_Client_t& client = *it++;
 
 		// Continue connecting clients if any are joining
 		// if ( client.aState == ESV_ClientState_Connecting )
@@ -172,7 +291,6 @@ void SV_Update( float frameTime )
 
 			// Remove this client from the list
 			SV_FreeClient( client );
-			i--;
 			continue;
 		}
 	}
@@ -182,48 +300,128 @@ void SV_Update( float frameTime )
 	// Main game loop
 	SV_GameUpdate( frameTime );
 
+	// The map failed to load
+	if ( !gServerData.aActive )
+		return;
+
 	// Send updated data to clients
-	std::vector< flatbuffers::FlatBufferBuilder > messages( gReplicatedCmds.size() ? 3 : 2 );
+	// These are kept around so the vectors don't reallocate every tick
+	static std::vector< flatbuffers::FlatBufferBuilder* > messages;
+
+	gServerData.aMsgPool.Reset();
+	gServerData.aSnapshotMsgs.clear();
+	messages.clear();
+
+	gServerData.aTick++;
+	Entity_RecordSnapshot( gServerData.aTick );
 
 	bool msgFailed = false;
-	msgFailed |= !SV_BuildServerMsg( messages[ 0 ], EMsgSrc_Server_EntityList, false );
-	msgFailed |= !SV_BuildServerMsg( messages[ 1 ], EMsgSrc_Server_ComponentList, false );
 
 	if ( gReplicatedCmds.size() )
-		msgFailed |= !SV_BuildServerMsg( messages[ 2 ], EMsgSrc_Server_ConVar, false );
+	{
+		messages.push_back( &gServerData.aMsgPool.Get() );
+		msgFailed |= !SV_BuildServerMsg( *messages.back(), EMsgSrc_Server_ConVar, false );
+	}
+
+	// Clients that want a full update don't get anything delta encoded this tick
+	for ( SV_Client_t* client : gServerData.aClientsFullUpdate )
+	{
+		if ( client )
+			client->aAckTick = 0;
+	}
+
+	SV_UpdateRelevance();
 
 	int writeSize = 0;
 
-	if ( !msgFailed )
-		writeSize = SV_BroadcastMsgs( messages );
+	for ( SV_Client_t& client : gServerData.aClients )
+	{
+		// Kind of a hack
+		if ( msgFailed || ( client.aState != ESV_ClientState_Connected && client.aState != ESV_ClientState_Connecting ) )
+			continue;
+
+		// Refill what we can send them, capped so a client that was idle doesn't get a huge burst
+		u32 rate = SV_GetClientRate( client );
+
+		if ( rate )
+			client.aRateBytes = std::min( client.aRateBytes + rate * (double)frameTime, rate * CH_SV_RATE_BURST );
+
+		int clientWriteSize = 0;
+
+		// Skip the snapshot this tick if they're still over their rate, the next one has everything that changed since their last ack
+		if ( !rate || client.aRateBytes > 0.0 )
+		{
+			SV_SnapshotMsgs_t* snapshot = SV_GetSnapshotMsgs( client );
+
+			if ( !snapshot )
+				continue;
+
+			clientWriteSize = snapshot->apEntityList->GetSize() + snapshot->apComponentList->GetSize();
+
+			// A newer snapshot is sent every tick, so these don't need to be resent
+			client.QueueFlatBuffer( *snapshot->apEntityList, false );
+			client.QueueFlatBuffer( *snapshot->apComponentList, false );
+		}
+
+		// Sent after the component list, so the client has the state this goes with by the time it reads it
+		if ( client.aUserCmd.aCommandNumber )
+		{
+			flatbuffers::FlatBufferBuilder& ackMsg = gServerData.aMsgPool.Get();
+			SV_BuildUserCmdAck( ackMsg, client );
+
+			clientWriteSize += ackMsg.GetSize();
+			client.QueueFlatBuffer( ackMsg, false );
+		}
+
+		for ( flatbuffers::FlatBufferBuilder* message : messages )
+		{
+			clientWriteSize += message->GetSize();
+			client.QueueFlatBuffer( *message );
+		}
+
+		if ( rate )
+			client.aRateBytes -= clientWriteSize;
+
+		writeSize = std::max( writeSize, clientWriteSize );
+	}
 
 	// Check to see if anyone needs a full update
 	if ( gServerData.aClientsFullUpdate.size() )
 	{
-		// Build a Full Update and send it to all of them
-		std::vector< flatbuffers::FlatBufferBuilder > messages( 3 );
-		bool                                          msgFailed = false;
-
-		msgFailed |= !SV_BuildServerMsg( messages[ 0 ], EMsgSrc_Server_EntityList, true );
-		msgFailed |= !SV_BuildServerMsg( messages[ 1 ], EMsgSrc_Server_ComponentList, true );
-		msgFailed |= !SV_BuildServerMsg( messages[ 2 ], EMsgSrc_Server_ConVar, true );
+		// They already got every entity and component above, so they only need every replicated convar now
+		flatbuffers::FlatBufferBuilder& convarMsg = gServerData.aMsgPool.Get();
 
 		int fullUpdateSize = 0;
 
-		if ( !msgFailed )
-			fullUpdateSize = SV_BroadcastMsgsToSpecificClients( messages, gServerData.aClientsFullUpdate );
+		if ( SV_BuildServerMsg( convarMsg, EMsgSrc_Server_ConVar, true ) )
+			fullUpdateSize = SV_BroadcastMsgsToSpecificClients( { &convarMsg }, gServerData.aClientsFullUpdate );
 
 		Log_DevF( gLC_Server, 1, "Writing Full Update to Clients: %d bytes\n", fullUpdateSize );
 
 		gServerData.aClientsFullUpdate.clear();
 	}
 
+	// Resend reliable messages clients haven't acked yet
+	for ( SV_Client_t& client : gServerData.aClients )
+	{
+		if ( client.aState == ESV_ClientState_Disconnected )
+			continue;
+
+		if ( !NetChannel_QueueResend( client.aChannel, gServerWriteQueue, client.aAddr ) )
+		{
+			Log_WarnF( gLC_Server, "Too many reliable messages waiting on client, marking client as disconnected: \"%s\"\n", client.name.c_str() );
+			client.aState = ESV_ClientState_Disconnected;
+		}
+	}
+
+	SV_FlushWrites();
+
 	// Update Entity and Component States after everything is processed
 	Entity_UpdateStates();
 
 	// if ( Game_IsClient() )
 	{
-		Log_DevF( gLC_Server, 2, "Data Written to Each Client: %d bytes", writeSize );
+		Log_DevF( gLC_Server, 2, "Most Data Written to a Client: %d bytes", writeSize );
 	}
 
 	gReplicatedCmds.clear();
@@ -232,6 +430,80 @@ void SV_Update( float frameTime )
 }
 
 
+static void SV_RunTick( float sFrameTime )
+{
+	gFrameTime = Game_IsPaused() ? 0.f : sFrameTime;
+	gCurTime += gFrameTime;
+
+	SV_Update( sFrameTime );
+}
+
+
+float SV_GetTickInterval()
+{
+	if ( sv_tickrate <= 0.f )
+		return 0.f;
+
+	return 1.f / sv_tickrate;
+}
+
+
+float SV_GetTimeUntilNextTick()
+{
+	float tickInterval = SV_GetTickInterval();
+
+	if ( tickInterval <= 0.f || !gServerData.aActive )
+		return 0.f;
+
+	return std::max( 0.f, static_cast< float >( tickInterval - gServerData.aTickAccumulator ) );
+}
+
+
+void SV_RunFrame( float sFrameTime )
+{
+	PROF_SCOPE();
+
+	float tickInterval = SV_GetTickInterval();
+
+	if ( tickInterval <= 0.f )
+	{
+		SV_RunTick( sFrameTime );
+		return;
+	}
+
+	gServerData.aTickAccumulator += sFrameTime;
+
+	int ticks = 0;
+
+	while ( gServerData.aTickAccumulator >= tickInterval )
+	{
+		// Don't spiral trying to catch up if ticks take longer than the tick interval
+		if ( ticks == sv_max_ticks_per_frame )
+		{
+			Log_DevF( gLC_Server, 1, "Server is running behind, dropping %.4f seconds\n", gServerData.aTickAccumulator );
+			gServerData.aTickAccumulator = 0.0;
+			break;
+		}
+
+		gServerData.aTickAccumulator -= tickInterval;
+		SV_RunTick( tickInterval );
+		ticks++;
+
+		// A tick can stop the server
+		if ( !gServerData.aActive )
+			break;
+	}
+}
+
+
+// Spawn points and collision don't exist until the map is done loading
+static bool SV_IsMapLoading()
+{
+	EMapLoadState state = MapManager_GetLoadState();
+	return state == EMapLoadState_Parsing || state == EMapLoadState_Creating;
+}
+
+
 void SV_GameUpdate( float frameTime )
 {
 	PROF_SCOPE();
@@ -240,18 +512,32 @@ void SV_GameUpdate( float frameTime )
 
 	MapManager_Update();
 
+	if ( MapManager_GetLoadState() == EMapLoadState_Failed )
+	{
+		Log_Error( gLC_Server, "Failed to Load map - Stopping Server\n" );
+		SV_StopServer();
+		return;
+	}
+
+	// Don't run players or physics on a half created world, they would fall through it
+	if ( SV_IsMapLoading() )
+	{
+		Entity_UpdateSystems();
+		return;
+	}
+
+	for ( SV_Client_t& client : gServerData.aClients )
+	{
+		if ( client.aWaitingForMap )
+			SV_ConnectClientFinish( client );
+	}
+
+	// Players step their own character for every command they run
 	players.Update( frameTime );
 
 	Phys_Simulate( GetPhysEnv(), frameTime );
 
 	Entity_UpdateSystems();
-
-	// Update player positions after physics simulation
-	// NOTE: This probably needs to be done for everything with physics
-	for ( auto& player : players.aEntities )
-	{
-		players.apMove->UpdatePosition( player );
-	}
 }
 
 
@@ -278,7 +564,9 @@ bool SV_StartServer()
 
 	players.Init();
 
-	gServerData.aActive = true;
+	gServerData.aActive          = true;
+	gServerData.aTick            = 0;
+	gServerData.aTickAccumulator = 0.0;
 	return true;
 }
 
@@ -298,6 +586,17 @@ void SV_StopServer()
 
 	gServerData.aActive = false;
 	gServerData.aClients.clear();
+	gServerData.aClientIDs.clear();
+	gServerData.aClientToIDs.clear();
+	gServerData.aClientAddrs.clear();
+
+	gServerData.aSnapshotMsgs.clear();
+	gServerData.aMsgPool.Free();
+	gServerData.aTick            = 0;
+	gServerData.aTickAccumulator = 0.0;
+
+	gServerWriteQueue.Clear();
+	Net_ClearFragments();
 
 	Net_CloseSocket( gServerSocket );
 	gServerSocket = CH_INVALID_SOCKET;
@@ -310,11 +609,42 @@ bool SV_IsHosting()
 }
 
 
+// --------------------------------------------------------------------
+// Message Builder Pool
+
+
+flatbuffers::FlatBufferBuilder& SV_MsgBuilderPool_t::Get()
+{
+	if ( aUsed == aBuilders.size() )
+		aBuilders.push_back( new flatbuffers::FlatBufferBuilder( CH_SV_MSG_BUILDER_SIZE ) );
+
+	flatbuffers::FlatBufferBuilder* builder = aBuilders[ aUsed++ ];
+	builder->Clear();
+	return *builder;
+}
+
+
+void SV_MsgBuilderPool_t::Reset()
+{
+	aUsed = 0;
+}
+
+
+void SV_MsgBuilderPool_t::Free()
+{
+	for ( flatbuffers::FlatBufferBuilder* builder : aBuilders )
+		delete builder;
+
+	aBuilders.clear();
+	aUsed = 0;
+}
+
+
 // --------------------------------------------------------------------
 // Networking
 
 
-int SV_BroadcastMsgsToSpecificClients( std::vector< flatbuffers::FlatBufferBuilder >& srMessages, const ChVector< SV_Client_t* >& srClients )
+int SV_BroadcastMsgsToSpecificClients( const std::vector< flatbuffers::FlatBufferBuilder* >& srMessages, const ChVector< SV_Client_t* >& srClients )
 {
 	PROF_SCOPE();
 
@@ -322,7 +652,7 @@ int SV_BroadcastMsgsToSpecificClients( std::vector< flatbuffers::FlatBufferBuild
 
 	for ( size_t i = 0; i < srMessages.size(); i++ )
 	{
-		writeSize += srMessages[ i ].GetSize();
+		writeSize += srMessages[ i ]->GetSize();
 	}
 
 	for ( auto client : srClients )
@@ -334,25 +664,16 @@ int SV_BroadcastMsgsToSpecificClients( std::vector< flatbuffers::FlatBufferBuild
 		if ( client->aState != ESV_ClientState_Connected && client->aState != ESV_ClientState_Connecting )
 			continue;
 
+		// Sent at the end of the tick, SV_FlushWrites() disconnects them if this fails
 		for ( size_t arrayIndex = 0; arrayIndex < srMessages.size(); arrayIndex++ )
-		{
-			int write = client->WriteFlatBuffer( srMessages[ arrayIndex ] );
-
-			// If we failed to write, disconnect them?
-			if ( write == 0 )
-			{
-				Log_ErrorF( gLC_Server, "Failed to write network data to client, marking client as disconnected: %s\n", Net_ErrorString() );
-				client->aState = ESV_ClientState_Disconnected;
-				break;
-			}
-		}
+			client->QueueFlatBuffer( *srMessages[ arrayIndex ] );
 	}
 
 	return writeSize;
 }
 
 
-int SV_BroadcastMsgs( std::vector< flatbuffers::FlatBufferBuilder >& srMessages )
+int SV_BroadcastMsgs( const std::vector< flatbuffers::FlatBufferBuilder* >& srMessages )
 {
 	PROF_SCOPE();
 
@@ -360,7 +681,7 @@ int SV_BroadcastMsgs( std::vector< flatbuffers::FlatBufferBuilder >& srMessages
 
 	for ( size_t i = 0; i < srMessages.size(); i++ )
 	{
-		writeSize += srMessages[ i ].GetSize();
+		writeSize += srMessages[ i ]->GetSize();
 	}
 
 	for ( auto& client : gServerData.aClients )
@@ -369,18 +690,9 @@ int SV_BroadcastMsgs( std::vector< flatbuffers::FlatBufferBuilder >& srMessages
 		if ( client.aState != ESV_ClientState_Connected && client.aState != ESV_ClientState_Connecting )
 			continue;
 
+		// Sent at the end of the tick, SV_FlushWrites() disconnects them if this fails
 		for ( size_t arrayIndex = 0; arrayIndex < srMessages.size(); arrayIndex++ )
-		{
-			int write = client.WriteFlatBuffer( srMessages[ arrayIndex ] );
-
-			// If we failed to write, disconnect them?
-			if ( write == 0 )
-			{
-				Log_ErrorF( gLC_Server, "Failed to write network data to client, marking client as disconnected: %s\n", Net_ErrorString() );
-				client.aState = ESV_ClientState_Disconnected;
-				break;
-			}
-		}
+			client.QueueFlatBuffer( *srMessages[ arrayIndex ] );
 	}
 
 	return writeSize;
@@ -397,14 +709,8 @@ int SV_BroadcastMsg( flatbuffers::FlatBufferBuilder& srMessage )
 		if ( client.aState != ESV_ClientState_Connected && client.aState != ESV_ClientState_Connecting )
 			continue;
 
-		int write = client.WriteFlatBuffer( srMessage );
-
-		// If we failed to write, disconnect them?
-		if ( write == 0 )
-		{
-			Log_ErrorF( gLC_Server, "Failed to write network data to client, marking client as disconnected: %s\n", Net_ErrorString() );
-			client.aState = ESV_ClientState_Disconnected;
-		}
+		// Sent at the end of the tick, SV_FlushWrites() disconnects them if this fails
+		client.QueueFlatBuffer( srMessage );
 	}
 
 	return srMessage.GetSize();
@@ -424,12 +730,16 @@ void SV_BuildServerInfo( flatbuffers::FlatBufferBuilder& srMessage )
 }
 
 
-bool SV_BuildServerMsg( flatbuffers::FlatBufferBuilder& srBuilder, EMsgSrc_Server sSrcType, bool sFullUpdate )
+bool SV_BuildServerMsg( flatbuffers::FlatBufferBuilder& srBuilder, EMsgSrc_Server sSrcType, bool sFullUpdate, u32 sBaselineTick, EntRelevance_t* spRelevance )
 {
 	PROF_SCOPE();
 
-	flatbuffers::FlatBufferBuilder messageBuilder;
-	bool                           wroteData = false;
+	// The inner message is built here first, then copied into srBuilder
+	// Kept around between calls so it holds onto its memory
+	static flatbuffers::FlatBufferBuilder messageBuilder( CH_SV_MSG_BUILDER_SIZE );
+	messageBuilder.Clear();
+
+	bool wroteData = false;
 
 	switch ( sSrcType )
 	{
@@ -461,14 +771,14 @@ bool SV_BuildServerMsg( flatbuffers::FlatBufferBuilder& srBuilder, EMsgSrc_Serve
 		}
 		case EMsgSrc_Server_EntityList:
 		{
-			Entity_WriteEntityUpdates( messageBuilder );
+			Entity_WriteEntityUpdates( messageBuilder, gServerData.aTick, sFullUpdate ? 0 : sBaselineTick, spRelevance );
 			wroteData = true;
 			//Log_DevF( gLC_Server, 2, "Sending ENTITY_LIST to Clients\n" );
 			break;
 		}
 		case EMsgSrc_Server_ComponentList:
 		{
-			Entity_WriteComponentUpdates( messageBuilder, sFullUpdate );
+			Entity_WriteComponentUpdates( messageBuilder, gServerData.aTick, sFullUpdate ? 0 : sBaselineTick, spRelevance );
 			wroteData = true;
 			//Log_DevF( gLC_Server, 2, "Sending COMPONENT_LIST to Clients\n" );
 			break;
@@ -541,7 +851,7 @@ void SV_BuildUpdatedData( bool sFullUpdate )
 
 bool SV_SendMessageToClient( SV_Client_t& srClient, flatbuffers::FlatBufferBuilder& srMessage )
 {
-	int write = Net_WriteFlatBuffer( gServerSocket, srClient.aAddr, srMessage );
+	int write = srClient.WriteFlatBuffer( srMessage );
 
 	if ( write < 1 )
 	{
@@ -578,6 +888,56 @@ void SV_HandleMsg_ClientInfo( SV_Client_t& srClient, const NetMsg_ClientInfo* sp
 		srClient.name = spMessage->name()->str();
 
 	srClient.aSteamID = spMessage->steam_id();
+	srClient.aRate    = spMessage->rate();
+}
+
+
+u32 SV_GetClientRate( const SV_Client_t& srClient )
+{
+	u32 maxRate = std::max( (int)sv_max_rate, 0 );
+	u32 minRate = std::max( (int)sv_min_rate, 0 );
+	u32 rate    = srClient.aRate;
+
+	if ( maxRate && ( rate == 0 || rate > maxRate ) )
+		rate = maxRate;
+
+	if ( rate && rate < minRate )
+		rate = minRate;
+
+	return rate;
+}
+
+
+static void SV_QueueUserCmd( SV_Client_t& srClient, const NetMsg_UserCmd* spMessage )
+{
+	if ( !spMessage )
+		return;
+
+	// Already queued or run this one, backups are sent again with every new command
+	if ( spMessage->command_number() <= srClient.aLastCommandNumber )
+		return;
+
+	UserCmd_t userCmd{};
+
+	NetHelper_ReadVec3( spMessage->angles(), userCmd.aAng );
+
+	userCmd.aButtons       = spMessage->buttons();
+	userCmd.aFlashlight    = spMessage->flashlight();
+	userCmd.aMoveType      = static_cast< EPlayerMoveType >( spMessage->move_type() );
+	userCmd.aCommandNumber = spMessage->command_number();
+
+	// Don't let a client simulate more time than it should, a NaN fails this and ends up as 0
+	float frameTime        = spMessage->frame_time();
+	userCmd.aFrameTime     = frameTime > 0.f ? glm::min( frameTime, sv_usercmd_max_frametime ) : 0.f;
+
+	if ( srClient.aUserCmdQueue.size() >= CH_USERCMD_QUEUE_SIZE )
+	{
+		Log_DevF( gLC_Server, 1, "UserCmd queue full for client \"%s\", dropping command %u\n", srClient.name.c_str(), srClient.aUserCmdQueue.front().aCommandNumber );
+		srClient.aUserCmdQueue.pop_front();
+	}
+
+	srClient.aUserCmdQueue.push_back( userCmd );
+	srClient.aLastCommandNumber = userCmd.aCommandNumber;
 }
 
 
@@ -588,27 +948,30 @@ void SV_HandleMsg_UserCmd( SV_Client_t& srClient, const NetMsg_UserCmd* spMessag
 
 	//Log_DevF( gLC_Server, 2, "Handling Message USER_CMD from Client \"%s\"\n", srClient.name.c_str() );
 
-	NetHelper_ReadVec3( spMessage->angles(), srClient.aUserCmd.aAng );
+	// Backups are oldest first, so any we missed are queued before the new command
+	if ( auto backup = spMessage->backup() )
+	{
+		for ( const NetMsg_UserCmd* backupCmd : *backup )
+			SV_QueueUserCmd( srClient, backupCmd );
+	}
 
-	srClient.aUserCmd.aButtons    = spMessage->buttons();
-	srClient.aUserCmd.aFlashlight = spMessage->flashlight();
-	srClient.aUserCmd.aMoveType   = static_cast< EPlayerMoveType >( spMessage->move_type() );
+	SV_QueueUserCmd( srClient, spMessage );
+
+	// Ignore ticks we haven't sent yet, and older acks arriving out of order
+	u32 ackTick = spMessage->snapshot_ack();
+
+	if ( ackTick <= gServerData.aTick && ackTick > srClient.aAckTick )
+		srClient.aAckTick = ackTick;
 }
 
 
 SV_Client_t* SV_GetClientFromAddr( ch_sockaddr& srAddr )
 {
-	for ( auto& client : gServerData.aClients )
-	{
-		// if ( client.aAddr.sa_data == clientAddr.sa_data && client.aAddr.sa_family == clientAddr.sa_family )
-		// if ( memcmp( client.aAddr.sa_data, clientAddr.sa_data ) == 0 && client.aAddr.sa_family == clientAddr.sa_family )
-		if ( memcmp( client.aAddr.sa_data, srAddr.sa_data, sizeof( client.aAddr.sa_data ) ) == 0 )
-		{
-			return &client;
-		}
-	}
+	auto it = gServerData.aClientAddrs.find( srAddr );
+	if ( it == gServerData.aClientAddrs.end() )
+		return nullptr;
 
-	return nullptr;
+	return SV_GetClient( it->second );
 }
 
 
@@ -627,43 +990,71 @@ inline const T* SV_ReadMsg( EMsgSrc_Client sMsgType, flatbuffers::Verifier& srVe
 }
 
 
+static void SV_ReadClientMsg( SV_Client_t& srClient, const char* spData, int sLen )
+{
+	flatbuffers::Verifier verifyMsg( reinterpret_cast< const u8* >( spData ), sLen );
+	const MsgSrc_Client*  clientMsg = flatbuffers::GetRoot< MsgSrc_Client >( spData );
+
+	if ( !clientMsg->Verify( verifyMsg ) )
+	{
+		Log_Warn( gLC_Server, "Message Data is not Valid\n" );
+		return;
+	}
+
+	// Read the message sent from the client
+	SV_ProcessClientMsg( srClient, clientMsg );
+}
+
+
 void SV_ProcessSocketMsgs()
 {
 	PROF_SCOPE();
 
+	// Kept around so we don't allocate the packets every tick
+	static NetReadBatch_t batch;
+
 	while ( true )
 	{
-		ChVector< char > data( 8192 );
-		ch_sockaddr      clientAddr;
-		int              len = Net_Read( gServerSocket, data.data(), data.size(), &clientAddr );
+		int count = Net_ReadBatch( gServerSocket, batch );
 
-		if ( len <= 0 )
+		if ( count <= 0 )
 			return;
 
-		data.resize( len );
+		for ( int i = 0; i < count; i++ )
+		{
+			NetPacket_t& packet = batch.aPackets[ i ];
 
-		SV_Client_t* client = SV_GetClientFromAddr( clientAddr );
+			if ( packet.aLen <= 0 )
+				continue;
 
-		if ( !client )
-		{
-			SV_ConnectClient( clientAddr, data );
-			continue;
-		}
+			// Wait until we have every fragment of the message
+			int         msgLen = 0;
+			const char* msg    = Net_ReadMessage( packet.aAddr, packet.aData, packet.aLen, msgLen );
 
-		// Reset the connection timer
-		client->aTimeout = Game_GetCurTime() + sv_client_timeout;
+			if ( !msg || msgLen <= 0 )
+				continue;
 
-		flatbuffers::Verifier verifyMsg( reinterpret_cast< u8* >( data.data() ), data.size_bytes() );
-		const MsgSrc_Client* clientMsg = flatbuffers::GetRoot< MsgSrc_Client >( data.data() );
+			SV_Client_t* client = SV_GetClientFromAddr( packet.aAddr );
 
-		if ( !clientMsg->Verify( verifyMsg ) )
-		{
-			Log_Warn( gLC_Server, "Message Data is not Valid\n" );
-			continue;
+			if ( !client )
+			{
+				SV_ConnectClient( packet.aAddr, msg, msgLen );
+				continue;
+			}
+
+			// Reset the connection timer
+			client->aTimeout = Game_GetCurTime() + sv_client_timeout;
+
+			// Reliable messages that were waiting on this one come with it
+			NetChannel_Read( client->aChannel, msg, msgLen, [ client ]( const char* spData, int sLen )
+			{
+				SV_ReadClientMsg( *client, spData, sLen );
+			} );
 		}
 
-		// Read the message sent from the client
-		SV_ProcessClientMsg( *client, clientMsg );
+		// Nothing else is waiting if the batch wasn't filled
+		if ( count < CH_NET_BATCH_COUNT )
+			return;
 	}
 }
 
@@ -753,7 +1144,7 @@ void SV_ProcessClientMsg( SV_Client_t& srClient, const MsgSrc_Client* spMessage
 				if ( srClient.aState == ESV_ClientState_WaitForClientInfo )
 				{
 					// Add the playerInfo Component
-					void* playerInfo = Entity_AddComponent( srClient.aEntity, "playerInfo" );
+					CPlayerInfo* playerInfo = Ent_AddComponent< CPlayerInfo >( srClient.aEntity );
 
 					if ( playerInfo == nullptr )
 					{
@@ -814,11 +1205,14 @@ void SV_ProcessClientMsg( SV_Client_t& srClient, const MsgSrc_Client* spMessage
 }
 
 
-SV_Client_t* SV_AllocateClient()
+SV_Client_t* SV_AllocateClient( ch_sockaddr& srAddr )
 {
 	if ( gServerData.aClients.size() >= sv_max_clients )
 		return nullptr;
 
+	if ( gServerData.aClientAddrs.find( srAddr ) != gServerData.aClientAddrs.end() )
+		return nullptr;
+
 	// Allocate a new client
 	SV_Client_t&   client = gServerData.aClients.emplace_back();
 
@@ -837,6 +1231,9 @@ SV_Client_t* SV_AllocateClient()
 	// Add it to the resource list to allow for changing indexes and max clients
 	gServerData.aClientIDs[ handle ]    = &client;
 	gServerData.aClientToIDs[ &client ] = handle;
+	gServerData.aClientAddrs[ srAddr ]  = handle;
+
+	client.aAddr                        = srAddr;
 
 	return &client;
 }
@@ -850,19 +1247,21 @@ void SV_FreeClient( SV_Client_t& srClient )
 		return;
 
 	gServerData.aClientIDs.erase( it->second );
+	gServerData.aClientAddrs.erase( srClient.aAddr );
 	gServerData.aClientToIDs.erase( it );
 
+	// Don't leave pointers to it around
+	gServerData.aClientsConnecting.erase( &srClient );
+	gServerData.aClientsFullUpdate.erase( &srClient );
+
 	// Remove this client from the list
-	auto clientIT = std::find( gServerData.aClients.begin(), gServerData.aClients.end(), srClient );
-	if ( clientIT != gServerData.aClients.end() )
+	auto clientIT = std::find_if( gServerData.aClients.begin(), gServerData.aClients.end(), [ & ]( const SV_Client_t& client )
 	{
-		size_t index = clientIT - gServerData.aClients.begin();
+		return &client == &srClient;
+	} );
 
-		if ( index != SIZE_MAX )
-			vec_remove_index( gServerData.aClients, index );
-		else
-			Log_Msg( "um\n" );
-	}
+	if ( clientIT != gServerData.aClients.end() )
+		gServerData.aClients.erase( clientIT );
 }
 
 
@@ -874,12 +1273,20 @@ void SV_ConnectClientFinish( SV_Client_t& srClient )
 		return;
 	}
 
+	// Finish this in SV_GameUpdate() once the map is loaded, so they don't spawn before the spawn points exist
+	if ( SV_IsMapLoading() )
+	{
+		srClient.aWaitingForMap = true;
+		return;
+	}
+
 	if ( srClient.aSteamID && IsSteamLoaded() )
 	{
 		steam->RequestProfileName( srClient.aSteamID );
 	}
 
-	srClient.aState = ESV_ClientState_Connected;
+	srClient.aWaitingForMap = false;
+	srClient.aState         = ESV_ClientState_Connected;
 
 	gServerData.aClientsConnecting.erase( &srClient );
 	
@@ -901,15 +1308,34 @@ void SV_ConnectClientFinish( SV_Client_t& srClient )
 }
 
 
-void SV_ConnectClient( ch_sockaddr& srAddr, ChVector< char >& srData )
+void SV_ConnectClient( ch_sockaddr& srAddr, const char* spData, int sLen )
 {
 	PROF_SCOPE();
 
+	// Connection requests come through a channel like everything else, so our reply can be sent reliably
+	// This channel is copied to them if we accept them
+	static NetChannel_t channel;
+	const char*         connectData = nullptr;
+	int                 connectLen  = 0;
+
+	NetChannel_Reset( channel );
+	NetChannel_Read( channel, spData, sLen, [ & ]( const char* spMsg, int sMsgLen )
+	{
+		if ( !connectData )
+		{
+			connectData = spMsg;
+			connectLen  = sMsgLen;
+		}
+	} );
+
+	if ( !connectData )
+		return;
+
 	// Get Client Info
 	//NetMsg_ClientConnect       msgClientConnect();
 
-	flatbuffers::Verifier       verifyMsg( (u8*)srData.data(), srData.size() );
-	const NetMsg_ClientConnect* clientMsg = flatbuffers::GetRoot< NetMsg_ClientConnect >( srData.data() );
+	flatbuffers::Verifier       verifyMsg( (const u8*)connectData, connectLen );
+	const NetMsg_ClientConnect* clientMsg = flatbuffers::GetRoot< NetMsg_ClientConnect >( connectData );
 
 	// This is invalid for some reason?
 	// if ( !clientMsg->Verify( verifyMsg ) );
@@ -941,7 +1367,7 @@ void SV_ConnectClient( ch_sockaddr& srAddr, ChVector< char >& srData )
 	}
 
 	// Add them to the client list for the playerInfo component
-	SV_Client_t* client = SV_AllocateClient();
+	SV_Client_t* client = SV_AllocateClient( srAddr );
 
 	if ( !client )
 	{
@@ -950,9 +1376,9 @@ void SV_ConnectClient( ch_sockaddr& srAddr, ChVector< char >& srData )
 		return;
 	}
 
-	client->aAddr   = srAddr;
-	client->aState  = ESV_ClientState_WaitForClientInfo;
-	client->aEntity = entity;
+	client->aState   = ESV_ClientState_WaitForClientInfo;
+	client->aEntity  = entity;
+	client->aChannel = channel;
 
 	Log_MsgF( gLC_Server, "Connecting Client: \"%s\"\n", Net_AddrToString( srAddr ) );
 
@@ -990,7 +1416,7 @@ void SV_ConnectClient( ch_sockaddr& srAddr, ChVector< char >& srData )
 	// SV_BuildServerMsg( builders[ 1 ], EMsgSrc_Server_ServerInfo, true );
 
 	// send them this information on the listen socket, and with the port, the client and switch to that one for their connection
-	int write = Net_WriteFlatBuffer( gServerSocket, srAddr, builders[ 0 ] );
+	int write = client->WriteFlatBuffer( builders[ 0 ] );
 
 	if ( write > 0 )
 	{
@@ -1124,10 +1550,10 @@ SV_Client_t* SV_GetClientFromEntity( Entity sEntity )
 
 Entity SV_GetPlayerEntFromIndex( size_t sIndex )
 {
-	if ( gServerData.aClients.empty() || sIndex > gServerData.aClients.size() )
+	if ( sIndex >= gServerData.aClients.size() )
 		return CH_ENT_INVALID;
 
-	return gServerData.aClients[ sIndex ].aEntity;
+	return std::next( gServerData.aClients.begin(), sIndex )->aEntity;
 }
 
 
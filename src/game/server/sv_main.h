@@ -5,6 +5,8 @@
 #include "entity/entity.h"
 #include "network/net_main.h"
 
+#include <list>
+
 // 
 // The Server, only runs if the engine is a dedicated server, or hosting on the client
 // 
@@ -18,6 +20,12 @@ constexpr ClientHandle_t CH_MAX_CLIENTS    = 32;
 // Invalid ClientHandle_t
 constexpr ClientHandle_t CH_INVALID_CLIENT = 0;
 
+// Starting size of message builders, enough for most ticks so they don't need to grow
+constexpr size_t         CH_SV_MSG_BUILDER_SIZE = 16384;
+
+// Amount of recent ticks we remember the entities written to a client on
+constexpr u32            CH_SV_SENT_HISTORY     = 64;
+
 
 using SteamID64_t = u64;
 
@@ -33,6 +41,14 @@ enum ESVClientState
 };
 
 
+// Entities written to a client on a tick
+struct SV_SentEnts_t
+{
+	u32                   aTick = 0;
+	std::vector< Entity > aEntities;
+};
+
+
 struct SV_Client_t
 {
 	ch_sockaddr    aAddr;
@@ -42,17 +58,60 @@ struct SV_Client_t
 	std::string    name    = "[unnamed]";
 	ESVClientState aState;
 
+	// They finished connecting while the map was still loading, they're spawned once it's done
+	bool           aWaitingForMap = false;
+
 	double         aTimeout;
 
 	Entity         aEntity = CH_ENT_INVALID;
 
-	UserCmd_t      aUserCmd;
+	// The command being run, or the last one run, things outside of movement like the view and zoom read from this
+	UserCmd_t      aUserCmd{};
+
+	// Commands received that haven't been run yet, in command number order, each one is run once
+	std::deque< UserCmd_t > aUserCmdQueue;
+
+	// Highest command number queued, anything at or below this is a backup we already have
+	u32            aLastCommandNumber = 0;
+
+	// Seconds of movement their commands can still run, refilled by server time every tick
+	// Stops a client from running more time than has passed on the server by sending lots of commands
+	float          aUserCmdTime       = 0.f;
+
+	// Last server tick this client applied entity and component updates from, 0 if none
+	// Updates sent to this client only have what changed after this tick
+	u32            aAckTick = 0;
+
+	// Entities near this client that they are sent, see sv_relevance.h
+	EntRelevance_t aRelevance;
+
+	// This client is sent their own entity and component lists, instead of the ones shared by every client
+	bool           aRelevanceActive  = false;
+
+	// Tick their own lists were turned off on, they keep getting them until they acknowledge it
+	u32            aRelevanceOffTick = 0;
+
+	// [Tick % CH_SV_SENT_HISTORY] = Entities written to this client on that tick
+	std::vector< SV_SentEnts_t > aSentEnts;
+
+	// Most bytes per second this client asked for, 0 for no limit
+	u32            aRate      = 0;
+
+	// Bytes we can still send this client, refilled by their rate every tick and used up by what we send them
+	double         aRateBytes = 0.0;
+
+	// Sequencing, acks and resending reliable messages, everything to and from this client goes through this
+	NetChannel_t   aChannel;
 
 	int            Read( char* spData, int sLen );
 
-	int            Write( const char* spData, int sLen );
-	int            Write( const ChVector< char >& srData );
-	int            WriteFlatBuffer( flatbuffers::FlatBufferBuilder& srBuilder );
+	// Messages are sent reliably unless they're sent again every tick anyway, like entity and component updates
+	int            Write( const char* spData, int sLen, bool sReliable = true );
+	int            Write( const ChVector< char >& srData, bool sReliable = true );
+	int            WriteFlatBuffer( flatbuffers::FlatBufferBuilder& srBuilder, bool sReliable = true );
+
+	// Queue a message to be sent at the end of the tick
+	void           QueueFlatBuffer( flatbuffers::FlatBufferBuilder& srBuilder, bool sReliable = true );
 
 	bool           operator==( const SV_Client_t& srOther )
 	{
@@ -85,22 +144,68 @@ struct SV_Client_t
 };
 
 
+// Flatbuffer builders that are reused every tick
+// Builders are cleared instead of freed, so they keep their memory and building messages stops allocating after the first few ticks
+struct SV_MsgBuilderPool_t
+{
+	std::vector< flatbuffers::FlatBufferBuilder* > aBuilders;
+	size_t                                         aUsed = 0;
+
+	// Get a cleared builder from the pool, valid until Reset() is called
+	flatbuffers::FlatBufferBuilder&                Get();
+
+	// Give every builder back to the pool
+	void                                           Reset();
+
+	// Free all builders
+	void                                           Free();
+};
+
+
+// Entity and component lists written this tick against one baseline tick
+// Shared by every client that acknowledged the same tick, so they are only built once
+// Unless entity relevance is on, then each client has their own
+struct SV_SnapshotMsgs_t
+{
+	u32                             aBaselineTick;
+	EntRelevance_t*                 apRelevance;
+	flatbuffers::FlatBufferBuilder* apEntityList;
+	flatbuffers::FlatBufferBuilder* apComponentList;
+};
+
+
 struct ServerData_t
 {
 	bool                                               aActive;
 
-	std::vector< SV_Client_t >                         aClients;
+	// A list so client pointers stay valid when other clients join or leave
+	std::list< SV_Client_t >                           aClients;
 
 	// Fixed handles to a client, so the indexes can easily change
 	// This also allows you to change max clients live in game
 	std::unordered_map< ClientHandle_t, SV_Client_t* > aClientIDs;
 	std::unordered_map< SV_Client_t*, ClientHandle_t > aClientToIDs;
 
+	// Address each client sends from, so finding who sent a packet doesn't go through every client
+	std::unordered_map< ch_sockaddr, ClientHandle_t >  aClientAddrs;
+
 	// Clients that are still connecting
 	ChVector< SV_Client_t* >                           aClientsConnecting;
 
 	// Clients that want a full update
 	ChVector< SV_Client_t* >                           aClientsFullUpdate;
+
+	// Builders for the messages sent out each tick
+	SV_MsgBuilderPool_t                                aMsgPool;
+
+	// Current server tick, counts up from 1 every update, 0 is used for a full update
+	u32                                                aTick = 0;
+
+	// Frame time left over that wasn't enough for a full tick, carried into the next frame
+	double                                             aTickAccumulator = 0.0;
+
+	// Entity and component lists built this tick, one for each baseline tick clients acknowledged
+	std::vector< SV_SnapshotMsgs_t >                   aSnapshotMsgs;
 };
 
 // --------------------------------------------------------------------
@@ -110,6 +215,15 @@ void                SV_Shutdown();
 void                SV_Update( float frameTime );
 void                SV_GameUpdate( float frameTime );
 
+// Run as many fixed length ticks as fit in this frame time, or one tick with the frame time if sv_tickrate is 0
+void                SV_RunFrame( float sFrameTime );
+
+// Length of a tick in seconds, 0 if the server ticks every frame
+float               SV_GetTickInterval();
+
+// Game time in seconds until the next tick runs, 0 if one is due now or the server ticks every frame
+float               SV_GetTimeUntilNextTick();
+
 bool                SV_StartServer();
 void                SV_StopServer();
 bool                SV_IsHosting();
@@ -117,22 +231,25 @@ bool                SV_IsHosting();
 // --------------------------------------------------------------------
 // Networking
 
-int                 SV_BroadcastMsgsToSpecificClients( std::vector< flatbuffers::FlatBufferBuilder >& srMessages, const ChVector< SV_Client_t* >& srClients );
-int                 SV_BroadcastMsgs( std::vector< flatbuffers::FlatBufferBuilder >& srMessages );
+int                 SV_BroadcastMsgsToSpecificClients( const std::vector< flatbuffers::FlatBufferBuilder* >& srMessages, const ChVector< SV_Client_t* >& srClients );
+int                 SV_BroadcastMsgs( const std::vector< flatbuffers::FlatBufferBuilder* >& srMessages );
 int                 SV_BroadcastMsg( flatbuffers::FlatBufferBuilder& srMessage );
 
 bool                SV_SendMessageToClient( SV_Client_t& srClient, flatbuffers::FlatBufferBuilder& srMessage );
 void                SV_SendDisconnect( SV_Client_t& srClient );
 
-bool                SV_BuildServerMsg( flatbuffers::FlatBufferBuilder& srMessage, EMsgSrc_Server sSrcType, bool sFullUpdate = false );
+// sBaselineTick is only used for the entity and component lists, they have what changed after that tick, or everything if it's 0
+// spRelevance limits the entity and component lists to the entities in it
+bool                SV_BuildServerMsg( flatbuffers::FlatBufferBuilder& srMessage, EMsgSrc_Server sSrcType, bool sFullUpdate = false, u32 sBaselineTick = 0, EntRelevance_t* spRelevance = nullptr );
 
 void                SV_ProcessSocketMsgs();
 void                SV_ProcessClientMsg( SV_Client_t& srClient, const MsgSrc_Client* spMessage );
 
-SV_Client_t*        SV_AllocateClient();
+// Returns nullptr if the server is full or a client already has this address
+SV_Client_t*        SV_AllocateClient( ch_sockaddr& srAddr );
 void                SV_FreeClient( SV_Client_t& srClient );
 
-void                SV_ConnectClient( ch_sockaddr& srAddr, ChVector< char >& srData );
+void                SV_ConnectClient( ch_sockaddr& srAddr, const char* spData, int sLen );
 void                SV_ConnectClientFinish( SV_Client_t& srClient );
 
 // void                SV_SendConVar( std::string_view sName, const std::vector< std::string >& srArgs );
@@ -150,6 +267,10 @@ SV_Client_t*        SV_GetCommandClient();
 
 Entity              SV_GetCommandClientEntity();
 SV_Client_t*        SV_GetClientFromEntity( Entity sEntity );
+SV_Client_t*        SV_GetClientFromAddr( ch_sockaddr& srAddr );
+
+// Bytes per second we send this client, their rate clamped between sv_min_rate and sv_max_rate, 0 for no limit
+u32                 SV_GetClientRate( const SV_Client_t& srClient );
 
 Entity              SV_GetPlayerEntFromIndex( size_t sIndex );
 Entity              SV_GetPlayerEnt( ClientHandle_t sClient );
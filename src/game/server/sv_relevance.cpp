@@ -0,0 +1,417 @@
+#include "sv_relevance.h"
+#include "entity/entity.h"
+
+#include <algorithm>
+
+
+LOG_CHANNEL( Server );
+
+
+CONVAR_BOOL( sv_relevance, 0, CVARF_SERVER, "Only send clients the entities near their player" );
+CONVAR_RANGE_FLOAT( sv_relevance_dist, 150, 1, 100000, CVARF_SERVER | CVARF_ARCHIVE, "Distance from a client's player that entities are sent within, scaled by the network priority of their components" );
+
+
+// Entities a client already has can go this much further out before they are removed,
+// so anything sitting right on the edge doesn't keep getting removed and sent again
+constexpr float CH_SV_RELEVANCE_LEAVE_SCALE = 1.25f;
+
+// Entities that had nothing to send the last time they were written build up priority this much slower
+// They still get written now and then, so their parent stays up to date on the client
+constexpr float CH_SV_PRIORITY_IDLE_SCALE   = 0.25f;
+
+
+// What the relevance checks need for an entity, gathered once per tick and shared by every client
+struct SV_RelevanceEnt_t
+{
+	glm::vec3 aPos;
+	float     aPriority       = 0.f;
+	bool      aAlwaysRelevant = false;
+
+	// SV_UpdateClientRelevance() pass this was last found relevant on
+	u32       aRelevantPass   = 0;
+
+	// How fast this builds up priority for the client being updated, from 1 at the edge of their range to 2 right next to them
+	float     aWeight         = 1.f;
+};
+
+
+// [Entity] = Relevance Info, only valid for entities in gSvRelevanceList
+static std::vector< SV_RelevanceEnt_t > gSvRelevanceEnts;
+
+// Networked entities that exist this tick
+static std::vector< Entity >            gSvRelevanceList;
+
+// Entities found relevant for the client being updated, kept around so it doesn't allocate every tick
+static std::vector< Entity >            gSvRelevantEnts;
+
+static u32                              gSvRelevancePass    = 0;
+
+// sv_relevance was on last tick
+static bool                             gSvRelevanceOn      = false;
+
+
+static void SV_GatherRelevanceEnts()
+{
+	PROF_SCOPE();
+
+	gSvRelevanceEnts.resize( CH_MAX_ENTITIES );
+	gSvRelevanceList.clear();
+
+	for ( auto& [ entity, flags ] : EntSysData().aEntityFlags )
+	{
+		if ( ( flags & EEntityFlag_Destroyed ) || !Entity_IsNetworked( entity, flags ) )
+			continue;
+
+		SV_RelevanceEnt_t&         ent   = gSvRelevanceEnts[ entity ];
+		const EntWorldTransform_t* world = Entity_GetCachedWorldTransform( entity );
+
+		ent.aPriority       = 0.f;
+		ent.aAlwaysRelevant = flags & EEntityFlag_AlwaysRelevant;
+
+		// We can't tell how far away something without a position is
+		if ( world && world->aValid )
+			ent.aPos = world->aMatrix[ 3 ];
+		else
+			ent.aAlwaysRelevant = true;
+
+		gSvRelevanceList.push_back( entity );
+	}
+
+	for ( auto& [ poolName, pool ] : EntSysData().aComponentPools )
+	{
+		EntComponentData_t* regData = pool->GetRegistryData();
+
+		if ( regData->aNetType != EEntComponentNetType_Both )
+			continue;
+
+		for ( size_t compIndex = 0; compIndex < pool->GetCount(); compIndex++ )
+		{
+			if ( pool->aDenseFlags[ compIndex ] & ( EEntityFlag_Local | EEntityFlag_Destroyed ) )
+				continue;
+
+			SV_RelevanceEnt_t& ent = gSvRelevanceEnts[ pool->aDenseEntities[ compIndex ] ];
+			ent.aPriority          = std::max( ent.aPriority, regData->aNetPriority );
+
+			if ( regData->aFlags & ECompRegFlag_AlwaysRelevant )
+				ent.aAlwaysRelevant = true;
+		}
+	}
+}
+
+
+// Start sending this entity to the client
+static void SV_EnterRelevance( EntRelevance_t& srRelevance, Entity sEntity, u32 sTick, u32 sAckedTick )
+{
+	EntRelevantEnt_t& relevant = srRelevance.aEntities[ sEntity ];
+
+	// It came back before the client acknowledged it leaving
+	if ( relevant.aLeftTick )
+		vec_remove( srRelevance.aLeft, sEntity );
+
+	relevant              = {};
+	relevant.aRelevant    = true;
+	relevant.aEnteredTick = sTick;
+	relevant.aAckedTick   = sAckedTick;
+
+	srRelevance.aRelevant.push_back( sEntity );
+}
+
+
+// The client has everything written to them on the tick they acknowledged
+static void SV_ApplyRelevanceAck( SV_Client_t& srClient )
+{
+	EntRelevance_t& relevance = srClient.aRelevance;
+	u32             ackTick   = srClient.aAckTick;
+
+	// They want everything again
+	if ( ackTick == 0 )
+	{
+		for ( Entity entity : relevance.aRelevant )
+			relevance.aEntities[ entity ].aAckedTick = 0;
+
+		return;
+	}
+
+	// The client removed these on their end already
+	for ( size_t i = 0; i < relevance.aLeft.size(); )
+	{
+		EntRelevantEnt_t& left = relevance.aEntities[ relevance.aLeft[ i ] ];
+
+		if ( left.aLeftTick > ackTick )
+		{
+			i++;
+			continue;
+		}
+
+		left.aLeftTick       = 0;
+		relevance.aLeft[ i ] = relevance.aLeft.back();
+		relevance.aLeft.pop_back();
+	}
+
+	if ( srClient.aSentEnts.empty() )
+		return;
+
+	SV_SentEnts_t& sent = srClient.aSentEnts[ ackTick % CH_SV_SENT_HISTORY ];
+
+	// Too old, we don't remember what was in it anymore
+	if ( sent.aTick != ackTick )
+		return;
+
+	for ( Entity entity : sent.aEntities )
+	{
+		// Skip entities that left and came back since then, the client may have removed them
+		if ( !relevance.IsRelevant( entity ) )
+			continue;
+
+		EntRelevantEnt_t& relevant = relevance.aEntities[ entity ];
+
+		if ( relevant.aEnteredTick > ackTick )
+			continue;
+
+		relevant.aAckedTick = std::max( relevant.aAckedTick, ackTick );
+	}
+}
+
+
+// If sAll is set, every entity is relevant to this client
+static void SV_UpdateClientRelevance( SV_Client_t& srClient, bool sAll )
+{
+	PROF_SCOPE();
+
+	EntRelevance_t& relevance = srClient.aRelevance;
+	u32             tick      = gServerData.aTick;
+
+	relevance.aEntities.resize( CH_MAX_ENTITIES );
+
+	SV_ApplyRelevanceAck( srClient );
+
+	// Until the client has a player, we don't know where they are, so send them everything
+	const EntWorldTransform_t* view      = nullptr;
+
+	if ( srClient.aEntity != CH_ENT_INVALID )
+		view = Entity_GetCachedWorldTransform( srClient.aEntity );
+
+	bool      hasOrigin = !sAll && view && view->aValid;
+	glm::vec3 origin    = hasOrigin ? glm::vec3( view->aMatrix[ 3 ] ) : glm::vec3( 0.f );
+
+	gSvRelevancePass++;
+	gSvRelevantEnts.clear();
+
+	for ( Entity entity : gSvRelevanceList )
+	{
+		SV_RelevanceEnt_t& ent    = gSvRelevanceEnts[ entity ];
+		float              weight = 1.f;
+
+		if ( hasOrigin && !ent.aAlwaysRelevant )
+		{
+			float range = sv_relevance_dist * ent.aPriority;
+			float dist  = range;
+
+			if ( relevance.aEntities[ entity ].aRelevant )
+				dist *= CH_SV_RELEVANCE_LEAVE_SCALE;
+
+			glm::vec3 offset = ent.aPos - origin;
+			float     distSq = glm::dot( offset, offset );
+
+			if ( distSq > dist * dist )
+				continue;
+
+			weight = 2.f - glm::clamp( std::sqrt( distSq ) / range, 0.f, 1.f );
+		}
+
+		// The client needs the parents to attach this to
+		for ( Entity parent = entity; parent != CH_ENT_INVALID; parent = Entity_GetParent( parent ) )
+		{
+			SV_RelevanceEnt_t& parentEnt = gSvRelevanceEnts[ parent ];
+
+			if ( parentEnt.aRelevantPass == gSvRelevancePass )
+				break;
+
+			parentEnt.aRelevantPass = gSvRelevancePass;
+			parentEnt.aWeight       = 1.f;
+			gSvRelevantEnts.push_back( parent );
+		}
+
+		ent.aWeight = weight;
+	}
+
+	relevance.aSendOrder.clear();
+
+	for ( Entity entity : gSvRelevantEnts )
+	{
+		if ( !relevance.aEntities[ entity ].aRelevant )
+			SV_EnterRelevance( relevance, entity, tick, 0 );
+
+		EntRelevantEnt_t&        relevant = relevance.aEntities[ entity ];
+		const SV_RelevanceEnt_t& ent      = gSvRelevanceEnts[ entity ];
+		float                    priority = ( ent.aPriority > 0.f ? ent.aPriority : 1.f ) * ent.aWeight;
+
+		if ( relevant.aIdle )
+			priority *= CH_SV_PRIORITY_IDLE_SCALE;
+
+		relevant.aPriority += priority;
+		relevance.aSendOrder.push_back( entity );
+	}
+
+	for ( size_t i = 0; i < relevance.aRelevant.size(); )
+	{
+		Entity entity = relevance.aRelevant[ i ];
+
+		if ( gSvRelevanceEnts[ entity ].aRelevantPass == gSvRelevancePass )
+		{
+			i++;
+			continue;
+		}
+
+		EntRelevantEnt_t& relevant = relevance.aEntities[ entity ];
+		relevant.aRelevant         = false;
+
+		// Destroyed entities are removed on the client through the snapshot history instead
+		auto flags = EntSysData().aEntityFlags.find( entity );
+		if ( flags != EntSysData().aEntityFlags.end() && !( flags->second & EEntityFlag_Destroyed ) )
+		{
+			relevant.aLeftTick = tick;
+			relevance.aLeft.push_back( entity );
+		}
+
+		relevance.aRelevant[ i ] = relevance.aRelevant.back();
+		relevance.aRelevant.pop_back();
+	}
+
+	relevance.aAlwaysSend = relevance.IsRelevant( srClient.aEntity ) ? srClient.aEntity : CH_ENT_INVALID;
+
+	// The client's own entity goes first, then entities they don't have yet, then whatever has waited the longest
+	Entity                  alwaysSend = relevance.aAlwaysSend;
+	const EntRelevantEnt_t* ents       = relevance.aEntities.data();
+
+	std::sort( relevance.aSendOrder.begin(), relevance.aSendOrder.end(), [ alwaysSend, ents ]( Entity sA, Entity sB )
+	{
+		if ( ( sA == alwaysSend ) != ( sB == alwaysSend ) )
+			return sA == alwaysSend;
+
+		const EntRelevantEnt_t& a = ents[ sA ];
+		const EntRelevantEnt_t& b = ents[ sB ];
+
+		if ( ( a.aAckedTick == 0 ) != ( b.aAckedTick == 0 ) )
+			return a.aAckedTick == 0;
+
+		return a.aPriority > b.aPriority;
+	} );
+}
+
+
+void SV_UpdateRelevance()
+{
+	PROF_SCOPE();
+
+	bool enabled = sv_relevance;
+
+	if ( enabled != gSvRelevanceOn )
+	{
+		Log_DevF( gLC_Server, 1, "%s Entity Relevance\n", enabled ? "Enabled" : "Disabled" );
+		gSvRelevanceOn = enabled;
+	}
+
+	bool gathered = false;
+
+	for ( SV_Client_t& client : gServerData.aClients )
+	{
+		if ( client.aState != ESV_ClientState_Connected && client.aState != ESV_ClientState_Connecting )
+			continue;
+
+		// Rate limited clients need their own lists too, so we can pick what goes in them
+		bool wantOwnLists = gSvRelevanceOn || SV_GetClientRate( client );
+
+		if ( wantOwnLists || client.aRelevanceActive || SV_GetRelevance( client ) )
+		{
+			if ( !gathered )
+			{
+				SV_GatherRelevanceEnts();
+				gathered = true;
+			}
+		}
+
+		if ( wantOwnLists && !client.aRelevanceActive )
+		{
+			client.aRelevanceActive  = true;
+			client.aRelevanceOffTick = 0;
+
+			// The client already has every entity up to the tick they acknowledged, the ones out of range get removed below
+			if ( client.aAckTick )
+			{
+				client.aRelevance.aEntities.resize( CH_MAX_ENTITIES );
+
+				for ( Entity entity : gSvRelevanceList )
+				{
+					if ( !client.aRelevance.aEntities[ entity ].aRelevant )
+						SV_EnterRelevance( client.aRelevance, entity, 0, client.aAckTick );
+				}
+			}
+		}
+		else if ( !wantOwnLists && client.aRelevanceActive )
+		{
+			// Keep sending them their own lists with every entity in them, until they acknowledge a tick that has everything
+			client.aRelevanceActive  = false;
+			client.aRelevanceOffTick = gServerData.aTick;
+		}
+
+		if ( !SV_GetRelevance( client ) )
+		{
+			EntRelevance_t& relevance = client.aRelevance;
+
+			// Only reset what's in use, this runs every tick for every client when relevance is off
+			for ( Entity entity : relevance.aRelevant )
+				relevance.aEntities[ entity ] = {};
+
+			for ( Entity entity : relevance.aLeft )
+				relevance.aEntities[ entity ] = {};
+
+			relevance.aRelevant.clear();
+			relevance.aLeft.clear();
+			relevance.aSendOrder.clear();
+			client.aSentEnts.clear();
+			continue;
+		}
+
+		SV_UpdateClientRelevance( client, !gSvRelevanceOn || !client.aRelevanceActive );
+	}
+}
+
+
+EntRelevance_t* SV_GetRelevance( SV_Client_t& srClient )
+{
+	if ( srClient.aRelevanceActive )
+		return &srClient.aRelevance;
+
+	// Keep sending this client their own lists until they have every entity
+	if ( srClient.aRelevanceOffTick && srClient.aAckTick < srClient.aRelevanceOffTick )
+		return &srClient.aRelevance;
+
+	return nullptr;
+}
+
+
+void SV_RelevanceSent( SV_Client_t& srClient )
+{
+	PROF_SCOPE();
+
+	EntRelevance_t& relevance = srClient.aRelevance;
+
+	if ( srClient.aSentEnts.empty() )
+		srClient.aSentEnts.resize( CH_SV_SENT_HISTORY );
+
+	SV_SentEnts_t& sent = srClient.aSentEnts[ gServerData.aTick % CH_SV_SENT_HISTORY ];
+	sent.aTick          = gServerData.aTick;
+	sent.aEntities.clear();
+
+	u32 count = std::min< u32 >( relevance.aSendCount, relevance.aSendOrder.size() );
+
+	for ( u32 i = 0; i < count; i++ )
+	{
+		Entity entity = relevance.aSendOrder[ i ];
+		sent.aEntities.push_back( entity );
+
+		if ( relevance.IsRelevant( entity ) )
+			relevance.aEntities[ entity ].aPriority = 0.f;
+	}
+}
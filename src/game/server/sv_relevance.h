@@ -0,0 +1,22 @@
+#pragma once
+
+#include "sv_main.h"
+
+//
+// Area of Interest, each client is only sent the entities near their player
+// Entities are relevant within sv_relevance_dist of the client's player entity, scaled by the highest network priority of their components
+// Entities with EEntityFlag_AlwaysRelevant or a component with ECompRegFlag_AlwaysRelevant are sent to everyone
+//
+// Every relevant entity builds up priority each tick it isn't written, faster the closer it is and the higher its network priority is
+// When a client's rate limits how much we can send them, the entities with the most priority are written first
+//
+
+
+// Update the entities each client is sent, call once per tick after Entity_RecordSnapshot()
+void            SV_UpdateRelevance();
+
+// Get the entities this client is sent, returns nullptr if they get the lists shared by every client
+EntRelevance_t* SV_GetRelevance( SV_Client_t& srClient );
+
+// Call after writing this client their own entity and component lists, resets the priority of the entities written
+void            SV_RelevanceSent( SV_Client_t& srClient );
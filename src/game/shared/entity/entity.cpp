@@ -5,6 +5,7 @@
 #include "player.h"  // TEMP - for CPlayerMoveData
 
 #include "entity_systems.h"
+#include "entity_scheduler.h"
 #include "mapmanager.h"
 #include "igui.h"
 
@@ -216,8 +217,10 @@ void EntComp_ResetVarDirty( char* spData, EEntNetField sVarType )
 
 	if ( offset )
 	{
-		bool* aIsDirty = reinterpret_cast< bool* >( spData + offset );
-		*aIsDirty      = false;
+		bool* aIsDirty    = reinterpret_cast< bool* >( spData + offset );
+		u8*   aDirtyLanes = reinterpret_cast< u8* >( spData + offset + 1 );
+		*aIsDirty         = false;
+		*aDirtyLanes      = 0;
 	}
 }
 
@@ -345,6 +348,7 @@ bool Entity_Init()
 	EntSysData().aActive = true;
 	EntSysData().aEntityPool.clear();
 	EntSysData().aComponentPools.clear();
+	EntSysData().aComponentPoolsByID.clear();
 	EntSysData().aEntityIDConvert.clear();
 
 	// Initialize the queue with all possible entity IDs
@@ -355,7 +359,12 @@ bool Entity_Init()
 	for ( Entity entity = CH_MAX_ENTITIES - 1, index = 0; entity > 0; --entity, ++index )
 		EntSysData().aEntityPool[ index ] = entity;
 
+	EntSysData().aHierarchy.assign( CH_MAX_ENTITIES, {} );
+	EntSysData().aWorldTransforms.assign( CH_MAX_ENTITIES, {} );
+	EntSysData().aWorldTransformsDirty.clear();
+
 	Entity_CreateComponentPools();
+	EntSched_Init();
 
 	return true;
 }
@@ -367,6 +376,8 @@ void Entity_Shutdown()
 
 	EntSysData().aActive = false;
 
+	EntSched_Shutdown();
+
 	// Mark all entities as destroyed
 	for ( auto& [ entity, flags ] : EntSysData().aEntityFlags )
 	{
@@ -399,7 +410,16 @@ void Entity_Shutdown()
 
 	EntSysData().aEntityPool.clear();
 	EntSysData().aComponentPools.clear();
+	EntSysData().aComponentPoolsByID.clear();
 	EntSysData().aEntityIDConvert.clear();
+
+	// These point to the pools we just freed
+	EntSysData().aSnapshots.clear();
+	EntSysData().aSnapshotLostTick = 0;
+
+	EntSysData().aHierarchy.clear();
+	EntSysData().aWorldTransforms.clear();
+	EntSysData().aWorldTransformsDirty.clear();
 }
 
 
@@ -407,11 +427,11 @@ void Entity_UpdateSystems()
 {
 	PROF_SCOPE();
 
-	for ( auto& [ name, pool ] : EntSysData().aComponentPools )
-	{
-		if ( pool->apComponentSystem )
-			pool->apComponentSystem->Update();
-	}
+	// Systems read these across worker threads, so they're rebuilt here on the main thread first
+	// The scheduler rebuilds them again between batches once a system like physics moves anything
+	Entity_UpdateWorldTransforms();
+
+	EntSched_UpdateSystems();
 }
 
 
@@ -475,6 +495,15 @@ void Entity_CreateComponentPool( const char* spName )
 		
 	EntSysData().aComponentPools[ spName ] = pool;
 
+	// Also store it by type ID for typed lookups
+	EntCompTypeID typeID = pool->apData->aTypeID;
+	CH_ASSERT( typeID != CH_ENT_COMP_TYPE_INVALID );
+
+	if ( typeID >= EntSysData().aComponentPoolsByID.size() )
+		EntSysData().aComponentPoolsByID.resize( typeID + 1, nullptr );
+
+	EntSysData().aComponentPoolsByID[ typeID ] = pool;
+
 	// Create component system if it has one registered for it
 	if ( !pool->apData->apSystem )
 		return;
@@ -485,6 +514,7 @@ void Entity_CreateComponentPool( const char* spName )
 	{
 		pool->apComponentSystem->apPool                                                 = pool;
 		EntSysData().aComponentSystems[ typeid( pool->apComponentSystem ).hash_code() ] = pool->apComponentSystem;
+		EntSched_Invalidate();
 	}
 	else
 	{
@@ -509,6 +539,82 @@ IEntityComponentSystem* Entity_GetComponentSystem( const char* spName )
 }
 
 
+// ===================================================================================
+// Entity Hierarchy
+// ===================================================================================
+
+
+static void Entity_UnlinkParent( EntitySystemData& srData, Entity sEntity )
+{
+	EntHierarchy_t& node = srData.aHierarchy[ sEntity ];
+
+	if ( node.aParent == CH_ENT_INVALID )
+		return;
+
+	if ( node.aPrevSibling != CH_ENT_INVALID )
+		srData.aHierarchy[ node.aPrevSibling ].aNextSibling = node.aNextSibling;
+	else
+		srData.aHierarchy[ node.aParent ].aFirstChild = node.aNextSibling;
+
+	if ( node.aNextSibling != CH_ENT_INVALID )
+		srData.aHierarchy[ node.aNextSibling ].aPrevSibling = node.aPrevSibling;
+
+	node.aParent      = CH_ENT_INVALID;
+	node.aNextSibling = CH_ENT_INVALID;
+	node.aPrevSibling = CH_ENT_INVALID;
+}
+
+
+static void Entity_LinkParent( EntitySystemData& srData, Entity sEntity, Entity sParent )
+{
+	EntHierarchy_t& node   = srData.aHierarchy[ sEntity ];
+	EntHierarchy_t& parent = srData.aHierarchy[ sParent ];
+
+	node.aParent           = sParent;
+	node.aPrevSibling      = CH_ENT_INVALID;
+	node.aNextSibling      = parent.aFirstChild;
+
+	if ( parent.aFirstChild != CH_ENT_INVALID )
+		srData.aHierarchy[ parent.aFirstChild ].aPrevSibling = sEntity;
+
+	parent.aFirstChild = sEntity;
+}
+
+
+// Remove a destroyed entity from the hierarchy, and clear its cached world matrix so a new entity with this ID starts fresh
+static void Entity_UnlinkEntity( Entity sEntity )
+{
+	EntitySystemData& data = EntSysData();
+
+	if ( sEntity >= data.aHierarchy.size() )
+		return;
+
+	Entity_UnlinkParent( data, sEntity );
+
+	// Anything still attached to this falls back to world space
+	Entity child = data.aHierarchy[ sEntity ].aFirstChild;
+
+	while ( child != CH_ENT_INVALID )
+	{
+		Entity next = data.aHierarchy[ child ].aNextSibling;
+
+		data.aHierarchy[ child ].aParent      = CH_ENT_INVALID;
+		data.aHierarchy[ child ].aNextSibling = CH_ENT_INVALID;
+		data.aHierarchy[ child ].aPrevSibling = CH_ENT_INVALID;
+		data.aWorldTransformsDirty.push_back( child );
+
+		auto it = data.aEntityFlags.find( child );
+		if ( it != data.aEntityFlags.end() )
+			it->second &= ~EEntityFlag_Parented;
+
+		child = next;
+	}
+
+	data.aHierarchy[ sEntity ]       = {};
+	data.aWorldTransforms[ sEntity ] = {};
+}
+
+
 Entity Entity_CreateEntity( bool sLocal )
 {
 	PROF_SCOPE();
@@ -606,6 +712,8 @@ void Entity_DeleteQueuedEntities()
 
 		EntSysData().aEntityFlags.erase( entity );
 
+		Entity_UnlinkEntity( entity );
+
 		Log_DevF( gLC_Entity, 2, "Destroyed Entity %zd\n", entity );
 	}
 }
@@ -633,28 +741,45 @@ void Entity_ParentEntity( Entity sSelf, Entity sParent )
 	if ( sSelf == CH_ENT_INVALID || sSelf == sParent )
 		return;
 
-	if ( sParent == CH_ENT_INVALID )
+	EntitySystemData& data = EntSysData();
+
+	if ( CH_IF_ASSERT_MSG( sSelf < data.aHierarchy.size() && ( sParent == CH_ENT_INVALID || sParent < data.aHierarchy.size() ), "Entity out of range" ) )
+		return;
+
+	// Parenting to something under us would make a loop
+	for ( Entity parent = sParent; parent != CH_ENT_INVALID; parent = data.aHierarchy[ parent ].aParent )
 	{
-		// Clear the parent
-		EntSysData().aEntityFlags[ sSelf ] |= EEntityFlag_Parented;
-		EntSysData().aEntityParents.erase( sSelf );
+		if ( parent == sSelf )
+		{
+			Log_ErrorF( gLC_Entity, "Can't parent entity %zd to %zd, it's already parented to it\n", sSelf, sParent );
+			return;
+		}
 	}
+
+	Entity_UnlinkParent( data, sSelf );
+
+	if ( sParent != CH_ENT_INVALID )
+		Entity_LinkParent( data, sSelf, sParent );
+
+	Entity_MarkWorldTransformDirty( sSelf );
+
+	auto it = data.aEntityFlags.find( sSelf );
+	if ( it == data.aEntityFlags.end() )
+		return;
+
+	if ( sParent == CH_ENT_INVALID )
+		it->second &= ~EEntityFlag_Parented;
 	else
-	{
-		EntSysData().aEntityParents[ sSelf ] = sParent;
-		EntSysData().aEntityFlags[ sSelf ] &= ~EEntityFlag_Parented;
-	}
+		it->second |= EEntityFlag_Parented;
 }
 
 
 Entity Entity_GetParent( Entity sSelf )
 {
-	auto it = EntSysData().aEntityParents.find( sSelf );
-
-	if ( it != EntSysData().aEntityParents.end() )
-		return it->second;
+	if ( sSelf >= EntSysData().aHierarchy.size() )
+		return CH_ENT_INVALID;
 
-	return CH_ENT_INVALID;
+	return EntSysData().aHierarchy[ sSelf ].aParent;
 }
 
 
@@ -674,58 +799,259 @@ Entity Entity_GetRootParent( Entity sSelf )
 {
 	PROF_SCOPE();
 
-	auto it = EntSysData().aEntityParents.find( sSelf );
+	Entity parent = Entity_GetParent( sSelf );
 
-	if ( it != EntSysData().aEntityParents.end() )
-		return Entity_GetRootParent( it->second );
+	while ( parent != CH_ENT_INVALID )
+	{
+		sSelf  = parent;
+		parent = EntSysData().aHierarchy[ sSelf ].aParent;
+	}
 
 	return sSelf;
 }
 
 
-// Recursively get all entities attached to this one (SLOW)
+// Get the entities directly attached to this one
+void Entity_GetChildren( Entity sEntity, ChVector< Entity >& srChildren )
+{
+	EntitySystemData& data = EntSysData();
+
+	if ( sEntity >= data.aHierarchy.size() )
+		return;
+
+	for ( Entity child = data.aHierarchy[ sEntity ].aFirstChild; child != CH_ENT_INVALID; child = data.aHierarchy[ child ].aNextSibling )
+		srChildren.push_back( child );
+}
+
+
+// Recursively get all entities attached to this one, parents are always added before their children
 void Entity_GetChildrenRecurse( Entity sEntity, ChVector< Entity >& srChildren )
 {
 	PROF_SCOPE();
 
-#pragma message( "could probably speed up GetChildrenRecurse() by instead iterating through aEntityParents, and checking the value for each one" )
+	EntitySystemData& data = EntSysData();
+
+	if ( sEntity >= data.aHierarchy.size() )
+		return;
+
+	// Everything added after this is under sEntity, so walk the output as a queue instead of recursing
+	size_t start = srChildren.size();
+	Entity_GetChildren( sEntity, srChildren );
+
+	for ( size_t i = start; i < srChildren.size(); i++ )
+		Entity_GetChildren( srChildren[ i ], srChildren );
+}
+
+
+// ===================================================================================
+// World Transforms
+// ===================================================================================
+
+
+static glm::mat4 Entity_GetLocalMatrix( const CTransform& srTransform )
+{
+	// NOTE: THIS IS PROBABLY WRONG
+	glm::mat4 matrix = glm::translate( srTransform.aPos.Get() );
+
+	matrix *= glm::eulerAngleZYX(
+	  glm::radians( srTransform.aAng.Get()[ ROLL ] ),
+	  glm::radians( srTransform.aAng.Get()[ YAW ] ),
+	  glm::radians( srTransform.aAng.Get()[ PITCH ] ) );
+
+	return glm::scale( matrix, srTransform.aScale.Get() );
+}
+
+
+// Was this cached matrix built from this transform and parent, with nothing changed since? Doesn't check the parent's matrix
+static bool Entity_WorldTransformMatches( const EntWorldTransform_t& srWorld, Entity sParent, const CTransform* spTransform )
+{
+	if ( srWorld.aVersion == 0 || srWorld.aParent != sParent )
+		return false;
+
+	if ( !spTransform )
+		return !srWorld.aHasTransform;
+
+	return srWorld.aHasTransform && !spTransform->aWorldDirty;
+}
+
+
+// Is the cached matrix for this entity still correct? Checks everything up the parent chain, but doesn't build any matrices
+static bool Entity_IsWorldTransformCurrent( EntitySystemData& srData, Entity sEntity, EntityComponentPool* spTransformPool )
+{
+	while ( sEntity != CH_ENT_INVALID )
+	{
+		const EntWorldTransform_t& world     = srData.aWorldTransforms[ sEntity ];
+		Entity                     parent    = srData.aHierarchy[ sEntity ].aParent;
+		auto                       transform = static_cast< const CTransform* >( spTransformPool->GetData( sEntity ) );
+
+		if ( !Entity_WorldTransformMatches( world, parent, transform ) )
+			return false;
+
+		if ( parent != CH_ENT_INVALID && srData.aWorldTransforms[ parent ].aVersion != world.aParentVersion )
+			return false;
+
+		sEntity = parent;
+	}
+
+	return true;
+}
+
+
+// The parent has to be built first
+static void Entity_BuildWorldTransform( EntitySystemData& srData, Entity sEntity, EntityComponentPool* spTransformPool )
+{
+	EntWorldTransform_t& world     = srData.aWorldTransforms[ sEntity ];
+	Entity               parent    = srData.aHierarchy[ sEntity ].aParent;
+	auto                 transform = static_cast< CTransform* >( spTransformPool->GetData( sEntity ) );
+
+	glm::mat4            parentMat( 1.f );
+	world.aParentVersion = 0;
+
+	if ( parent != CH_ENT_INVALID )
+	{
+		parentMat            = srData.aWorldTransforms[ parent ].aMatrix;
+		world.aParentVersion = srData.aWorldTransforms[ parent ].aVersion;
+	}
+
+	// 0 means it was never built
+	if ( ++srData.aWorldTransformVersion == 0 )
+		srData.aWorldTransformVersion++;
+
+	world.aParent       = parent;
+	world.aVersion      = srData.aWorldTransformVersion;
+	world.aBuiltPass    = srData.aWorldTransformPass;
+	world.aHasTransform = transform != nullptr;
+
+	if ( !transform )
+	{
+		// Fallback to the parent world matrix
+		world.aMatrix = parentMat;
+		world.aValid  = parent != CH_ENT_INVALID;
+		return;
+	}
+
+	transform->aWorldDirty = false;
+
+	world.aMatrix          = parentMat * Entity_GetLocalMatrix( *transform );
+	world.aValid           = true;
+}
+
+
+void Entity_MarkWorldTransformDirty( Entity sEntity )
+{
+	if ( sEntity < EntSysData().aWorldTransforms.size() )
+		EntSysData().aWorldTransformsDirty.push_back( sEntity );
+}
+
+
+void Entity_UpdateWorldTransforms()
+{
+	PROF_SCOPE();
+
+	EntitySystemData&    data          = EntSysData();
+	EntityComponentPool* transformPool = Entity_GetComponentPool< CTransform >();
+
+	if ( !transformPool || data.aWorldTransforms.empty() )
+		return;
+
+	u32 pass = ++data.aWorldTransformPass;
+
+	// Kept around so these don't allocate every frame
+	static std::vector< Entity > changed;
+	static std::vector< Entity > stack;
+
+	changed.clear();
 
-	for ( auto& [ otherEntity, flags ] : EntSysData().aEntityFlags )
+	// Only entities queued since the last pass changed, from their transform being edited or their parent changing
+	for ( Entity entity : data.aWorldTransformsDirty )
 	{
-		if ( !( flags & EEntityFlag_Parented ) )
+		if ( !Entity_EntityExists( entity ) || data.aWorldTransforms[ entity ].aDirtyPass == pass )
 			continue;
 
-		Entity otherParent = Entity_GetParent( otherEntity );
+		data.aWorldTransforms[ entity ].aDirtyPass = pass;
+		changed.push_back( entity );
+	}
+
+	data.aWorldTransformsDirty.clear();
 
-		if ( otherParent == sEntity )
+	// Rebuild parents first, starting from the highest changed entity in each chain
+	// Everything under a changed entity is rebuilt along with it
+	for ( Entity entity : changed )
+	{
+		if ( data.aWorldTransforms[ entity ].aBuiltPass == pass )
+			continue;
+
+		Entity root = entity;
+
+		for ( Entity parent = data.aHierarchy[ entity ].aParent; parent != CH_ENT_INVALID; parent = data.aHierarchy[ parent ].aParent )
 		{
-			srChildren.push_back( otherEntity );
-			Entity_GetChildrenRecurse( otherEntity, srChildren );
+			const EntWorldTransform_t& parentWorld = data.aWorldTransforms[ parent ];
 
-#pragma message( "CHECK IF THIS BREAKS THE CODE" )
-			break;
+			if ( parentWorld.aDirtyPass == pass || parentWorld.aVersion == 0 )
+				root = parent;
+		}
+
+		stack.clear();
+		stack.push_back( root );
+
+		while ( stack.size() )
+		{
+			Entity current = stack.back();
+			stack.pop_back();
+
+			Entity_BuildWorldTransform( data, current, transformPool );
+
+			for ( Entity child = data.aHierarchy[ current ].aFirstChild; child != CH_ENT_INVALID; child = data.aHierarchy[ child ].aNextSibling )
+				stack.push_back( child );
 		}
 	}
 }
 
 
+const EntWorldTransform_t* Entity_GetCachedWorldTransform( Entity sEntity )
+{
+	EntitySystemData& data = EntSysData();
+
+	if ( sEntity >= data.aWorldTransforms.size() || data.aWorldTransforms[ sEntity ].aVersion == 0 )
+		return nullptr;
+
+	return &data.aWorldTransforms[ sEntity ];
+}
+
+
 // Returns a Model Matrix with parents applied in world space IF we have a transform component
 bool Entity_GetWorldMatrix( glm::mat4& srMat, Entity sEntity )
+{
+	return Entity_GetWorldMatrix( srMat, sEntity, Entity_GetComponentPool< CTransform >() );
+}
+
+
+bool Entity_GetWorldMatrix( glm::mat4& srMat, Entity sEntity, EntityComponentPool* spTransformPool )
 {
 	PROF_SCOPE();
 
-	// Entity    parent = IsParented( sEntity ) ? GetParent( sEntity ) : CH_ENT_INVALID;
-	Entity    parent = Entity_GetParent( sEntity );
+	EntitySystemData& data = EntSysData();
+
+	// Use the cached matrix if nothing changed since the last update
+	// This doesn't write to the cache, so it's safe to call from worker threads
+	if ( sEntity < data.aWorldTransforms.size() && Entity_IsWorldTransformCurrent( data, sEntity, spTransformPool ) )
+	{
+		srMat = data.aWorldTransforms[ sEntity ].aMatrix;
+		return data.aWorldTransforms[ sEntity ].aValid;
+	}
+
+	// Something changed since then, so build it from scratch
+	Entity    parent = sEntity < data.aHierarchy.size() ? data.aHierarchy[ sEntity ].aParent : CH_ENT_INVALID;
 	glm::mat4 parentMat( 1.f );
 
 	if ( parent != CH_ENT_INVALID )
 	{
 		// Get the world matrix recursively
-		Entity_GetWorldMatrix( parentMat, parent );
+		Entity_GetWorldMatrix( parentMat, parent, spTransformPool );
 	}
 
 	// Check if we have a transform component
-	auto transform = static_cast< CTransform* >( Entity_GetComponent( sEntity, "transform" ) );
+	auto transform = static_cast< CTransform* >( spTransformPool->GetData( sEntity ) );
 
 	if ( !transform )
 	{
@@ -734,42 +1060,7 @@ bool Entity_GetWorldMatrix( glm::mat4& srMat, Entity sEntity )
 		return ( parent != CH_ENT_INVALID );
 	}
 
-	// is this all the wrong order?
-
-	// NOTE: THIS IS PROBABLY WRONG
-	srMat = glm::translate( transform->aPos.Get() );
-	// srMat = glm::mat4( 1.f );
-
-	glm::mat4 rotMat( 1.f );
-	#define ROT_ANG( axis ) glm::vec3( rotMat[ 0 ][ axis ], rotMat[ 1 ][ axis ], rotMat[ 2 ][ axis ] )
-
-	// glm::vec3 temp = glm::radians( transform->aAng.Get() );
-	// glm::quat rotQuat = temp;
-
-	#undef ROT_ANG
-
-	// rotMat = glm::mat4_cast( rotQuat );
-
-	// srMat *= rotMat;
-	// srMat *= glm::eulerAngleYZX(
-	//   glm::radians(transform->aAng.Get().x ),
-	//   glm::radians(transform->aAng.Get().y ),
-	//   glm::radians(transform->aAng.Get().z ) );
-	
-	srMat *= glm::eulerAngleZYX(
-	  glm::radians( transform->aAng.Get()[ ROLL ] ),
-	  glm::radians( transform->aAng.Get()[ YAW ] ),
-	  glm::radians( transform->aAng.Get()[ PITCH ] ) );
-	
-	// srMat *= glm::yawPitchRoll(
-	//   glm::radians( transform->aAng.Get()[ PITCH ] ),
-	//   glm::radians( transform->aAng.Get()[ YAW ] ),
-	//   glm::radians( transform->aAng.Get()[ ROLL ] ) );
-
-	srMat = glm::scale( srMat, transform->aScale.Get() );
-
-	srMat = parentMat * srMat;
-
+	srMat = parentMat * Entity_GetLocalMatrix( *transform );
 	return true;
 }
 
@@ -909,6 +1200,22 @@ void Entity_SetNetworked( Entity entity, bool sNetworked )
 }
 
 
+void Entity_SetAlwaysRelevant( Entity sEntity, bool sAlwaysRelevant )
+{
+	auto it = EntSysData().aEntityFlags.find( sEntity );
+	if ( it == EntSysData().aEntityFlags.end() )
+	{
+		Log_Error( gLC_Entity, "Failed to set Entity Always Relevant State - Entity not found\n" );
+		return;
+	}
+
+	if ( sAlwaysRelevant )
+		it->second |= EEntityFlag_AlwaysRelevant;
+	else
+		it->second &= ~EEntityFlag_AlwaysRelevant;
+}
+
+
 // Is this Entity Networked?
 bool Entity_IsNetworked( Entity sEntity )
 {
@@ -1136,11 +1443,15 @@ GAME_CONCMD( ent_mem )
 			}
 		}
 
-		compSize = regData->aSize * pool->GetCount();
+		// Chunks are allocated up front, so count all the slots in them, not just the used ones
+		size_t slotCount = pool->aChunks.size() * CH_ENT_COMP_CHUNK_SIZE;
+		compSize         = pool->aStride * slotCount;
 		curSize += compSize + compOtherSize;
+		curSize += pool->aSparse.size() * sizeof( u32 );
+		curSize += pool->GetCount() * ( sizeof( Entity ) + sizeof( ComponentID_t ) + sizeof( EEntityFlag ) );
 
 		Log_GroupF( group, "Component Pool \"%s\": %.6f KB\n", pool->apName, ch_bytes_to_kb( curSize ) );
-		Log_GroupF( group, "    %zd bytes per component * %zd components\n\n", regData->aSize, pool->GetCount() );
+		Log_GroupF( group, "    %zd bytes per component * %zd components (%zd slots allocated)\n\n", pool->aStride, pool->GetCount(), slotCount );
 
 		componentPoolSize += curSize;
 	}
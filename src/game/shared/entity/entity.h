@@ -7,6 +7,8 @@
 #include <set>
 #include <array>
 #include <forward_list>
+#include <new>
+#include <utility>
 
 #include "types/transform.h"
 #include "iaudio.h"
@@ -81,8 +83,8 @@ namespace std
 }
 
 
-// Functions for creating and freeing components
-using FEntComp_New          = std::function< void*() >;
+// Functions for constructing and destructing components in memory owned by the component pool
+using FEntComp_New          = std::function< void*( void* spMemory ) >;
 using FEntComp_Free         = std::function< void( void* spData ) >;
 
 // Functions for creating component systems
@@ -178,6 +180,9 @@ enum EEntityFlag_ : EEntityFlag
 	// Ignore data from the server on the client, useful for first person camera entity
 	// Or just change how EEntComponentNetType works, maybe what we pass is the default value, but you can override it?
 	EEntityFlag_IgnoreOnClient = ( 1 << 5 ), 
+
+	// Sent to every client no matter how far away it is, see Entity_SetAlwaysRelevant()
+	EEntityFlag_AlwaysRelevant = ( 1 << 6 ),
 };
 
 
@@ -193,9 +198,46 @@ enum ECompRegFlag_ : ECompRegFlag
 
 	// This variable is a network variable
 	ECompRegFlag_LocalVar           = ( 1 << 1 ),
+
+	// The client blends this variable between server updates instead of snapping to the newest one, see entity_interp.h
+	ECompRegFlag_Interpolate        = ( 1 << 2 ),
+
+	// Interpolate each float in this variable as an angle in degrees, going the short way around
+	ECompRegFlag_InterpAngles       = ( 1 << 3 ),
+
+	// Component flag, entities with this component are sent to every client no matter how far away they are
+	ECompRegFlag_AlwaysRelevant     = ( 1 << 4 ),
+};
+
+
+// Dense ID of a registered component type, assigned in the order components are registered
+// Used as an index into the registry and the component pools, so typed lookups don't need to hash anything
+using EntCompTypeID = u32;
+
+constexpr EntCompTypeID CH_ENT_COMP_TYPE_INVALID = UINT32_MAX;
+
+// Every lane of a ComponentNetVar is dirty
+constexpr u8            CH_ENT_VAR_LANES_ALL     = 0xFF;
+
+// Most lanes a networked var can have (glm::vec4 and glm::quat), every other var type only uses the first lane
+constexpr u32           CH_ENT_VAR_LANE_COUNT    = 4;
+
+
+// Storage for the type ID of each component type, set when the component is registered
+template< typename T >
+struct EntCompTypeIDStorage
+{
+	static inline EntCompTypeID aID = CH_ENT_COMP_TYPE_INVALID;
 };
 
 
+template< typename T >
+inline EntCompTypeID EntComp_GetTypeID()
+{
+	return EntCompTypeIDStorage< T >::aID;
+}
+
+
 // ====================================================================================================
 // Entity Component Database
 //
@@ -212,6 +254,9 @@ struct EntComponentVarData_t
 	size_t       aSize;
 	const char*  apName;
 	size_t       aNameLen;
+
+	// Floats (and each float in a vector) are networked as a multiple of this, 0 sends the full float
+	float        aPrecision = 0.f;
 };
 
 
@@ -236,11 +281,20 @@ struct EntComponentData_t
 	const char*                               apName;
 	size_t                                    aNameLen;
 
+	EntCompTypeID                             aTypeID = CH_ENT_COMP_TYPE_INVALID;
+
 	// [Var Offset] = Var Data
 	std::map< size_t, EntComponentVarData_t > aVars;
 
 	size_t                                    aSize;
 
+	// Total size of all vars with ECompRegFlag_Interpolate, the client buffers this much for every server update
+	size_t                                    aInterpSize = 0;
+
+	// Entities with this component are relevant to clients this many times further away than sv_relevance_dist
+	// The highest priority of all components on an entity is used
+	float                                     aNetPriority = 1.f;
+
 	ECompRegFlag                              aFlags;
 	EEntComponentNetType                      aNetType;
 
@@ -259,6 +313,9 @@ struct EntComponentRegistry_t
 	// Component Name to Component Data
 	std::unordered_map< std::string_view, EntComponentData_t* > aComponentNames;
 
+	// [Component Type ID] = Component Data
+	std::vector< EntComponentData_t* >                          aComponentIDs;
+
 	// [type hash of var] = Var Type Enum
 	std::unordered_map< size_t, EEntNetField >                  aVarTypes;
 
@@ -282,6 +339,18 @@ inline EntComponentRegistry_t &GetEntComponentRegistry()
 	return entComponentRegistry;
 }
 
+// Get the registry data for this component type, returns nullptr if it's not registered
+template< typename T >
+inline EntComponentData_t* EntComp_GetRegistryData()
+{
+	EntCompTypeID typeID = EntComp_GetTypeID< T >();
+
+	if ( typeID >= GetEntComponentRegistry().aComponentIDs.size() )
+		return nullptr;
+
+	return GetEntComponentRegistry().aComponentIDs[ typeID ];
+}
+
 // void* EntComponentRegistry_Create( std::string_view sName );
 // void* EntComponentRegistry_GetVarHandler();
 
@@ -305,6 +374,9 @@ inline void EntComp_RegisterComponent(
 {
 	CH_ASSERT( spName );
 
+	// Component Pools only guarantee the alignment malloc gives us
+	static_assert( alignof( T ) <= alignof( std::max_align_t ) );
+
 	if ( !spName )
 		return;
 
@@ -325,8 +397,11 @@ inline void EntComp_RegisterComponent(
 	data.aNetType                                       = sNetType;
 	data.aFuncNew                                       = sFuncNew;
 	data.aFuncFree                                      = sFuncFree;
+	data.aTypeID                                        = GetEntComponentRegistry().aComponentIDs.size();
 
 	GetEntComponentRegistry().aComponentNames[ spName ] = &data;
+	GetEntComponentRegistry().aComponentIDs.push_back( &data );
+	EntCompTypeIDStorage< T >::aID                      = data.aTypeID;
 
 	Entity_CreateComponentPool( spName );
 }
@@ -335,39 +410,50 @@ inline void EntComp_RegisterComponent(
 template< typename T >
 inline void EntComp_RegisterComponentSystem( IEntityComponentSystem* spSystem )
 {
-	size_t typeHash = typeid( T ).hash_code();
+	EntComponentData_t* data = EntComp_GetRegistryData< T >();
 
-	auto   it       = GetEntComponentRegistry().aComponents.find( typeHash );
-
-	if ( it == GetEntComponentRegistry().aComponents.end() )
+	if ( data == nullptr )
 	{
 		Log_ErrorF( "Component not registered, can't set system creation function: \"%s\"\n", typeid( T ).name() );
 		return;
 	}
 
-	EntComponentData_t& data = it->second;
-	data.apSystem            = spSystem;
+	data->apSystem = spSystem;
+}
+
+
+template< typename T >
+inline void EntComp_SetNetPriority( float sPriority )
+{
+	EntComponentData_t* data = EntComp_GetRegistryData< T >();
+
+	if ( data == nullptr )
+	{
+		Log_ErrorF( "Component not registered, can't set network priority: \"%s\"\n", typeid( T ).name() );
+		return;
+	}
+
+	data->aNetPriority = sPriority;
 }
 
 
 template< typename COMPONENT_TYPE, typename VAR_TYPE >
-inline void EntComp_RegisterComponentVarEx( EEntNetField sVarType, const char* spName, size_t sOffset, ECompRegFlag sFlags = 0 )
+inline void EntComp_RegisterComponentVarEx( EEntNetField sVarType, const char* spName, size_t sOffset, ECompRegFlag sFlags = 0, float sPrecision = 0.f )
 {
 	CH_ASSERT( spName );
 
 	if ( !spName )
 		return;
 
-	size_t typeHash = typeid( COMPONENT_TYPE ).hash_code();
-	auto   it       = GetEntComponentRegistry().aComponents.find( typeHash );
+	EntComponentData_t* regData = EntComp_GetRegistryData< COMPONENT_TYPE >();
 
-	if ( it == GetEntComponentRegistry().aComponents.end() )
+	if ( regData == nullptr )
 	{
-		Log_ErrorF( "Component not registered, can't add var: \"%s\" - \"%s\"\n", typeid( COMPONENT_TYPE ).name() );
+		Log_ErrorF( "Component not registered, can't add var: \"%s\" - \"%s\"\n", typeid( COMPONENT_TYPE ).name(), spName );
 		return;
 	}
 
-	EntComponentData_t& data    = it->second;
+	EntComponentData_t& data    = *regData;
 	auto                varFind = data.aVars.find( sOffset );
 
 	if ( varFind != data.aVars.end() )
@@ -382,6 +468,10 @@ inline void EntComp_RegisterComponentVarEx( EEntNetField sVarType, const char* s
 	varData.aSize                  = sizeof( VAR_TYPE );
 	varData.aType                  = sVarType;
 	varData.aFlags                 = sFlags;
+	varData.aPrecision             = sPrecision;
+
+	if ( sFlags & ECompRegFlag_Interpolate )
+		data.aInterpSize += sizeof( VAR_TYPE );
 
 	// TODO: really should have this be done once, but im not adding a new function for this to add to every single component
 	// data.aHash = 0;
@@ -437,7 +527,7 @@ inline void EntComp_RegisterComponentVarEx2( EEntNetField sVarType, const char*
 
 
 template< typename COMPONENT_TYPE, typename VAR_TYPE >
-inline void EntComp_RegisterComponentVar( const char* spName, size_t sOffset, ECompRegFlag sFlags = 0 )
+inline void EntComp_RegisterComponentVar( const char* spName, size_t sOffset, ECompRegFlag sFlags = 0, float sPrecision = 0.f )
 {
 	// Get Var Type
 	size_t varTypeHash = typeid( VAR_TYPE ).hash_code();
@@ -449,7 +539,7 @@ inline void EntComp_RegisterComponentVar( const char* spName, size_t sOffset, EC
 		return;
 	}
 
-	EntComp_RegisterComponentVarEx< COMPONENT_TYPE, VAR_TYPE >( findEnum->second, spName, sOffset, sFlags );
+	EntComp_RegisterComponentVarEx< COMPONENT_TYPE, VAR_TYPE >( findEnum->second, spName, sOffset, sFlags, sPrecision );
 }
 
 
@@ -519,6 +609,13 @@ inline void EntComp_RegisterVarHandler()
 // ====================================================================================================
 
 
+// Amount of components stored in each memory chunk of a component pool
+constexpr u32 CH_ENT_COMP_CHUNK_SIZE = 64;
+
+// Invalid index into the sparse or dense arrays of a component pool
+constexpr u32 CH_ENT_COMP_INVALID    = UINT32_MAX;
+
+
 class EntityComponentPool
 {
   public:
@@ -570,26 +667,70 @@ class EntityComponentPool
 	size_t                                    GetCount();
 
 	// ------------------------------------------------------------------
+	// Fast Access for iterating through the dense arrays, index must be less than GetCount()
 
-	// Map Component Index to Entity
-	std::unordered_map< ComponentID_t, Entity >      aMapComponentToEntity;
+	inline Entity                             GetEntityByIndex( size_t sIndex ) const
+	{
+		return aDenseEntities[ sIndex ];
+	}
 
-	// Map Entity to Component Index
-	std::unordered_map< Entity, ComponentID_t >      aMapEntityToComponent;
+	inline void*                              GetDataByIndex( size_t sIndex ) const
+	{
+		return GetSlotData( aDenseIDs[ sIndex ].aIndex );
+	}
 
-	// Memory Pool of Components
-	// This is an std::array so that when a component is freed, it does not changes the index of each component
-	// TODO: I DON'T LIKE THIS, TAKES UP TOO MUCH MEMORY
-	// maybe use ch_handle_t's from ResourceList<> instead, as it uses a memory pool?
-	std::array< void*, CH_MAX_ENTITIES >             aComponents{};
+	inline void*                              GetSlotData( size_t sSlot ) const
+	{
+		return aChunks[ sSlot / CH_ENT_COMP_CHUNK_SIZE ] + ( sSlot % CH_ENT_COMP_CHUNK_SIZE ) * aStride;
+	}
+
+	// Returns the index into the dense arrays for this entity, or CH_ENT_COMP_INVALID if it doesn't have this component
+	inline u32                                GetIndex( Entity entity ) const
+	{
+		if ( entity >= CH_MAX_ENTITIES )
+			return CH_ENT_COMP_INVALID;
+
+		return aSparse[ entity ];
+	}
+
+	// ------------------------------------------------------------------
+
+	// Sparse Set of Entities in this pool
+	// [Entity] = Index into the dense arrays, or CH_ENT_COMP_INVALID if the entity doesn't have this component
+	std::vector< u32 >                               aSparse;
+
+	// Dense Arrays, these are tightly packed and share the same index
+	// Removing a component swaps the last component into the removed index
+	std::vector< Entity >                            aDenseEntities;
+	std::vector< ComponentID_t >                     aDenseIDs;
 
 	// Component Flags, just uses Entity Flags for now
-	// Key is an index into aComponents
-	std::unordered_map< ComponentID_t, EEntityFlag > aComponentFlags;
+	std::vector< EEntityFlag >                       aDenseFlags;
+
+	// Memory Pool of Components
+	// Components are constructed in place inside fixed size chunks, so a component never moves in memory while it exists
+	// A ComponentID_t is the slot of the component in these chunks
+	std::vector< char* >                             aChunks;
+
+	// [ComponentID_t] = Index into the dense arrays, or CH_ENT_COMP_INVALID if this slot is free
+	std::vector< u32 >                               aSlotToDense;
+
+	// Slots of removed components we can reuse
+	std::vector< u32 >                               aFreeSlots;
+
+	// Server tick each component was created on, 0 if it hasn't been recorded yet
+	// [ComponentID_t] = Tick, only filled in on the server by Entity_RecordSnapshot()
+	std::vector< u32 >                               aSlotCreatedTicks;
+
+	// Server tick each lane of each networked var last changed on
+	// [ComponentID_t * aNetVarCount * CH_ENT_VAR_LANE_COUNT + Var * CH_ENT_VAR_LANE_COUNT + Lane] = Tick
+	std::vector< u32 >                               aSlotVarTicks;
 
-	// Amount of Components we have allocated
-	// size_t                                           aCount;
-	std::vector < ComponentID_t >                    aComponentIDs;
+	// Amount of vars on this component that are networked
+	u32                                              aNetVarCount = 0;
+
+	// Size of each component in the chunks, rounded up for alignment
+	size_t                                           aStride = 0;
 
 	std::forward_list< ComponentID_t >               aNewComponents;
 	std::forward_list< ComponentID_t >               aComponentsUpdated;
@@ -607,6 +748,13 @@ class EntityComponentPool
 	// NOTE: This may always just be one
 	// std::set< IEntityComponentSystem* >  aComponentSystems;
 	IEntityComponentSystem*                          apComponentSystem = nullptr;
+
+  private:
+	// Allocates a slot in the chunks for a new component
+	u32                                       AllocSlot();
+
+	// Removes the component at this index in the dense arrays
+	void                                      RemoveByIndex( u32 sIndex );
 };
 
 
@@ -616,11 +764,54 @@ class EntityComponentPool
 // ====================================================================================================
 
 
+// Engine interfaces a system calls into during Update(), systems using the same one are never updated at the same time
+using EEntSysInterface = int;
+enum EEntSysInterface_ : EEntSysInterface
+{
+	EEntSysInterface_None     = 0,
+	EEntSysInterface_Graphics = ( 1 << 0 ),
+	EEntSysInterface_Audio    = ( 1 << 1 ),
+	EEntSysInterface_Physics  = ( 1 << 2 ),
+};
+
+
+// What components a system reads and writes during Update(), used for running systems at the same time
+struct EntSysAccess_t
+{
+	std::vector< EntCompTypeID > aRead;
+	std::vector< EntCompTypeID > aWrite;
+
+	// Engine interfaces this calls into, nothing else using them runs alongside it
+	EEntSysInterface             aInterfaces = EEntSysInterface_None;
+
+	// Can this system be updated on a worker thread?
+	// Declaring the interfaces it uses is enough for those, leave this false if it needs the main thread (like graphics),
+	// or if it adds/removes components or entities during Update()
+	bool                         aThreadSafe = false;
+
+	template< typename T >
+	void Read()
+	{
+		aRead.push_back( EntComp_GetTypeID< T >() );
+	}
+
+	template< typename T >
+	void Write()
+	{
+		aWrite.push_back( EntComp_GetTypeID< T >() );
+	}
+};
+
+
 class IEntityComponentSystem
 {
   public:
 	virtual ~IEntityComponentSystem()                        = default;
 
+	// Fill in what components this system accesses in Update(), the component this system manages is always written to
+	// Returns false if undeclared, which makes the system run by itself with nothing else alongside it
+	virtual bool          GetAccess( EntSysAccess_t& srAccess ) { return false; };
+
 	// Called when the component is added to this entity
 	virtual void          ComponentAdded( Entity sEntity, void* spData ){};
 
@@ -665,6 +856,120 @@ struct EntityEventListener_t
 // ;
 
 
+// A component removed from an entity that still exists
+struct EntSnapshotRemoval_t
+{
+	EntityComponentPool* apPool;
+	Entity               aEntity;
+};
+
+
+// Everything removed on a server tick
+// Component var changes aren't stored here, each component pool keeps the tick every var last changed on instead
+struct EntSnapshot_t
+{
+	u32                                 aTick = 0;
+	std::vector< Entity >               aDestroyedEntities;
+	std::vector< EntSnapshotRemoval_t > aRemovedComponents;
+};
+
+
+// Rough size of an entity in the entity list, counted against the byte budget for every entity written
+constexpr u32 CH_ENT_UPDATE_SIZE = 24;
+
+
+// An entity one client is sent
+struct EntRelevantEnt_t
+{
+	// Tick it became relevant on
+	u32   aEnteredTick = 0;
+
+	// Newest tick the client acknowledged with this entity written in it, 0 if they don't have it yet
+	// Not every entity is written in every update, so this is delta encoded against instead of the update's baseline
+	u32   aAckedTick   = 0;
+
+	// Grows every tick this isn't written, the highest ones are written first
+	float aPriority    = 0.f;
+
+	// Nothing on this changed the last time it was written
+	bool  aIdle        = false;
+
+	// Set while this is in EntRelevance_t::aRelevant
+	bool  aRelevant    = false;
+
+	// Tick it stopped being relevant on, 0 unless it's in EntRelevance_t::aLeft
+	u32   aLeftTick    = 0;
+};
+
+
+// Entities one client is sent, kept up to date on the server every tick
+// Entities not in here are skipped when writing updates for that client
+struct EntRelevance_t
+{
+	// [Entity] = Relevant Entity, sized to CH_MAX_ENTITIES when relevance is first updated for this client
+	std::vector< EntRelevantEnt_t > aEntities;
+
+	// Entities that are relevant, in no particular order
+	std::vector< Entity >           aRelevant;
+
+	// Entities that stopped being relevant, they're sent as destroyed until the client acknowledges their aLeftTick
+	std::vector< Entity >           aLeft;
+
+	// Relevant entities in the order they're written, highest priority first
+	std::vector< Entity >           aSendOrder;
+
+	// Stop writing entities once the update passes this many bytes, 0 for no limit
+	u32                             aByteBudget = 0;
+
+	// The client's own entity, always sent first and not counted against the byte budget
+	// They predict it, so they need it in every update that acknowledges their commands
+	Entity                          aAlwaysSend = CH_ENT_INVALID;
+
+	// Set by Entity_WriteComponentUpdates(), the amount of entities from the start of aSendOrder that were written
+	// Entity_WriteEntityUpdates() only writes these, so write the component updates first
+	u32                             aSendCount  = 0;
+
+	bool IsRelevant( Entity sEntity ) const
+	{
+		return sEntity < aEntities.size() && aEntities[ sEntity ].aRelevant;
+	}
+};
+
+
+// Flat parent/child links for an entity, children are a linked list through their siblings
+struct EntHierarchy_t
+{
+	Entity aParent      = CH_ENT_INVALID;
+	Entity aFirstChild  = CH_ENT_INVALID;
+	Entity aNextSibling = CH_ENT_INVALID;
+	Entity aPrevSibling = CH_ENT_INVALID;
+};
+
+
+// Cached world matrix for an entity, along with what it was built from, so we can tell when it's out of date
+struct EntWorldTransform_t
+{
+	glm::mat4 aMatrix;
+
+	Entity    aParent       = CH_ENT_INVALID;
+
+	// Changes every time the matrix is rebuilt, 0 if it was never built
+	u32       aVersion       = 0;
+
+	// Version of the parent's matrix when this was built
+	u32       aParentVersion = 0;
+
+	// Last Entity_UpdateWorldTransforms() pass this was marked dirty and rebuilt on
+	u32       aDirtyPass     = 0;
+	u32       aBuiltPass     = 0;
+
+	bool      aHasTransform  = false;
+
+	// What Entity_GetWorldMatrix() returns for this entity
+	bool      aValid         = false;
+};
+
+
 struct EntitySystemData
 {
 	bool                                                         aActive   = false;
@@ -681,15 +986,15 @@ struct EntitySystemData
 	// Entity Flags
 	std::unordered_map< Entity, EEntityFlag >                    aEntityFlags;
 
-	// Entity Parents
-	std::unordered_map< Entity, Entity >                         aEntityParents;
-
 	// Entity Names (needs to be ordered because of parenting)
 	std::map< Entity, std::string >                              aEntityNames;
 
 	// Component Pools - Pool of all of this type of component in existence
 	std::unordered_map< std::string_view, EntityComponentPool* > aComponentPools;
 
+	// [Component Type ID] = Component Pool, nullptr if the pool failed to be created
+	std::vector< EntityComponentPool* >                          aComponentPoolsByID;
+
 	// All Component Systems, key is the type_hash() of the system
 	// NOTE: it's a bit strange to have them be stored here and one in each component pool
 	std::unordered_map< size_t, IEntityComponentSystem* >        aComponentSystems;
@@ -697,6 +1002,25 @@ struct EntitySystemData
 	// Event Listeners
 	// std::vector< EntityEventListener_t >                         aEventListeners;
 	ResourceList< EntityEventListener_t >                        aEventListeners;
+
+	// Ring buffer of removals on recent server ticks, indexed by tick
+	// Lets the server delta encode updates against any recent tick a client has acknowledged
+	std::vector< EntSnapshot_t >                                 aSnapshots;
+
+	// Removals on this tick or older fell out of aSnapshots, so we can't delta encode against anything older than it
+	u32                                                          aSnapshotLostTick = 0;
+
+	// [Entity] = Parent and child links
+	std::vector< EntHierarchy_t >                                aHierarchy;
+
+	// [Entity] = Cached world matrix, rebuilt by Entity_UpdateWorldTransforms()
+	std::vector< EntWorldTransform_t >                           aWorldTransforms;
+
+	// Entities that need their world matrix rebuilt, from their transform being edited or from being parented
+	std::vector< Entity >                                        aWorldTransformsDirty;
+
+	u32                                                          aWorldTransformVersion = 0;
+	u32                                                          aWorldTransformPass    = 0;
 };
 
 
@@ -704,6 +1028,18 @@ struct EntitySystemData
 EntitySystemData&       EntSysData();
 
 
+// Get the Component Pool for this Component Type ID, returns nullptr if there isn't one
+inline EntityComponentPool* Entity_GetComponentPoolByID( EntCompTypeID sTypeID )
+{
+	EntitySystemData& data = EntSysData();
+
+	if ( sTypeID >= data.aComponentPoolsByID.size() )
+		return nullptr;
+
+	return data.aComponentPoolsByID[ sTypeID ];
+}
+
+
 bool                    Entity_Init();
 void                    Entity_Shutdown();
 
@@ -737,12 +1073,31 @@ bool                    Entity_IsParented( Entity sEntity );
 // Get the highest level parent for this entity, returns self if not parented
 Entity                  Entity_GetRootParent( Entity sEntity );
 
-// Recursively get all entities attached to this one (SLOW)
+// Get the entities directly attached to this one
+void                    Entity_GetChildren( Entity sEntity, ChVector< Entity >& srChildren );
+
+// Recursively get all entities attached to this one, parents are always added before their children
 void                    Entity_GetChildrenRecurse( Entity sEntity, ChVector< Entity >& srChildren );
 
+// Rebuild cached world matrices for every transform that changed, along with everything parented to them
+// Called before systems are updated, only the queued entities are looked at, so unmoving entities cost nothing here
+// Changing a CTransform through Set(), Edit() or its operators queues it, anything writing to one directly has to call Entity_MarkTransformChanged()
+void                    Entity_UpdateWorldTransforms();
+
+// Rebuild this entity's world matrix on the next update even if its transform didn't change
+void                    Entity_MarkWorldTransformDirty( Entity sEntity );
+
+// Get the cached world matrix for this entity as of the last Entity_UpdateWorldTransforms()
+// Returns nullptr if it was never built
+const EntWorldTransform_t* Entity_GetCachedWorldTransform( Entity sEntity );
+
 // Returns a Model Matrix with parents applied in world space IF we have a transform component
+// Uses the cached matrix if nothing up the parent chain changed since it was built
 bool                    Entity_GetWorldMatrix( glm::mat4& srMat, Entity sEntity );
 
+// Same as above, but uses a transform component pool you already looked up, for use in loops
+bool                    Entity_GetWorldMatrix( glm::mat4& srMat, Entity sEntity, EntityComponentPool* spTransformPool );
+
 // Same as GetWorldMatrix, but returns in a Transform struct
 Transform               Entity_GetWorldTransform( Entity sEntity );
 
@@ -755,10 +1110,19 @@ Transform               Entity_GetWorldTransform( Entity sEntity );
 
 // Read and write from the network
 void                    Entity_ReadEntityUpdates( const NetMsg_EntityUpdates* spMsg );
-void                    Entity_WriteEntityUpdates( flatbuffers::FlatBufferBuilder& srBuilder );
-
 void                    Entity_ReadComponentUpdates( const NetMsg_ComponentUpdates* spReader );
-void                    Entity_WriteComponentUpdates( flatbuffers::FlatBufferBuilder& srBuilder, bool sFullUpdate );
+
+// Record what changed on this server tick and reset the dirty vars, call once per tick before writing any updates
+void                    Entity_RecordSnapshot( u32 sTick );
+
+// Can we send updates that only have the changes since this tick? Fails if the removals since then were lost
+bool                    Entity_CanDeltaFrom( u32 sBaselineTick );
+
+// Write everything that changed after sBaselineTick, or everything if sBaselineTick is 0
+// If spRelevance is set, only entities in it are written, in it's send order until the byte budget runs out
+// Entities that left it are written as destroyed
+void                    Entity_WriteEntityUpdates( flatbuffers::FlatBufferBuilder& srBuilder, u32 sTick, u32 sBaselineTick, const EntRelevance_t* spRelevance = nullptr );
+void                    Entity_WriteComponentUpdates( flatbuffers::FlatBufferBuilder& srBuilder, u32 sTick, u32 sBaselineTick, EntRelevance_t* spRelevance = nullptr );
 
 // Add a component to an entity
 void*                   Entity_AddComponent( Entity entity, std::string_view sName );
@@ -789,6 +1153,9 @@ bool                    Entity_IsNetworked( Entity sEntity );
 // Faster version of IsNetworked with the option to pass in the entity flags if you already have them
 bool                    Entity_IsNetworked( Entity sEntity, EEntityFlag sFlags );
 
+// Send this entity to every client no matter how far away it is, like the world model or the sun
+void                    Entity_SetAlwaysRelevant( Entity sEntity, bool sAlwaysRelevant = true );
+
 // Get the Component Pool for this Component
 EntityComponentPool*    Entity_GetComponentPool( std::string_view sName );
 
@@ -852,6 +1219,176 @@ inline T* Ent_GetComponent( Entity sEnt, const char* spName )
 }
 
 
+// ----------------------------------------------------------------------------------------------------
+// Typed Component Functions
+// These find the component pool with the component type ID, which is just an array index
+// The string versions above should only be needed for tools and the console
+
+
+// Get the Component Pool for this Component Type
+template< typename T >
+inline EntityComponentPool* Entity_GetComponentPool()
+{
+	EntityComponentPool* pool = Entity_GetComponentPoolByID( EntComp_GetTypeID< T >() );
+
+	if ( pool == nullptr )
+		Log_ErrorF( "Component not registered before use: \"%s\"\n", typeid( T ).name() );
+
+	return pool;
+}
+
+// Add a component to an entity
+template< typename T >
+inline T* Ent_AddComponent( Entity sEnt )
+{
+	EntityComponentPool* pool = Entity_GetComponentPool< T >();
+
+	if ( pool == nullptr )
+		return nullptr;
+
+	return static_cast< T* >( pool->Create( sEnt ) );
+}
+
+// Does this entity have this component?
+template< typename T >
+inline bool Ent_HasComponent( Entity sEnt )
+{
+	EntityComponentPool* pool = Entity_GetComponentPool< T >();
+
+	if ( pool == nullptr )
+		return false;
+
+	return pool->Contains( sEnt );
+}
+
+// Get a component from an entity
+template< typename T >
+inline T* Ent_GetComponent( Entity sEnt )
+{
+	EntityComponentPool* pool = Entity_GetComponentPool< T >();
+
+	if ( pool == nullptr )
+		return nullptr;
+
+	return static_cast< T* >( pool->GetData( sEnt ) );
+}
+
+// Remove a component from an entity, this is queued like Entity_RemoveComponent()
+template< typename T >
+inline void Ent_RemoveComponent( Entity sEnt )
+{
+	EntityComponentPool* pool = Entity_GetComponentPool< T >();
+
+	if ( pool == nullptr )
+		return;
+
+	pool->RemoveQueued( sEnt );
+}
+
+
+// ====================================================================================================
+// Entity Component View
+// 
+// Iterates through every entity that has all of these component types, and gives typed pointers to them
+// The pools are looked up once when the view is created, so iterating only does array lookups
+// 
+// Usage:
+//   EntityView< CTransform, CRenderable > view;
+//   view.Each( [ & ]( Entity sEntity, CTransform* spTransform, CRenderable* spRenderable ) { ... } );
+// 
+// Don't remove components directly while iterating, use Entity_RemoveComponent() which queues the removal
+// ====================================================================================================
+
+
+template< typename... COMPONENTS >
+class EntityView
+{
+	static_assert( sizeof...( COMPONENTS ) > 0, "EntityView needs at least one component type" );
+
+	static constexpr size_t COMPONENT_COUNT = sizeof...( COMPONENTS );
+
+  public:
+	EntityView()
+	{
+		aPools = { Entity_GetComponentPool< COMPONENTS >()... };
+
+		// Walk the pool with the least components, and check the others for each entity
+		for ( EntityComponentPool* pool : aPools )
+		{
+			if ( pool == nullptr )
+			{
+				apDriver = nullptr;
+				return;
+			}
+
+			if ( apDriver == nullptr || pool->GetCount() < apDriver->GetCount() )
+				apDriver = pool;
+		}
+	}
+
+	// Is every component type in this view registered?
+	bool IsValid() const
+	{
+		return apDriver != nullptr;
+	}
+
+	// Calls the function with the entity and a pointer to each component type in this view
+	template< typename FUNC >
+	void Each( FUNC&& srFunc ) const
+	{
+		if ( apDriver == nullptr )
+			return;
+
+		EachImpl( srFunc, std::index_sequence_for< COMPONENTS... >{} );
+	}
+
+	// Returns an upper bound on the amount of entities this view will visit
+	size_t GetCountEstimate() const
+	{
+		return apDriver ? apDriver->GetCount() : 0;
+	}
+
+	// Get the pool of a component type in this view
+	template< size_t INDEX >
+	EntityComponentPool* GetPool() const
+	{
+		return aPools[ INDEX ];
+	}
+
+  private:
+	template< typename FUNC, size_t... INDEX >
+	void EachImpl( FUNC& srFunc, std::index_sequence< INDEX... > ) const
+	{
+		std::array< u32, COMPONENT_COUNT > indexes;
+
+		for ( size_t i = 0; i < apDriver->GetCount(); i++ )
+		{
+			Entity entity = apDriver->GetEntityByIndex( i );
+			bool   valid  = true;
+
+			for ( size_t p = 0; p < COMPONENT_COUNT; p++ )
+			{
+				indexes[ p ] = aPools[ p ]->GetIndex( entity );
+
+				if ( indexes[ p ] == CH_ENT_COMP_INVALID )
+				{
+					valid = false;
+					break;
+				}
+			}
+
+			if ( !valid )
+				continue;
+
+			srFunc( entity, static_cast< COMPONENTS* >( aPools[ INDEX ]->GetDataByIndex( indexes[ INDEX ] ) )... );
+		}
+	}
+
+	std::array< EntityComponentPool*, COMPONENT_COUNT > aPools{};
+	EntityComponentPool*                                apDriver = nullptr;
+};
+
+
 bool Entity_Init();
 void Entity_Shutdown();
 
@@ -861,22 +1398,49 @@ void Entity_Shutdown();
 // ==========================================
 
 
+// Returns a bit for each float in a vector that differs between the two values, or every bit for any other type
+template< typename T >
+inline u8 EntComp_GetChangedLanes( const T& srOld, const T& srNew )
+{
+	if constexpr ( std::is_same_v< T, glm::vec2 > || std::is_same_v< T, glm::vec3 > || std::is_same_v< T, glm::vec4 > || std::is_same_v< T, glm::quat > )
+	{
+		u8 lanes = 0;
+
+		for ( int i = 0; i < T::length(); i++ )
+		{
+			if ( memcmp( &srOld[ i ], &srNew[ i ], sizeof( float ) ) != 0 )
+				lanes |= 1 << i;
+		}
+
+		return lanes;
+	}
+	else
+	{
+		return CH_ENT_VAR_LANES_ALL;
+	}
+}
+
+
+// NOTE: the serialization code expects aIsDirty to be right after aValue, and aDirtyLanes right after that
 template< typename T >
 struct ComponentNetVar
 {
 	using Type = T;
 
 	T    aValue{};
-	bool aIsDirty = true;
+	bool aIsDirty    = true;
+
+	// Which floats in a vector have changed since we last networked it, used for only sending the changed values
+	u8   aDirtyLanes = CH_ENT_VAR_LANES_ALL;
 
 	ComponentNetVar() :
-		aIsDirty( true ), aValue()
+		aIsDirty( true ), aDirtyLanes( CH_ENT_VAR_LANES_ALL ), aValue()
 	{
 	}
 
 	template< typename VAR_TYPE = int >
 	ComponentNetVar( VAR_TYPE var ) :
-		aIsDirty( true ), aValue( var )
+		aIsDirty( true ), aDirtyLanes( CH_ENT_VAR_LANES_ALL ), aValue( var )
 	{
 	}
 
@@ -889,8 +1453,9 @@ struct ComponentNetVar
 		// if ( aValue != *spValue )
 		if ( memcmp( &aValue, spValue, sizeof( T ) ) != 0 )
 		{
-			aIsDirty = true;
-			aValue   = *spValue;
+			aIsDirty    = true;
+			aDirtyLanes |= EntComp_GetChangedLanes( aValue, *spValue );
+			aValue      = *spValue;
 		}
 
 		return aValue;
@@ -900,8 +1465,9 @@ struct ComponentNetVar
 	{
 		if ( memcmp( &aValue, &srValue, sizeof( T ) ) != 0 )
 		{
-			aIsDirty = true;
-			aValue   = srValue;
+			aIsDirty    = true;
+			aDirtyLanes |= EntComp_GetChangedLanes( aValue, srValue );
+			aValue      = srValue;
 		}
 
 		return aValue;
@@ -923,7 +1489,8 @@ struct ComponentNetVar
 
 	T& Edit()
 	{
-		aIsDirty = true;
+		aIsDirty    = true;
+		aDirtyLanes = CH_ENT_VAR_LANES_ALL;
 		return aValue;
 	}
 
@@ -967,28 +1534,32 @@ struct ComponentNetVar
 
 	const T& operator+=( const T* spValue )
 	{
-		aIsDirty = true;
+		aIsDirty    = true;
+		aDirtyLanes = CH_ENT_VAR_LANES_ALL;
 		aValue += *spValue;
 		return aValue;
 	}
 
 	const T& operator+=( const T& srValue )
 	{
-		aIsDirty = true;
+		aIsDirty    = true;
+		aDirtyLanes = CH_ENT_VAR_LANES_ALL;
 		aValue += srValue;
 		return aValue;
 	}
 
 	const T& operator*=( const T* spValue )
 	{
-		aIsDirty = true;
+		aIsDirty    = true;
+		aDirtyLanes = CH_ENT_VAR_LANES_ALL;
 		aValue *= *spValue;
 		return aValue;
 	}
 
 	const T& operator*=( const T& srValue )
 	{
-		aIsDirty = true;
+		aIsDirty    = true;
+		aDirtyLanes = CH_ENT_VAR_LANES_ALL;
 		aValue *= srValue;
 		return aValue;
 	}
@@ -1145,11 +1716,110 @@ enum ETransformNetFlag : short
 
 
 
+struct CTransform;
+
+
+enum ETransformVar
+{
+	ETransformVar_Pos,
+	ETransformVar_Ang,
+	ETransformVar_Scale,
+};
+
+
+// A value in CTransform, changing it queues the transform for Entity_UpdateWorldTransforms() to rebuild
+// This doesn't add any data, the transform is found from where this value is in it
+template< typename T, ETransformVar VAR >
+struct CTransformVar : public ComponentNetVar< T >
+{
+	using Base = ComponentNetVar< T >;
+
+	CTransformVar() :
+		Base()
+	{
+	}
+
+	// Cast, or the base's converting constructor would take this by value and copy it forever
+	CTransformVar( const CTransformVar& srOther ) :
+		Base( static_cast< const Base& >( srOther ) )
+	{
+	}
+
+	const T& Set( const T* spValue )
+	{
+		if ( memcmp( &this->aValue, spValue, sizeof( T ) ) != 0 )
+			MarkChanged();
+
+		return Base::Set( spValue );
+	}
+
+	const T& Set( const T& srValue )
+	{
+		return Set( &srValue );
+	}
+
+	T& Edit()
+	{
+		MarkChanged();
+		return Base::Edit();
+	}
+
+	const T& operator=( const T* spValue )
+	{
+		return Set( spValue );
+	}
+
+	const T& operator=( const T& srValue )
+	{
+		return Set( &srValue );
+	}
+
+	CTransformVar& operator=( const CTransformVar& srOther )
+	{
+		Set( &srOther.aValue );
+		return *this;
+	}
+
+	const T& operator+=( const T* spValue )
+	{
+		MarkChanged();
+		return Base::operator+=( spValue );
+	}
+
+	const T& operator+=( const T& srValue )
+	{
+		MarkChanged();
+		return Base::operator+=( srValue );
+	}
+
+	const T& operator*=( const T* spValue )
+	{
+		MarkChanged();
+		return Base::operator*=( spValue );
+	}
+
+	const T& operator*=( const T& srValue )
+	{
+		MarkChanged();
+		return Base::operator*=( srValue );
+	}
+
+  private:
+	void MarkChanged();
+};
+
+
 struct CTransform
 {
-	ComponentNetVar< glm::vec3 > aPos   = {};
-	ComponentNetVar< glm::vec3 > aAng   = {};
-	ComponentNetVar< glm::vec3 > aScale = {};
+	CTransformVar< glm::vec3, ETransformVar_Pos >   aPos   = {};
+	CTransformVar< glm::vec3, ETransformVar_Ang >   aAng   = {};
+	CTransformVar< glm::vec3, ETransformVar_Scale > aScale = {};
+
+	// Set when the component is added, CH_ENT_INVALID for transforms that aren't in a component pool
+	Entity                                          aEntity     = CH_ENT_INVALID;
+
+	// Queued for Entity_UpdateWorldTransforms() to rebuild the world matrix
+	bool                                            aWorldDirty = false;
 
 	// -------------------------------------------------
 	// C++ class essentials
@@ -1206,6 +1876,33 @@ struct CTransform
 };
 
 
+// Queue this transform's world matrix to be rebuilt, if it's in a component pool and isn't queued already
+inline void Entity_MarkTransformChanged( CTransform& srTransform )
+{
+	if ( srTransform.aWorldDirty || srTransform.aEntity == CH_ENT_INVALID )
+		return;
+
+	srTransform.aWorldDirty = true;
+	Entity_MarkWorldTransformDirty( srTransform.aEntity );
+}
+
+
+template< typename T, ETransformVar VAR >
+inline void CTransformVar< T, VAR >::MarkChanged()
+{
+	size_t offset = 0;
+
+	if constexpr ( VAR == ETransformVar_Pos )
+		offset = offsetof( CTransform, aPos );
+	else if constexpr ( VAR == ETransformVar_Ang )
+		offset = offsetof( CTransform, aAng );
+	else
+		offset = offsetof( CTransform, aScale );
+
+	Entity_MarkTransformChanged( *reinterpret_cast< CTransform* >( reinterpret_cast< char* >( this ) - offset ) );
+}
+
+
 struct CRigidBody
 {
 	ComponentNetVar< glm::vec3 > aVel = {};
@@ -1302,11 +1999,11 @@ struct CHealth
 // Helper Macros
 #define CH_REGISTER_COMPONENT( type, name, netType ) \
   EntComp_RegisterComponent< type >(                                             \
-	#name, netType, [ & ]() { return new type; }, [ & ]( void* spData ) { delete (type*)spData; }, 0 )
+	#name, netType, [ & ]( void* spMemory ) { return new ( spMemory ) type; }, [ & ]( void* spData ) { ( (type*)spData )->~type(); }, 0 )
 
 #define CH_REGISTER_COMPONENT_FL( type, name, netType, flags ) \
   EntComp_RegisterComponent< type >(                                             \
-	#name, netType, [ & ]() { return new type; }, [ & ]( void* spData ) { delete (type*)spData; }, flags )
+	#name, netType, [ & ]( void* spMemory ) { return new ( spMemory ) type; }, [ & ]( void* spData ) { ( (type*)spData )->~type(); }, flags )
 
 #define CH_REGISTER_COMPONENT_SYS( type, systemClass, systemVar ) \
   EntComp_RegisterComponentSystem< type >( &systemVar )
@@ -1356,9 +2053,11 @@ struct CHealth
 	__CompRegister_##type##_t()                                    \
 	{                                                              \
 	  EntComp_RegisterComponent< TYPE >(                           \
-		#name, netType, [ & ]() { return new TYPE; },              \
+		#name, netType,                                            \
+		[ & ]( void* spMemory )                                    \
+		{ return new ( spMemory ) TYPE; },                         \
 		[ & ]( void* spData )                                      \
-		{ delete (type*)spData; },                                 \
+		{ ( (TYPE*)spData )->~TYPE(); },                           \
 		flags );                                                   \
                                                                    \
 	  RegisterVars();                                              \
@@ -1368,9 +2067,17 @@ struct CHealth
   void                             __CompRegister_##type##_t::RegisterVars()
 
 
+// How far away this component is relevant to clients, as a multiple of sv_relevance_dist
+#define CH_REGISTER_COMPONENT_NET_PRIORITY( priority ) \
+  EntComp_SetNetPriority< TYPE >( priority )
+
 #define CH_REGISTER_COMPONENT_VAR2( compVarType, varType, varName, varStr, flags ) \
   EntComp_RegisterComponentVarEx< TYPE, varType >( compVarType, #varStr, offsetof( TYPE, varName ), flags )
 
+// Same as above, but floats are networked as a multiple of precision
+#define CH_REGISTER_COMPONENT_VAR2_PREC( compVarType, varType, varName, varStr, flags, precision ) \
+  EntComp_RegisterComponentVarEx< TYPE, varType >( compVarType, #varStr, offsetof( TYPE, varName ), flags, precision )
+
 #define CH_REGISTER_COMPONENT_SYS2( systemClass, systemVar ) \
 	EntComp_RegisterComponentSystem< TYPE >( &systemVar )
 
@@ -1437,7 +2144,7 @@ Renderable_t* Ent_CreateRenderable( Entity sEntity );
 // This version has an option to enter a model handle
 inline Renderable_t* Ent_CreateRenderable( Entity sEntity, ch_handle_t sModel )
 {
-	auto renderComp = Ent_GetComponent< CRenderable >( sEntity, "renderable" );
+	auto renderComp = Ent_GetComponent< CRenderable >( sEntity );
 
 	if ( !renderComp )
 	{
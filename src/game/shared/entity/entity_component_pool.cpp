@@ -29,20 +29,24 @@ inline const char* GetProcessingName()
 
 EntityComponentPool::EntityComponentPool()
 {
-	// aCount = 0;
+	aSparse.resize( CH_MAX_ENTITIES, CH_ENT_COMP_INVALID );
 }
 
 
 EntityComponentPool::~EntityComponentPool()
 {
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
+	CH_ASSERT( aDenseEntities.size() == aDenseIDs.size() );
+	CH_ASSERT( aDenseEntities.size() == aDenseFlags.size() );
 
-	while ( aMapEntityToComponent.size() )
+	while ( aDenseEntities.size() )
 	{
-		auto it = aMapEntityToComponent.begin();
-		Remove( it->first );
+		RemoveByIndex( aDenseEntities.size() - 1 );
 	}
+
+	for ( char* chunk : aChunks )
+		free( chunk );
+
+	aChunks.clear();
 }
 
 
@@ -50,9 +54,8 @@ bool EntityComponentPool::Init( const char* spName )
 {
 	PROF_SCOPE();
 
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
+	CH_ASSERT( aDenseEntities.size() == aDenseIDs.size() );
+	CH_ASSERT( aDenseEntities.size() == aDenseFlags.size() );
 
 	apName  = spName;
 
@@ -73,6 +76,16 @@ bool EntityComponentPool::Init( const char* spName )
 
 	apData    = it->second;
 
+	// Round the component size up so every component in a chunk stays aligned
+	constexpr size_t align = alignof( std::max_align_t );
+	aStride                = ( std::max< size_t >( apData->aSize, 1 ) + align - 1 ) & ~( align - 1 );
+
+	for ( const auto& [ offset, var ] : apData->aVars )
+	{
+		if ( !( var.aFlags & ECompRegFlag_LocalVar ) && var.aType != EEntNetField_Invalid )
+			aNetVarCount++;
+	}
+
 	return true;
 }
 
@@ -80,44 +93,61 @@ bool EntityComponentPool::Init( const char* spName )
 // Get Component Registry Data
 EntComponentData_t* EntityComponentPool::GetRegistryData()
 {
-	PROF_SCOPE();
-
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
-
-	return GetEntComponentRegistry().aComponentNames[ apName ];
+	return apData;
 }
 
 
 // Does this pool contain a component for this entity?
 bool EntityComponentPool::Contains( Entity entity )
+{
+	return GetIndex( entity ) != CH_ENT_COMP_INVALID;
+}
+
+
+void EntityComponentPool::EntityDestroyed( Entity entity )
 {
 	PROF_SCOPE();
 
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
+	u32 index = GetIndex( entity );
+
+	if ( index != CH_ENT_COMP_INVALID )
+	{
+		RemoveByIndex( index );
+	}
 
-	auto it = aMapEntityToComponent.find( entity );
-	return ( it != aMapEntityToComponent.end() );
+	CH_ASSERT( aDenseEntities.size() == aDenseIDs.size() );
+	CH_ASSERT( aDenseEntities.size() == aDenseFlags.size() );
 }
 
 
-void EntityComponentPool::EntityDestroyed( Entity entity )
+u32 EntityComponentPool::AllocSlot()
 {
-	PROF_SCOPE();
+	// Reuse a slot from a removed component if we have one
+	if ( aFreeSlots.size() )
+	{
+		u32 slot = aFreeSlots.back();
+		aFreeSlots.pop_back();
+		return slot;
+	}
 
-	auto it = aMapEntityToComponent.find( entity );
+	u32 slot = aSlotToDense.size();
 
-	if ( it != aMapEntityToComponent.end() )
+	// Allocate a new chunk if we filled up the last one
+	if ( slot / CH_ENT_COMP_CHUNK_SIZE >= aChunks.size() )
 	{
-		Remove( entity );
+		char* chunk = static_cast< char* >( malloc( aStride * CH_ENT_COMP_CHUNK_SIZE ) );
+
+		if ( chunk == nullptr )
+		{
+			Log_ErrorF( gLC_Entity, "Failed to allocate component chunk - \"%s\"\n", apName );
+			return CH_ENT_COMP_INVALID;
+		}
+
+		aChunks.push_back( chunk );
 	}
 
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
+	aSlotToDense.push_back( CH_ENT_COMP_INVALID );
+	return slot;
 }
 
 
@@ -126,79 +156,69 @@ void* EntityComponentPool::Create( Entity entity )
 {
 	PROF_SCOPE();
 
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
+	CH_ASSERT( aDenseEntities.size() == aDenseIDs.size() );
+	CH_ASSERT( aDenseEntities.size() == aDenseFlags.size() );
 
 	// Is this a client or server component pool?
 	// TODO: Make sure this component can be created on it
 
+	if ( CH_IF_ASSERT_MSG( entity < CH_MAX_ENTITIES, "Entity out of range" ) )
+		return nullptr;
+
 	// Check if the component already exists
-	auto it = aMapEntityToComponent.find( entity );
+	u32 index = aSparse[ entity ];
 
-	if ( it != aMapEntityToComponent.end() )
+	if ( index != CH_ENT_COMP_INVALID )
 	{
 		Log_ErrorF( gLC_Entity, "Component already exists on entity - \"%s\"\n", apName );
-		return aComponents[ it->second.aIndex ];
+		return GetDataByIndex( index );
 	}
 
+	u32 slot = AllocSlot();
+
+	if ( slot == CH_ENT_COMP_INVALID )
+		return nullptr;
+
 	ComponentID_t newID;
-	newID.aIndex = aComponentIDs.size();
-	auto it2     = aMapComponentToEntity.find( newID );
+	newID.aIndex = slot;
 
-	if ( it2 != aMapComponentToEntity.end() )
-	{
-		Log_ErrorF( gLC_Entity, "what - component \"%s\"\n", apName );
-	}
+	// Construct the component in the chunk
+	void* data           = aFuncNew( GetSlotData( slot ) );
+
+	// This slot may have been used by a removed component, so the server records this as a new one
+	if ( slot < aSlotCreatedTicks.size() )
+		aSlotCreatedTicks[ slot ] = 0;
 
-	aMapEntityToComponent[ entity ] = newID;
-	aMapComponentToEntity[ newID ]  = entity;
+	index                = aDenseEntities.size();
+	aSparse[ entity ]    = index;
+	aSlotToDense[ slot ] = index;
 
-	void* data                      = aFuncNew();
-	aComponentFlags[ newID ]        = EEntityFlag_Created;
-	aComponents[ newID.aIndex ]     = data;
+	aDenseEntities.push_back( entity );
+	aDenseIDs.push_back( newID );
+	aDenseFlags.push_back( EEntityFlag_Created );
 
-	aComponentIDs.push_back( newID );
 	aNewComponents.push_front( newID );
 
 	// Add it to system
 	if ( apComponentSystem )
 		apComponentSystem->aEntities.push_back( entity );
 
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
+	CH_ASSERT( aDenseEntities.size() == aDenseIDs.size() );
+	CH_ASSERT( aDenseEntities.size() == aDenseFlags.size() );
 
 	Log_DevF( gLC_Entity, 2, "%s - Added Component To Entity %zd - %s\n", GetProcessingName(), entity, apName );
 
-	// TODO: use malloc and use that pointer in the constructor for this
-	// use placement new
-	// https://stackoverflow.com/questions/2494471/c-is-it-possible-to-call-a-constructor-directly-without-new
-
 	return data;
 }
 
 
-// Removes this component from the entity
-void EntityComponentPool::Remove( Entity entity )
+void EntityComponentPool::RemoveByIndex( u32 sIndex )
 {
-	PROF_SCOPE();
-
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
+	CH_ASSERT( sIndex < aDenseEntities.size() );
 
-	auto it = aMapEntityToComponent.find( entity );
-
-	if ( it == aMapEntityToComponent.end() )
-	{
-		Log_ErrorF( gLC_Entity, "Failed to remove component from entity - \"%s\"\n", apName );
-		return;
-	}
-
-	ComponentID_t index = it->second;
-	void* data = aComponents[ index.aIndex ];
-	CH_ASSERT( data );
+	Entity        entity = aDenseEntities[ sIndex ];
+	ComponentID_t id     = aDenseIDs[ sIndex ];
+	void*         data   = GetSlotData( id.aIndex );
 
 	// Remove it from systems
 	// for ( auto system : aComponentSystems )
@@ -208,67 +228,65 @@ void EntityComponentPool::Remove( Entity entity )
 		vec_remove( apComponentSystem->aEntities, entity );
 	}
 
-	aMapComponentToEntity.erase( index );
-	aMapEntityToComponent.erase( it );
+	aFuncFree( data );
 
-	aComponentFlags.erase( index );
+	aSparse[ entity ]         = CH_ENT_COMP_INVALID;
+	aSlotToDense[ id.aIndex ] = CH_ENT_COMP_INVALID;
+	aFreeSlots.push_back( id.aIndex );
 
-	aFuncFree( data );
+	// Swap the last component into this index to keep the dense arrays packed
+	u32 lastIndex = aDenseEntities.size() - 1;
 
-	vec_remove( aComponentIDs, index );
+	if ( sIndex != lastIndex )
+	{
+		aDenseEntities[ sIndex ] = aDenseEntities[ lastIndex ];
+		aDenseIDs[ sIndex ]      = aDenseIDs[ lastIndex ];
+		aDenseFlags[ sIndex ]    = aDenseFlags[ lastIndex ];
+
+		aSparse[ aDenseEntities[ sIndex ] ]        = sIndex;
+		aSlotToDense[ aDenseIDs[ sIndex ].aIndex ] = sIndex;
+	}
+
+	aDenseEntities.pop_back();
+	aDenseIDs.pop_back();
+	aDenseFlags.pop_back();
 
 	Log_DevF( gLC_Entity, 2, "%s - Removed Component From Entity %zd - %s\n", GetProcessingName(), entity, apName );
 
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
+	CH_ASSERT( aDenseEntities.size() == aDenseIDs.size() );
+	CH_ASSERT( aDenseEntities.size() == aDenseFlags.size() );
 }
 
 
-// Removes this component by index
-void EntityComponentPool::RemoveByID( ComponentID_t sID )
+// Removes this component from the entity
+void EntityComponentPool::Remove( Entity entity )
 {
 	PROF_SCOPE();
 
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
-
-	auto it = aMapComponentToEntity.find( sID );
+	u32 index = GetIndex( entity );
 
-	if ( it == aMapComponentToEntity.end() )
+	if ( index == CH_ENT_COMP_INVALID )
 	{
 		Log_ErrorF( gLC_Entity, "Failed to remove component from entity - \"%s\"\n", apName );
 		return;
 	}
 
-	Entity entity = it->second;
+	RemoveByIndex( index );
+}
 
-	void*  data   = aComponents[ sID.aIndex ];
-	CH_ASSERT( data );
 
-	// Remove it from the system
-	if ( apComponentSystem )
+// Removes this component by index
+void EntityComponentPool::RemoveByID( ComponentID_t sID )
+{
+	PROF_SCOPE();
+
+	if ( sID.aIndex >= aSlotToDense.size() || aSlotToDense[ sID.aIndex ] == CH_ENT_COMP_INVALID )
 	{
-		apComponentSystem->ComponentRemoved( entity, data );
-		vec_remove( apComponentSystem->aEntities, entity );
+		Log_ErrorF( gLC_Entity, "Failed to remove component from entity - \"%s\"\n", apName );
+		return;
 	}
 
-	aMapComponentToEntity.erase( sID );
-	aMapEntityToComponent.erase( entity );
-
-	aComponentFlags.erase( sID );
-
-	aFuncFree( data );
-
-	vec_remove( aComponentIDs, sID );
-	// aCount--;
-
-	Log_DevF( gLC_Entity, 2, "%s - Removed Component From Entity %zd - %s\n", GetProcessingName(), entity, apName );
-
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
+	RemoveByIndex( aSlotToDense[ sID.aIndex ] );
 }
 
 
@@ -277,18 +295,16 @@ void EntityComponentPool::RemoveQueued( Entity entity )
 {
 	PROF_SCOPE();
 
-	auto it = aMapEntityToComponent.find( entity );
+	u32 index = GetIndex( entity );
 
-	if ( it == aMapEntityToComponent.end() )
+	if ( index == CH_ENT_COMP_INVALID )
 	{
 		Log_ErrorF( gLC_Entity, "Failed to remove component from entity - \"%s\"\n", apName );
 		return;
 	}
 
-	ComponentID_t index = it->second;
-
 	// Mark Component as Destroyed
-	aComponentFlags[ index ] |= EEntityFlag_Destroyed;
+	aDenseFlags[ index ] |= EEntityFlag_Destroyed;
 
 	Log_DevF( gLC_Entity, 2, "%s - Marked Component to be removed From Entity %zd - %s\n", GetProcessingName(), entity, apName );
 }
@@ -299,21 +315,11 @@ void EntityComponentPool::RemoveAllQueued()
 {
 	PROF_SCOPE();
 
-	std::vector< ComponentID_t > toRemove;
-
-	// for ( auto& [ index, state ] : aComponentFlags )
-	for ( auto it = aComponentFlags.begin(); it != aComponentFlags.end(); it++ )
-	{
-		if ( it->second & EEntityFlag_Destroyed )
-		{
-			toRemove.push_back( it->first );
-			continue;
-		}
-	}
-
-	for ( ComponentID_t entity : toRemove )
+	// Go backwards, removing a component only swaps in one we already checked
+	for ( size_t i = aDenseFlags.size(); i-- > 0; )
 	{
-		RemoveByID( entity );
+		if ( aDenseFlags[ i ] & EEntityFlag_Destroyed )
+			RemoveByIndex( i );
 	}
 }
 
@@ -331,13 +337,24 @@ void EntityComponentPool::InitCreatedComponents()
 
 	for ( ComponentID_t id : aNewComponents )
 	{
-		aComponentFlags[ id ] &= ~EEntityFlag_Created;
-		apComponentSystem->ComponentAdded( aMapComponentToEntity.at( id ), aComponents.at( id.aIndex ) );
+		u32 index = aSlotToDense[ id.aIndex ];
+
+		// This component was removed before it was initialized
+		if ( index == CH_ENT_COMP_INVALID )
+			continue;
+
+		aDenseFlags[ index ] &= ~EEntityFlag_Created;
+		apComponentSystem->ComponentAdded( aDenseEntities[ index ], GetSlotData( id.aIndex ) );
 	}
 
 	for ( ComponentID_t id : aComponentsUpdated )
 	{
-		apComponentSystem->ComponentUpdated( aMapComponentToEntity.at( id ), aComponents.at( id.aIndex ) );
+		u32 index = aSlotToDense[ id.aIndex ];
+
+		if ( index == CH_ENT_COMP_INVALID )
+			continue;
+
+		apComponentSystem->ComponentUpdated( aDenseEntities[ index ], GetSlotData( id.aIndex ) );
 	}
 
 	aNewComponents.clear();
@@ -350,20 +367,12 @@ void* EntityComponentPool::GetData( Entity entity )
 {
 	PROF_SCOPE();
 
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
-
-	auto it = aMapEntityToComponent.find( entity );
+	u32 index = GetIndex( entity );
 
-	if ( it != aMapEntityToComponent.end() )
-	{
-		size_t index = it->second.aIndex;
-		// return &aComponents[ index ];
-		return aComponents[ index ];
-	}
+	if ( index == CH_ENT_COMP_INVALID )
+		return nullptr;
 
-	return nullptr;
+	return GetDataByIndex( index );
 }
 
 
@@ -371,30 +380,22 @@ void* EntityComponentPool::GetData( ComponentID_t sComponentID )
 {
 	PROF_SCOPE();
 
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
-
-	if ( sComponentID.aIndex > aComponentIDs.size() )
+	if ( sComponentID.aIndex >= aSlotToDense.size() || aSlotToDense[ sComponentID.aIndex ] == CH_ENT_COMP_INVALID )
 	{
 		Log_ErrorF( "Invalid Component ID: %zd\n", sComponentID.aIndex );
 		return nullptr;
 	}
 
-	return aComponents[ sComponentID.aIndex ];
+	return GetSlotData( sComponentID.aIndex );
 }
 
 
 // Marks this component as predicted
 void EntityComponentPool::SetPredicted( Entity entity, bool sPredicted )
 {
-	CH_ASSERT( aMapComponentToEntity.size() == aMapEntityToComponent.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentFlags.size() );
-	CH_ASSERT( aMapComponentToEntity.size() == aComponentIDs.size() );
-
-	auto it = aMapEntityToComponent.find( entity );
+	u32 index = GetIndex( entity );
 
-	if ( it == aMapEntityToComponent.end() )
+	if ( index == CH_ENT_COMP_INVALID )
 	{
 		Log_ErrorF( gLC_Entity, "Failed to mark Entity Component as predicted, Entity does not have this component - \"%s\"\n", apName );
 		return;
@@ -403,12 +404,12 @@ void EntityComponentPool::SetPredicted( Entity entity, bool sPredicted )
 	if ( sPredicted )
 	{
 		// We want this component predicted, add it to the prediction set
-		aComponentFlags[ it->second ] |= EEntityFlag_Predicted;
+		aDenseFlags[ index ] |= EEntityFlag_Predicted;
 	}
 	else
 	{
 		// We don't want this component predicted, remove the prediction flag from it
-		aComponentFlags[ it->second ] &= ~EEntityFlag_Predicted;
+		aDenseFlags[ index ] &= ~EEntityFlag_Predicted;
 	}
 }
 
@@ -417,15 +418,15 @@ bool EntityComponentPool::IsPredicted( Entity entity )
 {
 	PROF_SCOPE();
 
-	auto it = aMapEntityToComponent.find( entity );
+	u32 index = GetIndex( entity );
 
-	if ( it == aMapEntityToComponent.end() )
+	if ( index == CH_ENT_COMP_INVALID )
 	{
 		Log_ErrorF( gLC_Entity, "Failed to get Entity Component Flags, Entity does not have this component - \"%s\"\n", apName );
 		return false;
 	}
 
-	return aComponentFlags.at( it->second ) & EEntityFlag_Predicted;
+	return aDenseFlags[ index ] & EEntityFlag_Predicted;
 }
 
 
@@ -433,19 +434,19 @@ bool EntityComponentPool::IsPredicted( ComponentID_t sComponentID )
 {
 	PROF_SCOPE();
 
-	if ( sComponentID.aIndex > aComponentIDs.size() )
+	if ( sComponentID.aIndex >= aSlotToDense.size() || aSlotToDense[ sComponentID.aIndex ] == CH_ENT_COMP_INVALID )
 	{
 		Log_ErrorF( "Invalid Component ID: %zd\n", sComponentID.aIndex );
 		return false;
 	}
 
-	return aComponentFlags.at( sComponentID ) & EEntityFlag_Predicted;
+	return aDenseFlags[ aSlotToDense[ sComponentID.aIndex ] ] & EEntityFlag_Predicted;
 }
 
 
 // How Many Components are in this Pool?
 size_t EntityComponentPool::GetCount()
 {
-	return aComponentIDs.size();
+	return aDenseEntities.size();
 }
 
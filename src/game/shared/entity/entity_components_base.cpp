@@ -31,10 +31,10 @@ void Ent_RegisterVarHandlers()
 
 CH_STRUCT_REGISTER_COMPONENT( CRigidBody, rigidBody, EEntComponentNetType_Both, ECompRegFlag_None )
 {
-	EntComp_RegisterComponentVarEx< TYPE, glm::vec3 >( EEntNetField_Vec3, "vel", offsetof( TYPE, aVel ), ECompRegFlag_None );
+	EntComp_RegisterComponentVarEx< TYPE, glm::vec3 >( EEntNetField_Vec3, "vel", offsetof( TYPE, aVel ), ECompRegFlag_None, 1.f / 64.f );
 
 	//CH_REGISTER_COMPONENT_VAR2( EEntNetField_Vec3, glm::vec3, aVel, vel, ECompRegFlag_None );
-	CH_REGISTER_COMPONENT_VAR2( EEntNetField_Vec3, glm::vec3, aAccel, accel, ECompRegFlag_None );
+	CH_REGISTER_COMPONENT_VAR2_PREC( EEntNetField_Vec3, glm::vec3, aAccel, accel, ECompRegFlag_None, 1.f / 64.f );
 }
 
 
@@ -80,6 +80,9 @@ CH_STRUCT_REGISTER_COMPONENT( CLight, light, EEntComponentNetType_Both, ECompReg
 	CH_REGISTER_COMPONENT_VAR2( EEntNetField_Bool, bool, aShadow, shadow, ECompRegFlag_None );
 	CH_REGISTER_COMPONENT_VAR2( EEntNetField_Bool, bool, aEnabled, enabled, ECompRegFlag_None );
 	CH_REGISTER_COMPONENT_VAR2( EEntNetField_Bool, bool, aUseTransform, useTransform, ECompRegFlag_None );
+
+	// Lights reach past where they are
+	CH_REGISTER_COMPONENT_NET_PRIORITY( 2.f );
 	
 	CH_REGISTER_COMPONENT_SYS2( LightSystem, gLightEntSystems );
 }
@@ -124,18 +127,19 @@ void Ent_RegisterBaseComponents()
 	// Now Register Base Components
 	EntComp_RegisterComponent< CTransform >(
 	  "transform", EEntComponentNetType_Both,
-	  [ & ]()
+	  [ & ]( void* spMemory )
 	  {
-		  auto transform           = new CTransform;
+		  auto transform           = new ( spMemory ) CTransform;
 		  transform->aScale.Edit() = { 1.f, 1.f, 1.f };
 		  return transform;
 	  },
 	  [ & ]( void* spData )
-	  { delete (CTransform*)spData; } );
+	  { ( (CTransform*)spData )->~CTransform(); } );
 
-	EntComp_RegisterComponentVar< CTransform, glm::vec3 >( "pos", offsetof( CTransform, aPos ), 0 );
-	EntComp_RegisterComponentVar< CTransform, glm::vec3 >( "ang", offsetof( CTransform, aAng ), 0 );
-	EntComp_RegisterComponentVar< CTransform, glm::vec3 >( "scale", offsetof( CTransform, aScale ), 0 );
+	// Power of 2 precisions so the quantized values are exact
+	EntComp_RegisterComponentVar< CTransform, glm::vec3 >( "pos", offsetof( CTransform, aPos ), ECompRegFlag_Interpolate, 1.f / 512.f );
+	EntComp_RegisterComponentVar< CTransform, glm::vec3 >( "ang", offsetof( CTransform, aAng ), ECompRegFlag_Interpolate | ECompRegFlag_InterpAngles, 1.f / 64.f );
+	EntComp_RegisterComponentVar< CTransform, glm::vec3 >( "scale", offsetof( CTransform, aScale ), ECompRegFlag_Interpolate, 1.f / 1024.f );
 	CH_REGISTER_COMPONENT_SYS( CTransform, EntSys_Transform, gEntSys_Transform );
 
 	// CH_REGISTER_COMPONENT_RW( CRigidBody, rigidBody, true );
@@ -163,7 +167,7 @@ void Ent_RegisterBaseComponents()
 // Helper Functions
 ch_handle_t Ent_GetRenderableHandle( Entity sEntity )
 {
-	auto renderComp = Ent_GetComponent< CRenderable >( sEntity, "renderable" );
+	auto renderComp = Ent_GetComponent< CRenderable >( sEntity );
 
 	if ( !renderComp )
 	{
@@ -177,7 +181,7 @@ ch_handle_t Ent_GetRenderableHandle( Entity sEntity )
 
 Renderable_t* Ent_GetRenderable( Entity sEntity )
 {
-	auto renderComp = Ent_GetComponent< CRenderable >( sEntity, "renderable" );
+	auto renderComp = Ent_GetComponent< CRenderable >( sEntity );
 
 	if ( !renderComp )
 	{
@@ -192,7 +196,7 @@ Renderable_t* Ent_GetRenderable( Entity sEntity )
 // Requires the entity to have renderable component with a model path set
 Renderable_t* Ent_CreateRenderable( Entity sEntity )
 {
-	auto renderComp = Ent_GetComponent< CRenderable >( sEntity, "renderable" );
+	auto renderComp = Ent_GetComponent< CRenderable >( sEntity );
 
 	if ( !renderComp )
 	{
@@ -0,0 +1,345 @@
+#include "main.h"
+#include "game_shared.h"
+#include "entity_interp.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+#if CH_CLIENT
+
+LOG_CHANNEL( Entity );
+
+
+CONVAR_BOOL( cl_interpolate, 1, CVARF_ARCHIVE, "Blend remote entities between server updates instead of snapping to the newest one" );
+CONVAR_RANGE_FLOAT( cl_interp, 0.1, 0, 1, CVARF_ARCHIVE, "How far in the past remote entities are drawn in seconds, should cover at least two server updates" );
+CONVAR_RANGE_FLOAT( cl_extrapolate_max, 0.25, 0, 1, CVARF_ARCHIVE, "Most time in seconds we keep moving entities past the newest server update when updates stop coming in" );
+
+
+// If the server clock drifts from our estimate by more than this, it's reset instead of adjusted slowly
+constexpr double CH_ENT_INTERP_CLOCK_RESET  = 0.5;
+
+// How much of the difference between the estimated server clock and each new update is adjusted for
+constexpr double CH_ENT_INTERP_CLOCK_ADJUST = 0.1;
+
+
+// Server updates for one interpolated component on an entity, stored as a ring buffer
+struct EntInterpBuffer_t
+{
+	EntityComponentPool* apPool  = nullptr;
+	Entity               aEntity = CH_ENT_INVALID;
+
+	// Size of one sample, the packed interpolated vars of the component
+	size_t               aSize   = 0;
+
+	// Amount of samples stored, and the index of the newest one
+	u32                  aCount  = 0;
+	u32                  aHead   = 0;
+
+	double               aTimes[ CH_ENT_INTERP_SAMPLES ]{};
+	std::vector< u8 >    aData;
+
+	// 0 is the newest sample
+	u8* GetSample( u32 sAge )
+	{
+		return aData.data() + ( ( aHead + CH_ENT_INTERP_SAMPLES - sAge ) % CH_ENT_INTERP_SAMPLES ) * aSize;
+	}
+
+	double GetTime( u32 sAge ) const
+	{
+		return aTimes[ ( aHead + CH_ENT_INTERP_SAMPLES - sAge ) % CH_ENT_INTERP_SAMPLES ];
+	}
+};
+
+
+// [Entity << 32 | Component Type ID] = Buffer
+static std::unordered_map< u64, EntInterpBuffer_t > gEntInterpBuffers;
+
+// Server time of the newest update we read that had every relevant entity in it
+static double                                      gEntInterpLatestTime  = 0.0;
+
+// Estimated difference between the server clock and ours
+static double                                      gEntInterpClockOffset = 0.0;
+static bool                                        gEntInterpClockValid  = false;
+
+
+static void EntInterp_Pack( const EntComponentData_t* spRegData, const void* spData, u8* spOut )
+{
+	for ( const auto& [ offset, var ] : spRegData->aVars )
+	{
+		if ( !( var.aFlags & ECompRegFlag_Interpolate ) )
+			continue;
+
+		memcpy( spOut, (const char*)spData + offset, var.aSize );
+		spOut += var.aSize;
+	}
+}
+
+
+static void EntInterp_Unpack( const EntComponentData_t* spRegData, const u8* spSample, void* spData )
+{
+	for ( const auto& [ offset, var ] : spRegData->aVars )
+	{
+		if ( !( var.aFlags & ECompRegFlag_Interpolate ) )
+			continue;
+
+		memcpy( (char*)spData + offset, spSample, var.aSize );
+		spSample += var.aSize;
+	}
+}
+
+
+static float EntInterp_LerpAngle( float sFrom, float sTo, float sFrac )
+{
+	return sFrom + std::remainder( sTo - sFrom, 360.f ) * sFrac;
+}
+
+
+static void EntInterp_LerpFloats( const float* spFrom, const float* spTo, float* spOut, u32 sCount, float sFrac, bool sAngles )
+{
+	for ( u32 i = 0; i < sCount; i++ )
+		spOut[ i ] = sAngles ? EntInterp_LerpAngle( spFrom[ i ], spTo[ i ], sFrac ) : glm::mix( spFrom[ i ], spTo[ i ], sFrac );
+}
+
+
+// Blend two samples into the component, a fraction past 1 extrapolates
+static void EntInterp_Blend( const EntComponentData_t* spRegData, const u8* spFrom, const u8* spTo, float sFrac, void* spData )
+{
+	for ( const auto& [ offset, var ] : spRegData->aVars )
+	{
+		if ( !( var.aFlags & ECompRegFlag_Interpolate ) )
+			continue;
+
+		void* out    = (char*)spData + offset;
+		bool  angles = var.aFlags & ECompRegFlag_InterpAngles;
+
+		switch ( var.aType )
+		{
+			// Anything that can't be blended snaps over once we reach the newer sample
+			default:
+				memcpy( out, sFrac < 1.f ? spFrom : spTo, var.aSize );
+				break;
+
+			case EEntNetField_Float:
+				EntInterp_LerpFloats( (const float*)spFrom, (const float*)spTo, (float*)out, 1, sFrac, angles );
+				break;
+
+			case EEntNetField_Double:
+				*(double*)out = glm::mix( *(const double*)spFrom, *(const double*)spTo, (double)sFrac );
+				break;
+
+			case EEntNetField_Vec2:
+				EntInterp_LerpFloats( (const float*)spFrom, (const float*)spTo, (float*)out, 2, sFrac, angles );
+				break;
+
+			case EEntNetField_Color3:
+			case EEntNetField_Vec3:
+				EntInterp_LerpFloats( (const float*)spFrom, (const float*)spTo, (float*)out, 3, sFrac, angles );
+				break;
+
+			case EEntNetField_Color4:
+			case EEntNetField_Vec4:
+				EntInterp_LerpFloats( (const float*)spFrom, (const float*)spTo, (float*)out, 4, sFrac, angles );
+				break;
+
+			case EEntNetField_Quat:
+				*(glm::quat*)out = glm::slerp( *(const glm::quat*)spFrom, *(const glm::quat*)spTo, sFrac );
+				break;
+		}
+
+		spFrom += var.aSize;
+		spTo += var.aSize;
+	}
+}
+
+
+// Add a sample to the buffer and return where to write it
+static u8* EntInterp_PushSample( EntInterpBuffer_t& srBuffer, double sTime )
+{
+	srBuffer.aHead                    = ( srBuffer.aHead + 1 ) % CH_ENT_INTERP_SAMPLES;
+	srBuffer.aCount                   = std::min( srBuffer.aCount + 1, CH_ENT_INTERP_SAMPLES );
+	srBuffer.aTimes[ srBuffer.aHead ] = sTime;
+
+	return srBuffer.GetSample( 0 );
+}
+
+
+// Samples are copied straight into the component, so transforms have to be queued to rebuild their world matrix
+static void EntInterp_MarkChanged( EntInterpBuffer_t& srBuffer, EntityComponentPool* spTransformPool, void* spData )
+{
+	if ( srBuffer.apPool == spTransformPool )
+		Entity_MarkTransformChanged( *static_cast< CTransform* >( spData ) );
+}
+
+
+void EntInterp_RestoreLatest()
+{
+	PROF_SCOPE();
+
+	EntityComponentPool* transformPool = Entity_GetComponentPool< CTransform >();
+
+	for ( auto it = gEntInterpBuffers.begin(); it != gEntInterpBuffers.end(); )
+	{
+		EntInterpBuffer_t& buffer = it->second;
+		void*              data   = buffer.apPool->GetData( buffer.aEntity );
+
+		// The component or entity was removed
+		if ( !data )
+		{
+			it = gEntInterpBuffers.erase( it );
+			continue;
+		}
+
+		EntInterp_Unpack( buffer.apPool->GetRegistryData(), buffer.GetSample( 0 ), data );
+		EntInterp_MarkChanged( buffer, transformPool, data );
+		it++;
+	}
+}
+
+
+void EntInterp_AddSample( EntityComponentPool* spPool, Entity sEntity, const void* spData, double sServerTime )
+{
+	EntComponentData_t* regData = spPool->GetRegistryData();
+
+	// The local player is predicted instead
+	if ( !cl_interpolate || !regData || regData->aInterpSize == 0 || sEntity == gLocalPlayer )
+		return;
+
+	EntInterpBuffer_t& buffer = gEntInterpBuffers[ ( (u64)sEntity << 32 ) | regData->aTypeID ];
+
+	if ( buffer.aData.empty() )
+	{
+		buffer.apPool  = spPool;
+		buffer.aEntity = sEntity;
+		buffer.aSize   = regData->aInterpSize;
+		buffer.aData.resize( buffer.aSize * CH_ENT_INTERP_SAMPLES );
+	}
+
+	u8* sample = nullptr;
+
+	if ( buffer.aCount && buffer.GetTime( 0 ) >= sServerTime )
+	{
+		// Another update for the same time, like a full update, just replace it
+		sample = buffer.GetSample( 0 );
+	}
+	else
+	{
+		// Updates only have what changed, so if this wasn't in the last update, it was still sitting at the newest sample then
+		// Add that in, so we don't blend across the whole time it wasn't moving
+		if ( buffer.aCount && buffer.GetTime( 0 ) < gEntInterpLatestTime && gEntInterpLatestTime < sServerTime )
+		{
+			u8* holdSample = EntInterp_PushSample( buffer, gEntInterpLatestTime );
+			memcpy( holdSample, buffer.GetSample( 1 ), buffer.aSize );
+		}
+
+		sample = EntInterp_PushSample( buffer, sServerTime );
+	}
+
+	EntInterp_Pack( regData, spData, sample );
+}
+
+
+void EntInterp_FinishUpdate( double sServerTime, bool sPartial )
+{
+	// Entities left out of a partial update weren't sent because of the rate, not because they stopped
+	if ( !sPartial )
+		gEntInterpLatestTime = sServerTime;
+
+	double offset = sServerTime - gCurTime;
+
+	if ( !gEntInterpClockValid || std::abs( offset - gEntInterpClockOffset ) > CH_ENT_INTERP_CLOCK_RESET )
+	{
+		Log_DevF( gLC_Entity, 1, "Resetting Interpolation Clock, Offset From Server: %.3f seconds\n", offset );
+		gEntInterpClockOffset = offset;
+		gEntInterpClockValid  = true;
+		return;
+	}
+
+	gEntInterpClockOffset += ( offset - gEntInterpClockOffset ) * CH_ENT_INTERP_CLOCK_ADJUST;
+}
+
+
+void EntInterp_Update()
+{
+	PROF_SCOPE();
+
+	if ( !cl_interpolate )
+	{
+		gEntInterpBuffers.clear();
+		return;
+	}
+
+	if ( !gEntInterpClockValid )
+		return;
+
+	double               renderTime    = gCurTime + gEntInterpClockOffset - cl_interp;
+	EntityComponentPool* transformPool = Entity_GetComponentPool< CTransform >();
+
+	for ( auto& [ key, buffer ] : gEntInterpBuffers )
+	{
+		void* data = buffer.apPool->GetData( buffer.aEntity );
+
+		if ( !data || buffer.aCount == 0 )
+			continue;
+
+		// Every path below writes a sample into it
+		EntInterp_MarkChanged( buffer, transformPool, data );
+
+		EntComponentData_t* regData = buffer.apPool->GetRegistryData();
+		double              newest  = buffer.GetTime( 0 );
+
+		if ( buffer.aCount == 1 || renderTime <= buffer.GetTime( buffer.aCount - 1 ) )
+		{
+			EntInterp_Unpack( regData, buffer.GetSample( buffer.aCount - 1 ), data );
+			continue;
+		}
+
+		if ( renderTime >= newest )
+		{
+			// The server sent newer updates without this in them, so it stopped here
+			if ( newest < gEntInterpLatestTime )
+			{
+				EntInterp_Unpack( regData, buffer.GetSample( 0 ), data );
+				continue;
+			}
+
+			// We're past the newest update, keep it moving the way it was going for a bit
+			double time  = newest + std::min( renderTime - newest, (double)cl_extrapolate_max );
+			double older = buffer.GetTime( 1 );
+			float  frac  = ( time - older ) / ( newest - older );
+
+			EntInterp_Blend( regData, buffer.GetSample( 1 ), buffer.GetSample( 0 ), frac, data );
+			continue;
+		}
+
+		// Find the two samples around the render time
+		for ( u32 age = 1; age < buffer.aCount; age++ )
+		{
+			double from = buffer.GetTime( age );
+
+			if ( from > renderTime )
+				continue;
+
+			double to   = buffer.GetTime( age - 1 );
+			float  frac = ( renderTime - from ) / ( to - from );
+
+			EntInterp_Blend( regData, buffer.GetSample( age ), buffer.GetSample( age - 1 ), frac, data );
+			break;
+		}
+	}
+}
+
+
+void EntInterp_Clear()
+{
+	gEntInterpBuffers.clear();
+
+	gEntInterpLatestTime  = 0.0;
+	gEntInterpClockOffset = 0.0;
+	gEntInterpClockValid  = false;
+}
+
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "entity.h"
+
+
+// ====================================================================================================
+// Entity Interpolation
+// Client only, remote entities are drawn a little in the past, blended between the two server updates around that time
+// Vars registered with ECompRegFlag_Interpolate are buffered as updates come in, then written back blended every frame
+// If updates stop coming in, moving entities are extrapolated for a short amount of time before they stop
+// ====================================================================================================
+
+
+#if CH_CLIENT
+
+// Most server updates kept for each interpolated component
+constexpr u32 CH_ENT_INTERP_SAMPLES = 32;
+
+// Put the newest server values back on interpolated vars, so delta updates from the server are applied on top of them
+// Call this before reading component updates
+void          EntInterp_RestoreLatest();
+
+// Buffer the interpolated vars of a component the server just sent
+void          EntInterp_AddSample( EntityComponentPool* spPool, Entity sEntity, const void* spData, double sServerTime );
+
+// Called once all components in a server update are read
+// sPartial is set when the server left out relevant entities to fit our rate
+void          EntInterp_FinishUpdate( double sServerTime, bool sPartial );
+
+// Blend every buffered component to the current render time
+void          EntInterp_Update();
+
+// Drop everything buffered, call this when disconnecting
+void          EntInterp_Clear();
+
+#endif
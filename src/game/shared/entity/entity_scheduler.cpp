@@ -0,0 +1,461 @@
+#include "main.h"
+#include "game_shared.h"
+#include "entity_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+LOG_CHANNEL( Entity );
+
+
+CONVAR_BOOL( ent_sys_threaded, 1, "Update entity systems across worker threads" );
+CONVAR_RANGE_INT( ent_sys_threads, -1, -1, 64, "Amount of worker threads for entity systems, -1 to use what the host gives this DLL (takes effect on map load)" );
+
+
+// Counts down as jobs finish, a wait is done when this hits 0
+struct EntJobCounter_t
+{
+	std::atomic< u32 > aCount = 0;
+};
+
+
+using FEntJob = void( void* spData, u32 sStart, u32 sEnd );
+
+
+// Plain data, so queueing jobs doesn't allocate once the queue has grown
+struct EntJob_t
+{
+	FEntJob*         apFunc    = nullptr;
+	void*            apData    = nullptr;
+	u32              aStart    = 0;
+	u32              aEnd      = 0;
+	EntJobCounter_t* apCounter = nullptr;
+};
+
+
+struct EntSysBatch_t
+{
+	// Systems that need to be updated on the main thread
+	std::vector< IEntityComponentSystem* > aMainThread;
+
+	// Systems that can be updated on a worker thread
+	std::vector< IEntityComponentSystem* > aWorker;
+
+	// An earlier batch wrote to transforms this batch uses, so rebuild the world matrices before it
+	bool                                   aUpdateTransforms = false;
+};
+
+
+// Built batch info for a system
+struct EntSysSchedInfo_t
+{
+	IEntityComponentSystem* apSystem;
+	EntCompTypeID           aTypeID;
+	EntSysAccess_t          aAccess;
+	bool                    aDeclared;
+};
+
+
+static std::vector< std::thread >   gEntWorkers;
+static std::mutex                   gEntJobMutex;
+static std::condition_variable      gEntJobCond;
+static bool                         gEntWorkersRunning = false;
+
+// Jobs are taken from gEntJobNext onward, the queue is cleared once it's empty so the memory is reused
+static std::vector< EntJob_t >      gEntJobQueue;
+static size_t                       gEntJobNext        = 0;
+
+// Set by the host, used when ent_sys_threads is -1
+static u32                          gEntWorkerCount    = 0;
+
+static std::vector< EntSysBatch_t > gEntSysBatches;
+static bool                         gEntSysBatchesDirty = true;
+
+
+// ----------------------------------------------------------------------------------------------------
+// Worker Threads
+
+
+static void EntSched_RunJob( EntJob_t& srJob )
+{
+	srJob.apFunc( srJob.apData, srJob.aStart, srJob.aEnd );
+	srJob.apCounter->aCount.fetch_sub( 1, std::memory_order_acq_rel );
+}
+
+
+// Call with gEntJobMutex locked
+static bool EntSched_PopJob( EntJob_t& srJob )
+{
+	if ( gEntJobNext == gEntJobQueue.size() )
+		return false;
+
+	srJob = gEntJobQueue[ gEntJobNext++ ];
+
+	if ( gEntJobNext == gEntJobQueue.size() )
+	{
+		gEntJobQueue.clear();
+		gEntJobNext = 0;
+	}
+
+	return true;
+}
+
+
+static bool EntSched_TryRunJob()
+{
+	EntJob_t job;
+
+	{
+		std::unique_lock< std::mutex > lock( gEntJobMutex );
+
+		if ( !EntSched_PopJob( job ) )
+			return false;
+	}
+
+	EntSched_RunJob( job );
+	return true;
+}
+
+
+static void EntSched_WorkerMain()
+{
+	while ( true )
+	{
+		EntJob_t job;
+
+		{
+			std::unique_lock< std::mutex > lock( gEntJobMutex );
+			gEntJobCond.wait( lock, []() { return !gEntWorkersRunning || gEntJobNext < gEntJobQueue.size(); } );
+
+			if ( !EntSched_PopJob( job ) )
+				return;
+		}
+
+		EntSched_RunJob( job );
+	}
+}
+
+
+static void EntSched_Submit( EntJobCounter_t& srCounter, FEntJob* spFunc, void* spData, u32 sStart = 0, u32 sEnd = 0 )
+{
+	srCounter.aCount.fetch_add( 1, std::memory_order_relaxed );
+
+	{
+		std::unique_lock< std::mutex > lock( gEntJobMutex );
+		gEntJobQueue.push_back( { spFunc, spData, sStart, sEnd, &srCounter } );
+	}
+
+	gEntJobCond.notify_one();
+}
+
+
+// Wait for all jobs on this counter to finish, the calling thread helps out with queued jobs while waiting
+static void EntSched_Wait( EntJobCounter_t& srCounter )
+{
+	while ( srCounter.aCount.load( std::memory_order_acquire ) > 0 )
+	{
+		if ( !EntSched_TryRunJob() )
+			std::this_thread::yield();
+	}
+}
+
+
+static bool EntSched_Threaded()
+{
+	return ent_sys_threaded && gEntWorkers.size();
+}
+
+
+void EntSched_SetWorkerCount( u32 sCount )
+{
+	gEntWorkerCount = sCount;
+}
+
+
+void EntSched_Init()
+{
+	PROF_SCOPE();
+
+	if ( gEntWorkersRunning )
+		return;
+
+	u32 threadCount = ent_sys_threads < 0 ? gEntWorkerCount : ent_sys_threads;
+
+	gEntWorkersRunning = true;
+	gEntWorkers.reserve( threadCount );
+
+	for ( u32 i = 0; i < threadCount; i++ )
+		gEntWorkers.emplace_back( EntSched_WorkerMain );
+
+	gEntSysBatchesDirty = true;
+}
+
+
+void EntSched_Shutdown()
+{
+	PROF_SCOPE();
+
+	{
+		std::unique_lock< std::mutex > lock( gEntJobMutex );
+		gEntWorkersRunning = false;
+	}
+
+	gEntJobCond.notify_all();
+
+	for ( std::thread& worker : gEntWorkers )
+		worker.join();
+
+	gEntWorkers.clear();
+	gEntSysBatches.clear();
+	gEntSysBatchesDirty = true;
+}
+
+
+static void EntSched_RunParallelFor( void* spData, u32 sStart, u32 sEnd )
+{
+	( *static_cast< const FEntSched_ParallelFor* >( spData ) )( sStart, sEnd );
+}
+
+
+static void EntSched_RunSystem( void* spData, u32 sStart, u32 sEnd )
+{
+	static_cast< IEntityComponentSystem* >( spData )->Update();
+}
+
+
+u32 EntSched_GetWorkerCount()
+{
+	return gEntWorkers.size();
+}
+
+
+void EntSched_ParallelFor( u32 sCount, u32 sChunkSize, const FEntSched_ParallelFor& srFunc )
+{
+	if ( sCount == 0 )
+		return;
+
+	if ( sChunkSize == 0 )
+		sChunkSize = 1;
+
+	if ( !EntSched_Threaded() || sCount <= sChunkSize )
+	{
+		srFunc( 0, sCount );
+		return;
+	}
+
+	EntJobCounter_t counter;
+
+	// Keep the first chunk for the calling thread
+	for ( u32 start = sChunkSize; start < sCount; start += sChunkSize )
+	{
+		u32 end = std::min( start + sChunkSize, sCount );
+		EntSched_Submit( counter, EntSched_RunParallelFor, (void*)&srFunc, start, end );
+	}
+
+	srFunc( 0, sChunkSize );
+	EntSched_Wait( counter );
+}
+
+
+// ----------------------------------------------------------------------------------------------------
+// System Batches
+
+
+static bool EntSched_HasType( const std::vector< EntCompTypeID >& srTypes, EntCompTypeID sType )
+{
+	return std::find( srTypes.begin(), srTypes.end(), sType ) != srTypes.end();
+}
+
+
+static bool EntSched_Conflicts( const EntSysSchedInfo_t& srA, const EntSysSchedInfo_t& srB )
+{
+	// Undeclared systems could be touching anything
+	if ( !srA.aDeclared || !srB.aDeclared )
+		return true;
+
+	// Systems on the main thread already run one after the other
+	if ( ( srA.aAccess.aInterfaces & srB.aAccess.aInterfaces ) && ( srA.aAccess.aThreadSafe || srB.aAccess.aThreadSafe ) )
+		return true;
+
+	for ( EntCompTypeID type : srA.aAccess.aWrite )
+	{
+		if ( EntSched_HasType( srB.aAccess.aWrite, type ) || EntSched_HasType( srB.aAccess.aRead, type ) )
+			return true;
+	}
+
+	for ( EntCompTypeID type : srB.aAccess.aWrite )
+	{
+		if ( EntSched_HasType( srA.aAccess.aRead, type ) )
+			return true;
+	}
+
+	return false;
+}
+
+
+static void EntSched_BuildBatches()
+{
+	PROF_SCOPE();
+
+	gEntSysBatches.clear();
+
+	std::vector< EntSysSchedInfo_t > systems;
+
+	for ( EntityComponentPool* pool : EntSysData().aComponentPoolsByID )
+	{
+		if ( !pool || !pool->apComponentSystem )
+			continue;
+
+		EntSysSchedInfo_t& info = systems.emplace_back();
+		info.apSystem           = pool->apComponentSystem;
+		info.aTypeID            = pool->apData->aTypeID;
+		info.aDeclared          = info.apSystem->GetAccess( info.aAccess );
+
+		// A system always owns the component it manages
+		if ( !EntSched_HasType( info.aAccess.aWrite, pool->apData->aTypeID ) )
+			info.aAccess.aWrite.push_back( pool->apData->aTypeID );
+	}
+
+	// Put each system in the batch after the last one it conflicts with,
+	// so conflicting systems still update in the same order as before
+	std::vector< std::vector< EntSysSchedInfo_t* > > batchInfo;
+
+	for ( EntSysSchedInfo_t& info : systems )
+	{
+		size_t batchIndex = 0;
+
+		for ( size_t i = batchInfo.size(); i > 0; i-- )
+		{
+			bool conflicts = false;
+
+			for ( EntSysSchedInfo_t* other : batchInfo[ i - 1 ] )
+			{
+				if ( EntSched_Conflicts( info, *other ) )
+				{
+					conflicts = true;
+					break;
+				}
+			}
+
+			if ( conflicts )
+			{
+				batchIndex = i;
+				break;
+			}
+		}
+
+		if ( batchIndex == batchInfo.size() )
+		{
+			batchInfo.emplace_back();
+			gEntSysBatches.emplace_back();
+		}
+
+		batchInfo[ batchIndex ].push_back( &info );
+
+		if ( info.aAccess.aThreadSafe && info.aDeclared )
+			gEntSysBatches[ batchIndex ].aWorker.push_back( info.apSystem );
+		else
+			gEntSysBatches[ batchIndex ].aMainThread.push_back( info.apSystem );
+	}
+
+	// Systems like physics move entities, so the cached world matrices are out of date for anything after them
+	EntCompTypeID transformType   = EntComp_GetTypeID< CTransform >();
+	bool          transformsMoved = false;
+
+	for ( size_t i = 0; i < batchInfo.size(); i++ )
+	{
+		bool usesTransforms  = false;
+		bool movesTransforms = false;
+
+		for ( EntSysSchedInfo_t* info : batchInfo[ i ] )
+		{
+			// The transform system only owns the component, it doesn't move anything
+			bool writes = !info->aDeclared || ( EntSched_HasType( info->aAccess.aWrite, transformType ) && info->aTypeID != transformType );
+
+			usesTransforms  |= writes || EntSched_HasType( info->aAccess.aRead, transformType );
+			movesTransforms |= writes;
+		}
+
+		gEntSysBatches[ i ].aUpdateTransforms = transformsMoved && usesTransforms;
+
+		if ( gEntSysBatches[ i ].aUpdateTransforms )
+			transformsMoved = false;
+
+		transformsMoved |= movesTransforms;
+	}
+
+	gEntSysBatchesDirty = false;
+}
+
+
+void EntSched_Invalidate()
+{
+	gEntSysBatchesDirty = true;
+}
+
+
+void EntSched_UpdateSystems()
+{
+	PROF_SCOPE();
+
+	if ( gEntSysBatchesDirty )
+		EntSched_BuildBatches();
+
+	bool threaded = EntSched_Threaded();
+
+	for ( EntSysBatch_t& batch : gEntSysBatches )
+	{
+		EntJobCounter_t counter;
+
+		if ( batch.aUpdateTransforms )
+			Entity_UpdateWorldTransforms();
+
+		for ( IEntityComponentSystem* system : batch.aWorker )
+		{
+			if ( threaded )
+				EntSched_Submit( counter, EntSched_RunSystem, system );
+			else
+				system->Update();
+		}
+
+		for ( IEntityComponentSystem* system : batch.aMainThread )
+			system->Update();
+
+		EntSched_Wait( counter );
+	}
+}
+
+
+// ----------------------------------------------------------------------------------------------------
+
+
+GAME_CONCMD( ent_sys_dump_batches )
+{
+	if ( gEntSysBatchesDirty )
+		EntSched_BuildBatches();
+
+	log_t group = Log_GroupBegin( gLC_Entity );
+
+	Log_GroupF( group, "Worker Threads: %zd\n", gEntWorkers.size() );
+	Log_GroupF( group, "System Batches: %zd\n", gEntSysBatches.size() );
+
+	for ( size_t i = 0; i < gEntSysBatches.size(); i++ )
+	{
+		Log_GroupF( group, "\nBatch %zd\n", i );
+
+		if ( gEntSysBatches[ i ].aUpdateTransforms )
+			Log_GroupF( group, "    Rebuilds World Transforms\n" );
+
+		for ( IEntityComponentSystem* system : gEntSysBatches[ i ].aMainThread )
+			Log_GroupF( group, "    Main:   %s\n", system->apPool ? system->apPool->apName : "?" );
+
+		for ( IEntityComponentSystem* system : gEntSysBatches[ i ].aWorker )
+			Log_GroupF( group, "    Worker: %s\n", system->apPool ? system->apPool->apName : "?" );
+	}
+
+	Log_GroupEnd( group );
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "entity.h"
+
+#include <functional>
+
+
+// ====================================================================================================
+// Entity System Scheduler
+// Runs component systems in batches, systems in a batch have no conflicting component access
+// Thread safe systems are run on worker threads, while the rest are run on the main thread alongside them
+// ====================================================================================================
+
+
+// Called with a range of [sStart, sEnd) to work on
+using FEntSched_ParallelFor = std::function< void( u32 sStart, u32 sEnd ) >;
+
+
+// Amount of worker threads to start when ent_sys_threads is -1, the host splits the cores between the client and server DLLs
+void EntSched_SetWorkerCount( u32 sCount );
+
+// Start and stop the worker threads
+void EntSched_Init();
+void EntSched_Shutdown();
+
+// Rebuild the system batches on the next update, call this when component systems are added or removed
+void EntSched_Invalidate();
+
+// Update all component systems
+void EntSched_UpdateSystems();
+
+// Split the range [0, sCount) into chunks of sChunkSize and run them across the worker threads
+// Blocks until every chunk is done, and runs it all on the calling thread if threading is disabled or the range is small
+void EntSched_ParallelFor( u32 sCount, u32 sChunkSize, const FEntSched_ParallelFor& srFunc );
+
+// Amount of worker threads running, not including the main thread
+u32  EntSched_GetWorkerCount();
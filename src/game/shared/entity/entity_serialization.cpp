@@ -5,6 +5,7 @@
 #include "player.h"  // TEMP - for CPlayerMoveData
 
 #include "entity_systems.h"
+#include "entity_interp.h"
 #include "mapmanager.h"
 #include "igui.h"
 
@@ -12,11 +13,15 @@
 
 #include "game_physics.h"  // just for IPhysicsShape* and IPhysicsObject*
 
+#include "network/net_bitbuffer.h"
+
 
 LOG_CHANNEL( Entity );
 
 CONVAR_BOOL( ent_always_full_update, 0, "For debugging, always send a full update" );
 CONVAR_BOOL( ent_show_component_net_updates, 0, "Show Component Network Updates" );
+CONVAR_BOOL( ent_net_quantize, 1, "Quantize networked floats to the precision set on each component var" );
+CONVAR_RANGE_INT( ent_net_snapshot_history, 64, 2, 1024, "Amount of server ticks of removed entities and components kept for delta encoding, clients further behind than this may need a full update" );
 
 
 // Read and write from the network
@@ -44,7 +49,10 @@ void Entity_ReadEntityUpdates( const NetMsg_EntityUpdates* spMsg )
 			if ( entity != CH_ENT_INVALID )
 				Entity_DeleteEntity( entity );
 			else
-				Log_Error( gLC_Entity, "Trying to delete entity not in translation list\n" );
+			{
+				// Updates have every entity destroyed since the last one we acknowledged, so we may have already deleted it
+				Log_DevF( gLC_Entity, 2, "Trying to delete entity not in translation list: %zd\n", entId );
+			}
 
 			continue;
 		}
@@ -75,47 +83,108 @@ void Entity_ReadEntityUpdates( const NetMsg_EntityUpdates* spMsg )
 // TODO: redo this by having it loop through component pools, and not entitys
 // right now, it's doing a lot of entirely unnecessary checks
 // we can avoid those if we loop through the pools instead
-void Entity_WriteEntityUpdates( flatbuffers::FlatBufferBuilder& srBuilder )
+void Entity_WriteEntityUpdates( flatbuffers::FlatBufferBuilder& srBuilder, u32 sTick, u32 sBaselineTick, const EntRelevance_t* spRelevance )
 {
 	PROF_SCOPE();
 
 	CH_ASSERT( Entity_GetEntityCount() == EntSysData().aEntityFlags.size() );
 
-	std::vector< flatbuffers::Offset< NetMsg_EntityUpdate > > updateOut;
+	if ( ent_always_full_update )
+		sBaselineTick = 0;
+
+	// Kept around between calls so this doesn't allocate every tick
+	static std::vector< flatbuffers::Offset< NetMsg_EntityUpdate > > updateOut;
+	updateOut.clear();
 	updateOut.reserve( Entity_GetEntityCount() );
 
-	for ( auto& [ entity, flags ] : EntSysData().aEntityFlags )
+	// Entities destroyed since the baseline, a full update only needs the entities that exist
+	// These are sent even if they weren't relevant, the client skips ones it never had
+	if ( sBaselineTick )
 	{
-		// Make sure this and all the parents are networked
-		if ( !Entity_IsNetworked( entity, flags ) )
-			continue;
+		for ( const EntSnapshot_t& snapshot : EntSysData().aSnapshots )
+		{
+			if ( snapshot.aTick <= sBaselineTick || snapshot.aTick > sTick )
+				continue;
 
-		// NetMsg_EntityUpdateBuilder& update = updateBuilderList.emplace_back( srBuilder );
-		NetMsg_EntityUpdateBuilder update( srBuilder );
+			for ( Entity entity : snapshot.aDestroyedEntities )
+			{
+				// This entity ID is in use again
+				auto it = EntSysData().aEntityFlags.find( entity );
+				if ( it != EntSysData().aEntityFlags.end() && !( it->second & EEntityFlag_Destroyed ) )
+					continue;
 
-		update.add_id( entity );
+				NetMsg_EntityUpdateBuilder update( srBuilder );
+				update.add_id( entity );
+				update.add_destroyed( true );
+				updateOut.push_back( update.Finish() );
+			}
+		}
 
-		// Get Entity State
-		if ( flags & EEntityFlag_Destroyed )
+		// Entities that went out of range of this client are removed on their end until they come back
+		if ( spRelevance )
 		{
-			update.add_destroyed( true );
+			for ( Entity entity : spRelevance->aLeft )
+			{
+				if ( spRelevance->aEntities[ entity ].aLeftTick <= sBaselineTick )
+					continue;
+
+				NetMsg_EntityUpdateBuilder update( srBuilder );
+				update.add_id( entity );
+				update.add_destroyed( true );
+				updateOut.push_back( update.Finish() );
+			}
 		}
+	}
+
+	auto writeEntity = [ & ]( Entity sEntity, EEntityFlag sFlags )
+	{
+		NetMsg_EntityUpdateBuilder update( srBuilder );
+
+		update.add_id( sEntity );
+
+		// doesn't matter if it returns CH_ENT_INVALID
+		if ( sFlags & EEntityFlag_Parented )
+			update.add_parent( Entity_GetParent( sEntity ) );
 		else
+			update.add_parent( CH_ENT_INVALID );
+
+		updateOut.push_back( update.Finish() );
+	};
+
+	if ( spRelevance )
+	{
+		// Only the entities the component updates got to
+		for ( u32 i = 0; i < spRelevance->aSendCount && i < spRelevance->aSendOrder.size(); i++ )
 		{
-			// doesn't matter if it returns CH_ENT_INVALID
-			if ( flags & EEntityFlag_Parented )
-				update.add_parent( Entity_GetParent( entity ) );
-			else
-				update.add_parent( CH_ENT_INVALID );
+			Entity entity = spRelevance->aSendOrder[ i ];
+			auto   it     = EntSysData().aEntityFlags.find( entity );
+
+			if ( it == EntSysData().aEntityFlags.end() || ( it->second & EEntityFlag_Destroyed ) || !Entity_IsNetworked( entity, it->second ) )
+				continue;
+
+			writeEntity( entity, it->second );
 		}
+	}
+	else
+	{
+		for ( auto& [ entity, flags ] : EntSysData().aEntityFlags )
+		{
+			// Destroyed entities are written from the snapshot history above
+			if ( flags & EEntityFlag_Destroyed )
+				continue;
 
-		updateOut.push_back( update.Finish() );
-		// srBuilder.Finish( update.Finish() );
+			// Make sure this and all the parents are networked
+			if ( !Entity_IsNetworked( entity, flags ) )
+				continue;
+
+			writeEntity( entity, flags );
+		}
 	}
 
 	auto                        vec = srBuilder.CreateVector( updateOut );
 
 	NetMsg_EntityUpdatesBuilder updatesBuilder( srBuilder );
+	updatesBuilder.add_tick( sTick );
 	updatesBuilder.add_update_list( vec );
 
 	srBuilder.Finish( updatesBuilder.Finish() );
@@ -128,122 +197,153 @@ void Entity_WriteEntityUpdates( flatbuffers::FlatBufferBuilder& srBuilder )
 //}
 
 
-void ReadComponent( flexb::Reference& spSrc, EntComponentData_t* spRegData, void* spData )
+// ----------------------------------------------------------------------------------------------------
+// Component Data Format
+//
+// Bit packed, for each networked var in registry order:
+//   1 bit   - var is dirty, always set on a full update
+//   then if dirty:
+//   Bool    - 1 bit
+//   Float   - quantized to the var precision and sent as a varint, or a full float if it has no precision
+//   Double  - 64 bits
+//   Ints    - varint, signed ints are zigzag encoded
+//   Entity  - varint of the entity + 1, so CH_ENT_INVALID is 0
+//   String  - varint length, then the characters
+//   Vectors - one bit per float that changed, then each changed float like the Float type above
+//
+// A var is dirty if it changed after the tick the client acknowledged, see Entity_RecordSnapshot()
+
+
+// Get the dirty state stored after the value in a ComponentNetVar
+inline bool* EntComp_GetVarDirty( const void* spData, size_t sOffset, const EntComponentVarData_t& srVar )
 {
-	PROF_SCOPE();
+	return (bool*)( (char*)spData + sOffset + srVar.aSize );
+}
 
-	// Get the vector i guess
-	auto   vector    = spSrc.AsVector();
-	size_t i         = 0;
-	size_t curOffset = 0;
 
-	for ( const auto& [ offset, var ] : spRegData->aVars )
+inline u8* EntComp_GetVarDirtyLanes( const void* spData, size_t sOffset, const EntComponentVarData_t& srVar )
+{
+	return (u8*)( (char*)spData + sOffset + srVar.aSize + 1 );
+}
+
+
+static void ReadComponentLanes( NetBitReader& srReader, float sPrecision, float* spValues, u32 sLaneCount )
+{
+	u8 lanes = srReader.ReadBits( sLaneCount );
+
+	for ( u32 lane = 0; lane < sLaneCount; lane++ )
 	{
-		if ( var.aFlags & ECompRegFlag_LocalVar )
-		{
-			curOffset += var.aSize + offset;
-			continue;
-		}
+		if ( lanes & ( 1 << lane ) )
+			spValues[ lane ] = srReader.ReadQuantizedFloat( sPrecision );
+	}
+}
 
-		// size_t offset = EntComp_GetVarDirtyOffset( (char*)spData, var.aType );
-		void* data = ( (char*)spData ) + offset;
-		// curOffset += var.aSize + offset;
 
-		// Check these first
-		switch ( var.aType )
-		{
-			case EEntNetField_Invalid:
-				continue;
+static void WriteComponentLanes( NetBitWriter& srWriter, float sPrecision, const float* spValues, u32 sLaneCount, u8 sLanes )
+{
+	srWriter.WriteBits( sLanes, sLaneCount );
 
-			case EEntNetField_Bool:
-			{
-				bool* value = static_cast< bool* >( data );
-				*value      = vector[ i++ ].AsBool();
-				continue;
-			}
-		}
+	for ( u32 lane = 0; lane < sLaneCount; lane++ )
+	{
+		if ( sLanes & ( 1 << lane ) )
+			srWriter.WriteQuantizedFloat( spValues[ lane ], sPrecision );
+	}
+}
+
+
+static u32 GetComponentVarLaneCount( EEntNetField sType )
+{
+	switch ( sType )
+	{
+		default:
+			return 0;
+
+		case EEntNetField_Vec2:
+			return 2;
+
+		case EEntNetField_Color3:
+		case EEntNetField_Vec3:
+			return 3;
+
+		case EEntNetField_Color4:
+		case EEntNetField_Vec4:
+		case EEntNetField_Quat:
+			return 4;
+	}
+}
+
+
+bool ReadComponent( NetBitReader& srReader, EntComponentData_t* spRegData, void* spData )
+{
+	PROF_SCOPE();
 
-		// Now, check if we wrote data for this var
-		bool wroteVar = vector[ i++ ].AsBool();
+	for ( const auto& [ offset, var ] : spRegData->aVars )
+	{
+		if ( var.aFlags & ECompRegFlag_LocalVar )
+			continue;
 
-		if ( !wroteVar )
+		if ( var.aType == EEntNetField_Invalid )
 			continue;
 
-		CH_ASSERT( var.aType != EEntNetField_Invalid );
-		CH_ASSERT( var.aType != EEntNetField_Bool );
+		// Did we write data for this var?
+		if ( !srReader.ReadBit() )
+			continue;
+
+		void* data = ( (char*)spData ) + offset;
 
 		switch ( var.aType )
 		{
 			default:
 				break;
 
+			case EEntNetField_Bool:
+				*(bool*)( data ) = srReader.ReadBit();
+				break;
+
 			case EEntNetField_Float:
-			{
-				auto value = (float*)( data );
-				*value     = vector[ i++ ].AsFloat();
+				*(float*)( data ) = srReader.ReadQuantizedFloat( var.aPrecision );
 				break;
-			}
+
 			case EEntNetField_Double:
-			{
-				auto value = (double*)( data );
-				*value     = vector[ i++ ].AsDouble();
+				*(double*)( data ) = srReader.ReadDouble();
 				break;
-			}
 
 			case EEntNetField_S8:
-			{
-				auto value = (s8*)( data );
-				*value     = vector[ i++ ].AsInt8();
+				*(s8*)( data ) = (s8)srReader.ReadVarSInt();
 				break;
-			}
+
 			case EEntNetField_S16:
-			{
-				auto value = (s16*)( data );
-				*value     = vector[ i++ ].AsInt16();
+				*(s16*)( data ) = (s16)srReader.ReadVarSInt();
 				break;
-			}
+
 			case EEntNetField_S32:
-			{
-				auto value = (s32*)( data );
-				*value     = vector[ i++ ].AsInt32();
+				*(s32*)( data ) = (s32)srReader.ReadVarSInt();
 				break;
-			}
+
 			case EEntNetField_S64:
-			{
-				auto value = (s64*)( data );
-				*value     = vector[ i++ ].AsInt64();
+				*(s64*)( data ) = srReader.ReadVarSInt();
 				break;
-			}
 
 			case EEntNetField_U8:
-			{
-				auto value = (u8*)( data );
-				*value     = vector[ i++ ].AsUInt8();
+				*(u8*)( data ) = (u8)srReader.ReadVarUInt();
 				break;
-			}
+
 			case EEntNetField_U16:
-			{
-				auto value = (u16*)( data );
-				*value     = vector[ i++ ].AsUInt16();
+				*(u16*)( data ) = (u16)srReader.ReadVarUInt();
 				break;
-			}
+
 			case EEntNetField_U32:
-			{
-				auto value = (u32*)( data );
-				*value     = vector[ i++ ].AsUInt32();
+				*(u32*)( data ) = (u32)srReader.ReadVarUInt();
 				break;
-			}
+
 			case EEntNetField_U64:
-			{
-				auto value = (u64*)( data );
-				*value     = vector[ i++ ].AsUInt64();
+				*(u64*)( data ) = srReader.ReadVarUInt();
 				break;
-			}
 
 			case EEntNetField_Entity:
 			{
 				auto value      = (Entity*)( data );
-				auto recvEntity = (Entity)( vector[ i++ ].AsUInt64() );
+				auto recvEntity = (Entity)( srReader.ReadVarUInt() ) - 1;
 
 				if ( recvEntity == CH_ENT_INVALID )
 				{
@@ -266,518 +366,536 @@ void ReadComponent( flexb::Reference& spSrc, EntComponentData_t* spRegData, void
 			}
 
 			case EEntNetField_StdString:
-			{
-				auto value = (std::string*)( data );
-				*value     = vector[ i++ ].AsString().str();
+				*(std::string*)( data ) = srReader.ReadString();
 				break;
-			}
-
-				// Will have a special case for these once i have each value in a vecX marked dirty
 
 			case EEntNetField_Vec2:
-			{
-				auto value = (glm::vec2*)( data );
-				value->x   = vector[ i++ ].AsFloat();
-				value->y   = vector[ i++ ].AsFloat();
-				break;
-			}
-			case EEntNetField_Color3:
 			case EEntNetField_Vec3:
-			{
-				auto value = (glm::vec3*)( data );
-
-				// auto typedVector = vector[ i++ ].AsTypedVector();
-				// CH_ASSERT( typedVector.size() == 3 );
-				// 
-				// value->x = typedVector[ 0 ].AsFloat();
-				// value->y = typedVector[ 1 ].AsFloat();
-				// value->z = typedVector[ 2 ].AsFloat();
-
-				value->x   = vector[ i++ ].AsFloat();
-				value->y   = vector[ i++ ].AsFloat();
-				value->z   = vector[ i++ ].AsFloat();
-				break;
-			}
-			case EEntNetField_Color4:
 			case EEntNetField_Vec4:
-			{
-				auto value = (glm::vec4*)( data );
-				value->x   = vector[ i++ ].AsFloat();
-				value->y   = vector[ i++ ].AsFloat();
-				value->z   = vector[ i++ ].AsFloat();
-				value->w   = vector[ i++ ].AsFloat();
-				break;
-			}
-
 			case EEntNetField_Quat:
-			{
-				auto value = (glm::quat*)( data );
-				value->x   = vector[ i++ ].AsFloat();
-				value->y   = vector[ i++ ].AsFloat();
-				value->z   = vector[ i++ ].AsFloat();
-				value->w   = vector[ i++ ].AsFloat();
+			case EEntNetField_Color3:
+			case EEntNetField_Color4:
+				ReadComponentLanes( srReader, var.aPrecision, (float*)data, GetComponentVarLaneCount( var.aType ) );
 				break;
-			}
 		}
 	}
+
+	if ( srReader.aOverflow )
+	{
+		Log_ErrorF( gLC_Entity, "Component data for \"%s\" was too short\n", spRegData->apName );
+		return false;
+	}
+
+	return true;
 }
 
 
-bool WriteComponent( flexb::Builder& srBuilder, EntComponentData_t* spRegData, const void* spData, bool sFullUpdate )
+// Write the vars that changed after sBaselineTick, or every var if spVarTicks is nullptr
+// spVarTicks has CH_ENT_VAR_LANE_COUNT ticks for each networked var, from EntityComponentPool::aSlotVarTicks
+bool WriteComponent( NetBitWriter& srWriter, EntComponentData_t* spRegData, const void* spData, const u32* spVarTicks, u32 sBaselineTick )
 {
 	PROF_SCOPE();
 
-	bool   wroteData = false;
-	size_t curOffset = 0;
-	size_t flexVec   = srBuilder.StartVector();
+	bool wroteData = false;
+	u32  varIndex  = 0;
 
 	for ( const auto& [ offset, var ] : spRegData->aVars )
 	{
 		if ( var.aFlags & ECompRegFlag_LocalVar )
 			continue;
 
-		PROF_SCOPE();
-		CH_PROF_ZONE_NAME( var.apName, var.aNameLen );
+		if ( var.aType == EEntNetField_Invalid )
+			continue;
 
-		auto IsVarDirty = [ & ]( bool isBool = false )
-		{
-			// We always write this if it's a full update
-			if ( sFullUpdate )
-			{
-				wroteData = true;
+		u32 laneCount = GetComponentVarLaneCount( var.aType );
+		u8  lanes     = CH_ENT_VAR_LANES_ALL;
 
-				if ( !isBool )
-					srBuilder.Bool( true );
+		if ( spVarTicks )
+		{
+			const u32* laneTicks = spVarTicks + varIndex * CH_ENT_VAR_LANE_COUNT;
+			lanes                = 0;
 
-				return true;
+			for ( u32 lane = 0; lane < std::max( laneCount, 1u ); lane++ )
+			{
+				if ( laneTicks[ lane ] > sBaselineTick )
+					lanes |= 1 << lane;
 			}
+		}
 
-			char* dataChar = (char*)spData;
-			bool isDirty  = *reinterpret_cast< bool* >( dataChar + var.aSize + offset );
-			
-			wroteData |= isDirty;
+		varIndex++;
 
-			if ( isBool )
-				return true;
+		bool isDirty = lanes != 0;
+		srWriter.WriteBit( isDirty );
 
-			{
-				srBuilder.Bool( isDirty );
-				return isDirty;
-			}
+		if ( !isDirty )
+			continue;
 
-		};
-
-		void* data = ( (char*)spData ) + offset;
+		wroteData       = true;
+		void* data      = ( (char*)spData ) + offset;
+		float precision = ent_net_quantize ? var.aPrecision : 0.f;
 
 		switch ( var.aType )
 		{
 			default:
-				srBuilder.Bool( false );
-				break;
-
-			case EEntNetField_Invalid:
 				break;
 
 			case EEntNetField_Bool:
-			{
-				if ( IsVarDirty( true ) )
-				{
-					auto value = *(bool*)( data );
-					srBuilder.Bool( value );
-					wroteData = true;
-				}
+				srWriter.WriteBit( *(bool*)( data ) );
 				break;
-			}
 
 			case EEntNetField_Float:
-			{
-				if ( IsVarDirty() )
-				{
-					auto value = *(float*)( data );
-					srBuilder.Float( value );
-				}
-				
+				srWriter.WriteQuantizedFloat( *(float*)( data ), precision );
 				break;
-			}
+
 			case EEntNetField_Double:
-			{
-				if ( IsVarDirty() )
-				{
-					auto value = *(double*)( data );
-					srBuilder.Double( value );
-				}
-				
+				srWriter.WriteDouble( *(double*)( data ) );
 				break;
-			}
 
 			case EEntNetField_S8:
-			{
-				// FLEX BUFFERS STORES ALL INTS AND UINTS AS INT64 AND UINT64, WHAT A WASTE OF SPACE
-				if ( IsVarDirty() )
-				{
-					auto value = *(s8*)( data );
-					srBuilder.Add( value );
-				}
-
+				srWriter.WriteVarSInt( *(s8*)( data ) );
 				break;
-			}
-			case EEntNetField_S16:
-			{
-				if ( IsVarDirty() )
-				{
-					auto value = *(s16*)( data );
-					srBuilder.Add( value );
-				}
 
+			case EEntNetField_S16:
+				srWriter.WriteVarSInt( *(s16*)( data ) );
 				break;
-			}
-			case EEntNetField_S32:
-			{
-				if ( IsVarDirty() )
-				{
-					auto value = *(s32*)( data );
-					srBuilder.Add( value );
-				}
 
+			case EEntNetField_S32:
+				srWriter.WriteVarSInt( *(s32*)( data ) );
 				break;
-			}
-			case EEntNetField_S64:
-			{
-				if ( IsVarDirty() )
-				{
-					auto value = *(s64*)( data );
-					srBuilder.Add( value );
-				}
 
+			case EEntNetField_S64:
+				srWriter.WriteVarSInt( *(s64*)( data ) );
 				break;
-			}
 
 			case EEntNetField_U8:
-			{
-				// FLEX BUFFERS STORES ALL INTS AND UINTS AS INT64 AND UINT64, WHAT A WASTE OF SPACE
-				if ( IsVarDirty() )
-				{
-					auto value = *(u8*)( data );
-					srBuilder.Add( value );
-				}
-
+				srWriter.WriteVarUInt( *(u8*)( data ) );
 				break;
-			}
-			case EEntNetField_U16:
-			{
-				if ( IsVarDirty() )
-				{
-					auto value = *(u16*)( data );
-					srBuilder.Add( value );
-				}
 
+			case EEntNetField_U16:
+				srWriter.WriteVarUInt( *(u16*)( data ) );
 				break;
-			}
-			case EEntNetField_U32:
-			{
-				if ( IsVarDirty() )
-				{
-					auto value = *(u32*)( data );
-					srBuilder.Add( value );
-				}
 
+			case EEntNetField_U32:
+				srWriter.WriteVarUInt( *(u32*)( data ) );
 				break;
-			}
-			case EEntNetField_U64:
-			{
-				if ( IsVarDirty() )
-				{
-					auto value = *(u64*)( data );
-					srBuilder.Add( value );
-				}
 
+			case EEntNetField_U64:
+				srWriter.WriteVarUInt( *(u64*)( data ) );
 				break;
-			}
 
 			case EEntNetField_Entity:
-			{
-				if ( IsVarDirty() )
-				{
-					auto value = *(Entity*)( data );
-					srBuilder.Add( value );
-				}
-
+				// CH_ENT_INVALID wraps around to 0 here
+				srWriter.WriteVarUInt( *(Entity*)( data ) + 1 );
 				break;
-			}
 
 			case EEntNetField_StdString:
-			{
-				if ( IsVarDirty() )
-				{
-					auto value = (const std::string*)( data );
-					srBuilder.Add( value->c_str() );
-				}
-
+				srWriter.WriteString( *(const std::string*)( data ) );
 				break;
-			}
-
-			// Will have a special case for these once i have each value in a vecX marked dirty
 
 			case EEntNetField_Vec2:
-			{
-				if ( IsVarDirty() )
-				{
-					const glm::vec2* value = (const glm::vec2*)( data );
-					srBuilder.Add( value->x );
-					srBuilder.Add( value->y );
-				}
-
-				break;
-			}
-			case EEntNetField_Color3:
 			case EEntNetField_Vec3:
-			{
-				if ( IsVarDirty() )
-				{
-					const glm::vec3* value = (const glm::vec3*)( data );
-
-					// no idea if this is better or worse
-					// std::vector< float > float3;
-					// float3.reserve( 3 );
-					// float3.push_back( value->x );
-					// float3.push_back( value->y );
-					// float3.push_back( value->z );
-					// srBuilder.Add( float3 );
-
-					srBuilder.Add( value->x );
-					srBuilder.Add( value->y );
-					srBuilder.Add( value->z );
-				}
-
-				break;
-			}
-			case EEntNetField_Color4:
 			case EEntNetField_Vec4:
-			{
-				if ( IsVarDirty() )
-				{
-					const glm::vec4* value = (const glm::vec4*)( data );
-					srBuilder.Add( value->x );
-					srBuilder.Add( value->y );
-					srBuilder.Add( value->z );
-					srBuilder.Add( value->w );
-				}
-
-				break;
-			}
-
 			case EEntNetField_Quat:
-			{
-				if ( IsVarDirty() )
-				{
-					const glm::quat* value = (const glm::quat*)( data );
-					srBuilder.Add( value->x );
-					srBuilder.Add( value->y );
-					srBuilder.Add( value->z );
-					srBuilder.Add( value->w );
-				}
-
+			case EEntNetField_Color3:
+			case EEntNetField_Color4:
+				WriteComponentLanes( srWriter, precision, (const float*)data, laneCount, lanes );
 				break;
-			}
 		}
 	}
 
-	if ( !wroteData )
-		return false;
+	return wroteData;
+}
+
+
+// ----------------------------------------------------------------------------------------------------
+// Snapshot History
+//
+// Every server tick records the tick each component was created on, and the tick each lane of each var last changed on
+// Removals can't be tracked like that, so those are kept in a ring buffer of the last ent_net_snapshot_history ticks
+// Each client is sent everything that changed after the last tick it acknowledged, so a lost packet is covered by the next one
+
+
+static void Entity_RecordPoolSnapshot( EntityComponentPool* spPool, u32 sTick, EntSnapshot_t& srSnapshot )
+{
+	PROF_SCOPE();
+
+	EntComponentData_t* regData   = spPool->GetRegistryData();
+	size_t              slotTicks = spPool->aNetVarCount * CH_ENT_VAR_LANE_COUNT;
 
+	// Cover any new slots, these start at 0 so they get recorded as created
+	if ( spPool->aSlotCreatedTicks.size() < spPool->aSlotToDense.size() )
 	{
-		PROF_SCOPE_NAMED( "EndVector" );
-		srBuilder.EndVector( flexVec, false, false );
+		spPool->aSlotCreatedTicks.resize( spPool->aSlotToDense.size(), 0 );
+		spPool->aSlotVarTicks.resize( spPool->aSlotToDense.size() * slotTicks, 0 );
 	}
 
-	return wroteData;
+	for ( size_t compIndex = 0; compIndex < spPool->GetCount(); compIndex++ )
+	{
+		Entity      entity    = spPool->aDenseEntities[ compIndex ];
+		EEntityFlag compFlags = spPool->aDenseFlags[ compIndex ];
+
+		if ( compFlags & EEntityFlag_Destroyed )
+		{
+			EEntityFlag entFlags = EntSysData().aEntityFlags.at( entity );
+
+			// Destroying the entity already removes all of it's components on the client
+			if ( !( entFlags & EEntityFlag_Destroyed ) && !( compFlags & EEntityFlag_Local ) && Entity_IsNetworked( entity, entFlags ) )
+				srSnapshot.aRemovedComponents.push_back( { spPool, entity } );
+
+			continue;
+		}
+
+		u32   slot     = spPool->aDenseIDs[ compIndex ].aIndex;
+		void* data     = spPool->GetSlotData( slot );
+		u32*  varTicks = spPool->aSlotVarTicks.data() + slot * slotTicks;
+		bool  created  = spPool->aSlotCreatedTicks[ slot ] == 0;
+
+		if ( created )
+		{
+			spPool->aSlotCreatedTicks[ slot ] = sTick;
+			std::fill_n( varTicks, slotTicks, sTick );
+		}
+
+		u32 varIndex = 0;
+
+		for ( const auto& [ offset, var ] : regData->aVars )
+		{
+			if ( var.aFlags & ECompRegFlag_LocalVar )
+				continue;
+
+			if ( var.aType == EEntNetField_Invalid )
+				continue;
+
+			u32*  laneTicks = varTicks + varIndex * CH_ENT_VAR_LANE_COUNT;
+			bool* dirty     = EntComp_GetVarDirty( data, offset, var );
+			u8*   lanes     = EntComp_GetVarDirtyLanes( data, offset, var );
+
+			varIndex++;
+
+			if ( *dirty && !created )
+			{
+				// If something marked this dirty without going through Set(), we don't know what changed, so mark it all
+				u8 changed = *lanes ? *lanes : CH_ENT_VAR_LANES_ALL;
+
+				for ( u32 lane = 0; lane < CH_ENT_VAR_LANE_COUNT; lane++ )
+				{
+					if ( changed & ( 1 << lane ) )
+						laneTicks[ lane ] = sTick;
+				}
+			}
+
+			*dirty = false;
+			*lanes = 0;
+		}
+	}
 }
 
 
-void Entity_WriteComponentUpdates( fb::FlatBufferBuilder& srRootBuilder, bool sFullUpdate )
+void Entity_RecordSnapshot( u32 sTick )
 {
 	PROF_SCOPE();
 
-	std::vector< fb::Offset< NetMsg_ComponentUpdate > > componentsBuilt;
-	componentsBuilt.reserve( EntSysData().aComponentPools.size() );
+	EntitySystemData& data = EntSysData();
 
-	size_t i = 0;
-	size_t poolCount = 0;
+	// Start the history over if the size changed, we lose every removal before this tick
+	if ( data.aSnapshots.size() != (size_t)ent_net_snapshot_history )
+	{
+		data.aSnapshots.clear();
+		data.aSnapshots.resize( ent_net_snapshot_history );
+		data.aSnapshotLostTick = sTick - 1;
+	}
 
-	flexb::Builder flexBuilder;
+	EntSnapshot_t& snapshot = data.aSnapshots[ sTick % data.aSnapshots.size() ];
 
-	for ( auto& [ poolName, pool ] : EntSysData().aComponentPools )
+	// We are about to overwrite the oldest tick, so nothing before it can be delta encoded against anymore
+	if ( snapshot.aDestroyedEntities.size() || snapshot.aRemovedComponents.size() )
+		data.aSnapshotLostTick = std::max( data.aSnapshotLostTick, snapshot.aTick );
+
+	snapshot.aTick = sTick;
+	snapshot.aDestroyedEntities.clear();
+	snapshot.aRemovedComponents.clear();
+
+	for ( auto& [ entity, flags ] : data.aEntityFlags )
+	{
+		if ( ( flags & EEntityFlag_Destroyed ) && Entity_IsNetworked( entity, flags ) )
+			snapshot.aDestroyedEntities.push_back( entity );
+	}
+
+	for ( auto& [ poolName, pool ] : data.aComponentPools )
 	{
-		// If there are no components in existence, don't even bother to send anything here
-		if ( !pool->aMapComponentToEntity.size() )
+		if ( pool->GetRegistryData()->aNetType != EEntComponentNetType_Both )
 			continue;
 
-		PROF_SCOPE_NAMED( "Pool" );
+		Entity_RecordPoolSnapshot( pool, sTick, snapshot );
+	}
+}
 
-		EntComponentData_t* regData = pool->GetRegistryData();
-		CH_PROF_ZONE_NAME( regData->apName, regData->aNameLen );
 
-		// if ( regData->aNetType != EEntComponentNetType_Both || regData->aNetType != EEntComponentNetType_Server )
-		if ( regData->aNetType != EEntComponentNetType_Both )
-			continue;
+bool Entity_CanDeltaFrom( u32 sBaselineTick )
+{
+	if ( sBaselineTick == 0 || ent_always_full_update )
+		return false;
 
-		poolCount++;
+	return sBaselineTick >= EntSysData().aSnapshotLostTick;
+}
 
-		std::vector< fb::Offset< NetMsg_ComponentUpdateData > > componentDataBuilt;
 
-		bool                                                    builtUpdateList = false;
-		bool                                                    wroteData       = false;
+// Write one component in a pool if anything on it changed after sBaselineTick, returns false if there was nothing to send
+static bool Entity_WriteComponentUpdate( fb::FlatBufferBuilder& srRootBuilder, EntityComponentPool* spPool, size_t sIndex, u32 sBaselineTick, std::vector< fb::Offset< NetMsg_ComponentUpdateData > >& srOut )
+{
+	// Kept around between calls so it doesn't need to allocate memory every tick
+	static NetBitWriter bitWriter;
 
-		componentDataBuilt.reserve( pool->aMapComponentToEntity.size() );
+	PROF_SCOPE_NAMED( "Entity" );
 
-		size_t compListI = 0;
-		for ( auto& [ componentID, entity ] : pool->aMapComponentToEntity )
-		{
-			PROF_SCOPE_NAMED( "Entity" );
+	Entity      entity    = spPool->aDenseEntities[ sIndex ];
+	EEntityFlag compFlags = spPool->aDenseFlags[ sIndex ];
 
-			EEntityFlag entFlags = EntSysData().aEntityFlags.at( entity );
+	// Skip components being removed, those are sent from the snapshot history
+	if ( compFlags & ( EEntityFlag_Local | EEntityFlag_Destroyed ) )
+		return false;
 
-			// skip the IsNetworked or CanSaveToMap call
-			if ( entFlags & EEntityFlag_Destroyed )
-			{
-				// Don't bother sending data if we're about to be destroyed
-				compListI++;
-				continue;
-			}
+	EntComponentData_t* regData     = spPool->GetRegistryData();
+
+	// Only missing if Entity_RecordSnapshot() wasn't called, so send everything
+	bool                haveTicks   = spPool->aSlotCreatedTicks.size() >= spPool->aSlotToDense.size();
+	size_t              slotTicks   = spPool->aNetVarCount * CH_ENT_VAR_LANE_COUNT;
 
-			EEntityFlag compFlags           = pool->aComponentFlags.at( componentID );
+	u32                 slot        = spPool->aDenseIDs[ sIndex ].aIndex;
+	u32                 createdTick = haveTicks ? spPool->aSlotCreatedTicks[ slot ] : 0;
 
-			bool        shouldSkipComponent = false;
+	// Send every var of a component the client hasn't seen yet
+	bool                sendAll     = !sBaselineTick || createdTick == 0 || createdTick > sBaselineTick;
 
-			// check if the entity itself will be destroyed
-			// shouldSkipComponent |= ( (entFlags & EEntityFlag_Destroyed) && !sFullUpdate );
+	if ( !sendAll && !spPool->aNetVarCount )
+		return false;
 
-			// check if the entity isn't networked
-			shouldSkipComponent |= !Entity_IsNetworked( entity, entFlags );
-			shouldSkipComponent |= compFlags & EEntityFlag_Local;
+	fb::Offset< fb::Vector< u8 > > dataVector;
+	bool                           wroteData = false;
 
-			if ( !sFullUpdate && !( compFlags & EEntityFlag_Created ) )
-				shouldSkipComponent |= regData->aVars.empty();
+	// Only write data if we have variables on this component
+	if ( spPool->aNetVarCount )
+	{
+		PROF_SCOPE_NAMED( "WriteComponent" )
 
-			// Have we determined we should skip this component?
-			if ( shouldSkipComponent )
+		const u32* varTicks = sendAll ? nullptr : spPool->aSlotVarTicks.data() + slot * slotTicks;
+
+		// Write Component Data
+		bitWriter.Clear();
+		wroteData = WriteComponent( bitWriter, regData, spPool->GetSlotData( slot ), varTicks, sBaselineTick );
+
+		if ( wroteData )
+		{
+			dataVector = srRootBuilder.CreateVector( bitWriter.GetData(), bitWriter.GetSize() );
+
+#if CH_SERVER
+			if ( ent_show_component_net_updates )
 			{
-				compListI++;
-				continue;
+				Log_DevF( gLC_Entity, 2, "Sending Component Write Update to Clients: \"%s\" - %zd bytes", regData->apName, bitWriter.GetSize() );
 			}
+#endif
+		}
+	}
 
-			fb::Offset< fb::Vector< u8 > > dataVector;
-			void*                          data = pool->aComponents[ componentID.aIndex ];
+	// Nothing on this component changed since the baseline
+	if ( !sendAll && !wroteData )
+		return false;
 
-			// Constructing flexBuilder is slow, so only do that if we have variables on this component
-			// Also make sure the component isn't being destroyed
-			if ( regData->aVars.size() && !( compFlags & EEntityFlag_Destroyed ) )
-			{
-				PROF_SCOPE_NAMED( "FlexBuilder" )
+	// Now after creating the data vector, we can make the update data builder
+	{
+		PROF_SCOPE_NAMED( "ComponentUpdateData" );
 
-				// Write Component Data
-				flexBuilder.Clear();
-				wroteData = WriteComponent( flexBuilder, regData, data, ent_always_full_update ? true : sFullUpdate );
+		NetMsg_ComponentUpdateDataBuilder compDataBuilder( srRootBuilder );
 
-				if ( wroteData )
-				{
-					flexBuilder.Finish();
-					dataVector = srRootBuilder.CreateVector( flexBuilder.GetBuffer().data(), flexBuilder.GetSize() );
+		compDataBuilder.add_id( entity );
 
-#if CH_SERVER
-					if ( ent_show_component_net_updates )
-					{
-						Log_DevF( gLC_Entity, 2, "Sending Component Write Update to Clients: \"%s\" - %zd bytes", regData->apName, flexBuilder.GetSize() );
-					}
-#endif
-				}
-			}
+		if ( wroteData )
+			compDataBuilder.add_values( dataVector );
 
-			// Now after creating the data vector, we can make the update data builder
-			{
-				PROF_SCOPE_NAMED( "ComponentUpdateData" );
+		srOut.push_back( compDataBuilder.Finish() );
+	}
+
+	return true;
+}
 
-				// NetMsg_ComponentUpdateDataBuilder& compDataBuilder = componentDataBuilders.emplace_back( srRootBuilder );
-				NetMsg_ComponentUpdateDataBuilder compDataBuilder( srRootBuilder );
 
-				compDataBuilder.add_id( entity );
+// Write what changed on each entity relevant to a client, highest priority entities first until the byte budget runs out
+// Fills in srPoolData with the components written for each pool, indexed by component type ID
+static void Entity_WriteRelevantComponents( fb::FlatBufferBuilder& srRootBuilder, u32 sBaselineTick, EntRelevance_t& srRelevance, std::vector< std::vector< fb::Offset< NetMsg_ComponentUpdateData > > >& srPoolData )
+{
+	PROF_SCOPE();
 
-				// Set Destroyed
-				if ( compFlags & EEntityFlag_Destroyed )
-					compDataBuilder.add_destroyed( true );
+	size_t startSize       = srRootBuilder.GetSize();
+	u32    budgetStart     = 0;
+	srRelevance.aSendCount = 0;
 
-				if ( wroteData )
-					compDataBuilder.add_values( dataVector );
+	for ( Entity entity : srRelevance.aSendOrder )
+	{
+		if ( !srRelevance.IsRelevant( entity ) )
+			continue;
 
-				builtUpdateList = true;
-				componentDataBuilt.push_back( compDataBuilder.Finish() );
-			}
+		EntRelevantEnt_t& relevant = srRelevance.aEntities[ entity ];
 
-			// Reset Component Var Dirty Values
-			if ( !ent_always_full_update )
-			{
-				for ( const auto& [ offset, var ] : regData->aVars )
-				{
-					if ( var.aFlags & ECompRegFlag_LocalVar )
-						continue;
+		// This entity may not have been written in the last update they acknowledged, so use the last one it was in
+		u32  baselineTick = sBaselineTick ? std::min( sBaselineTick, relevant.aAckedTick ) : 0;
+		bool wroteData    = false;
+
+		for ( EntityComponentPool* pool : EntSysData().aComponentPoolsByID )
+		{
+			if ( !pool || pool->GetRegistryData()->aNetType != EEntComponentNetType_Both )
+				continue;
 
-					char* dataChar = static_cast< char* >( data );
-					// EntComp_ResetVarDirty( dataChar + offset, var.aType );
+			u32 index = pool->GetIndex( entity );
 
-					bool* aIsDirty = reinterpret_cast< bool* >( dataChar + var.aSize + offset );
-					*aIsDirty      = false;
-				}
-			}
+			if ( index == CH_ENT_COMP_INVALID )
+				continue;
 
-			compListI++;
+			wroteData |= Entity_WriteComponentUpdate( srRootBuilder, pool, index, baselineTick, srPoolData[ pool->apData->aTypeID ] );
 		}
 
-		if ( componentDataBuilt.size() && builtUpdateList )
+		relevant.aIdle = !wroteData;
+		srRelevance.aSendCount++;
+
+		// It's sorted first, so start counting the budget after it
+		if ( entity == srRelevance.aAlwaysSend )
 		{
-			PROF_SCOPE_NAMED( "Building Component Update" );
+			startSize   = srRootBuilder.GetSize();
+			budgetStart = srRelevance.aSendCount;
+			continue;
+		}
 
-			// oh my god
-			fb::Offset< fb::Vector< fb::Offset< NetMsg_ComponentUpdateData > > > compVector;
+		// Always write at least one entity, otherwise an entity bigger than the budget would never get sent
+		size_t written = srRootBuilder.GetSize() - startSize + ( srRelevance.aSendCount - budgetStart ) * CH_ENT_UPDATE_SIZE;
 
-			//if ( wroteData )
-				compVector = srRootBuilder.CreateVector( componentDataBuilt.data(), componentDataBuilt.size() );
+		if ( srRelevance.aByteBudget && written >= srRelevance.aByteBudget )
+			break;
+	}
+}
 
-			auto                          compNameOffset = srRootBuilder.CreateString( poolName );
 
-			NetMsg_ComponentUpdateBuilder compUpdate( srRootBuilder );
-			compUpdate.add_name( compNameOffset );
-			// compUpdate.add_hash( regData->aHash );
+void Entity_WriteComponentUpdates( fb::FlatBufferBuilder& srRootBuilder, u32 sTick, u32 sBaselineTick, EntRelevance_t* spRelevance )
+{
+	PROF_SCOPE();
 
-			//if ( wroteData )
-				compUpdate.add_components( compVector );
+	if ( ent_always_full_update )
+		sBaselineTick = 0;
 
-			componentsBuilt.push_back( compUpdate.Finish() );
+	// These are kept around between calls so they don't need to allocate memory every tick
+	static std::vector< fb::Offset< NetMsg_ComponentUpdate > >                    componentsBuilt;
+	static std::vector< std::vector< fb::Offset< NetMsg_ComponentUpdateData > > > poolDataBuilt;
+	static std::vector< EntSnapshotRemoval_t >                                    removals;
 
-#if CH_SERVER
-			if ( ent_show_component_net_updates )
+	componentsBuilt.clear();
+	removals.clear();
+
+	poolDataBuilt.resize( EntSysData().aComponentPoolsByID.size() );
+
+	for ( auto& poolData : poolDataBuilt )
+		poolData.clear();
+
+	// Components removed since the baseline, a full update only needs the components that exist
+	if ( sBaselineTick )
+	{
+		for ( const EntSnapshot_t& snapshot : EntSysData().aSnapshots )
+		{
+			if ( snapshot.aTick <= sBaselineTick || snapshot.aTick > sTick )
+				continue;
+
+			for ( const EntSnapshotRemoval_t& removal : snapshot.aRemovedComponents )
 			{
-				Log_DevF( gLC_Entity, 2, "Size of Component Write Update for \"%s\": %zd bytes", pool->apName, srRootBuilder.GetSize() );
+				// If the entity is gone, the entity list deletes it on the client already
+				auto it = EntSysData().aEntityFlags.find( removal.aEntity );
+				if ( it == EntSysData().aEntityFlags.end() || ( it->second & EEntityFlag_Destroyed ) )
+					continue;
+
+				// The client doesn't have this entity
+				if ( spRelevance && !spRelevance->IsRelevant( removal.aEntity ) )
+					continue;
+
+				removals.push_back( removal );
 			}
-#endif
 		}
-		else
+	}
+
+	// Removals go first, so a component removed and added again since the baseline is recreated on the client
+	for ( const EntSnapshotRemoval_t& removal : removals )
+	{
+		NetMsg_ComponentUpdateDataBuilder compDataBuilder( srRootBuilder );
+		compDataBuilder.add_id( removal.aEntity );
+		compDataBuilder.add_destroyed( true );
+		poolDataBuilt[ removal.apPool->apData->aTypeID ].push_back( compDataBuilder.Finish() );
+	}
+
+	if ( spRelevance )
+	{
+		Entity_WriteRelevantComponents( srRootBuilder, sBaselineTick, *spRelevance, poolDataBuilt );
+	}
+	else
+	{
+		for ( EntityComponentPool* pool : EntSysData().aComponentPoolsByID )
 		{
-			// NetMsg_ComponentUpdateBuilder& compUpdate = componentBuilders.emplace_back( srRootBuilder );
-			// componentsBuilt.push_back( compUpdate.Finish() );
+			// if ( regData->aNetType != EEntComponentNetType_Both || regData->aNetType != EEntComponentNetType_Server )
+			if ( !pool || pool->GetRegistryData()->aNetType != EEntComponentNetType_Both )
+				continue;
+
+			PROF_SCOPE_NAMED( "Pool" );
+			CH_PROF_ZONE_NAME( pool->GetRegistryData()->apName, pool->GetRegistryData()->aNameLen );
+
+			for ( size_t compIndex = 0; compIndex < pool->GetCount(); compIndex++ )
+			{
+				Entity      entity   = pool->aDenseEntities[ compIndex ];
+				EEntityFlag entFlags = EntSysData().aEntityFlags.at( entity );
+
+				// Don't bother sending data if we're about to be destroyed, and skip components on entities that aren't networked
+				if ( ( entFlags & EEntityFlag_Destroyed ) || !Entity_IsNetworked( entity, entFlags ) )
+					continue;
+
+				Entity_WriteComponentUpdate( srRootBuilder, pool, compIndex, sBaselineTick, poolDataBuilt[ pool->apData->aTypeID ] );
+			}
 		}
+	}
 
-		// if ( Game_IsClient() && ent_show_component_net_updates )
-		// {
-		// 	gui->DebugMessage( "Full Component Write Update: \"%s\" - %zd bytes", regData->apName, componentDataBuilt.size() * sizeof( flatbuffers::Offset< NetMsg_ComponentUpdateData > ) );
-		// }
+	size_t poolCount = 0;
+
+	for ( EntityComponentPool* pool : EntSysData().aComponentPoolsByID )
+	{
+		// If nothing was written for this component, don't even bother to send anything here
+		if ( !pool || poolDataBuilt[ pool->apData->aTypeID ].empty() )
+			continue;
+
+		PROF_SCOPE_NAMED( "Building Component Update" );
+
+		auto& componentDataBuilt = poolDataBuilt[ pool->apData->aTypeID ];
+
+		// oh my god
+		fb::Offset< fb::Vector< fb::Offset< NetMsg_ComponentUpdateData > > > compVector;
+		compVector = srRootBuilder.CreateVector( componentDataBuilt.data(), componentDataBuilt.size() );
+
+		auto                          compNameOffset = srRootBuilder.CreateString( pool->apName );
+
+		NetMsg_ComponentUpdateBuilder compUpdate( srRootBuilder );
+		compUpdate.add_name( compNameOffset );
+		// compUpdate.add_hash( regData->aHash );
+		compUpdate.add_components( compVector );
+
+		componentsBuilt.push_back( compUpdate.Finish() );
+		poolCount++;
 
-		i++;
+#if CH_SERVER
+		if ( ent_show_component_net_updates )
+		{
+			Log_DevF( gLC_Entity, 2, "Size of Component Write Update for \"%s\": %zd bytes", pool->apName, srRootBuilder.GetSize() );
+		}
+#endif
 	}
 
 	auto                           updateListOut = srRootBuilder.CreateVector( componentsBuilt.data(), componentsBuilt.size() );
 
 	NetMsg_ComponentUpdatesBuilder root( srRootBuilder );
+	root.add_tick( sTick );
 	root.add_update_list( updateListOut );
+	root.add_server_time( gCurTime );
+	root.add_partial( spRelevance && spRelevance->aSendCount < spRelevance->aSendOrder.size() );
 
 	srRootBuilder.Finish( root.Finish() );
 
@@ -800,9 +918,9 @@ void Entity_ReadComponentUpdates( const NetMsg_ComponentUpdates* spReader )
 	{
 		EntComponentData_t* regData = pool->GetRegistryData();
 
-		for ( auto& [entity, compIndex] : pool->aMapEntityToComponent )
+		for ( size_t compIndex = 0; compIndex < pool->GetCount(); compIndex++ )
 		{
-			void* componentData = pool->aComponents[ compIndex.aIndex ];
+			void* componentData = pool->GetDataByIndex( compIndex );
 
 			// Reset Component Var Dirty Values
 			for ( const auto& [ offset, var ] : regData->aVars )
@@ -810,9 +928,8 @@ void Entity_ReadComponentUpdates( const NetMsg_ComponentUpdates* spReader )
 				if ( var.aFlags & ECompRegFlag_LocalVar )
 					continue;
 
-				char* dataChar = static_cast< char* >( componentData );
-				bool* isDirty  = reinterpret_cast< bool* >( dataChar + var.aSize + offset );
-				*isDirty       = false;
+				*EntComp_GetVarDirty( componentData, offset, var )      = false;
+				*EntComp_GetVarDirtyLanes( componentData, offset, var ) = 0;
 			}
 		}
 	}
@@ -850,8 +967,11 @@ void Entity_ReadComponentUpdates( const NetMsg_ComponentUpdates* spReader )
 
 		CH_PROF_ZONE_NAME_STR( componentName );
 
-		IEntityComponentSystem* system  = pool->apComponentSystem;
-		EntComponentData_t*     regData = pool->GetRegistryData();
+		IEntityComponentSystem* system      = pool->apComponentSystem;
+		EntComponentData_t*     regData     = pool->GetRegistryData();
+
+		// Read straight into the component, so queue transforms to rebuild their world matrix here
+		bool                    isTransform = pool == Entity_GetComponentPool< CTransform >();
 
 		CH_ASSERT_MSG( regData, "Failed to find component registry data" );
 
@@ -887,21 +1007,21 @@ void Entity_ReadComponentUpdates( const NetMsg_ComponentUpdates* spReader )
 			{
 				// We can just remove the component right now, no need to queue it,
 				// as this is before all client game processing
-				pool->Remove( entity );
+				// Removals since the last tick we acknowledged are sent again, so we may not have it anymore
+				if ( pool->GetIndex( entity ) != CH_ENT_COMP_INVALID )
+					pool->Remove( entity );
+
 				continue;
 			}
 
-			// We don't use the component pool functions to reduce calls to aMapEntityToComponent
-			// We only need to find the componentID once (or twice when creating the component), and gain some speed up
-			ComponentID_t componentID{ SIZE_MAX };
+			// We don't use the component pool functions to reduce lookups in the sparse set
+			// We only need to find the index once (or twice when creating the component), and gain some speed up
+			void* componentData = nullptr;
+			u32   compIndex     = pool->GetIndex( entity );
 
-			void*         componentData = nullptr;
-			auto          entToCompIt   = pool->aMapEntityToComponent.find( entity );
-
-			if ( entToCompIt != pool->aMapEntityToComponent.end() )
+			if ( compIndex != CH_ENT_COMP_INVALID )
 			{
-				componentID = entToCompIt->second;
-				componentData = pool->aComponents[ entToCompIt->second.aIndex ];
+				componentData = pool->GetDataByIndex( compIndex );
 			}
 			else
 			{
@@ -914,9 +1034,11 @@ void Entity_ReadComponentUpdates( const NetMsg_ComponentUpdates* spReader )
 					continue;
 				}
 
-				componentID = pool->aMapEntityToComponent.at( entity );
+				compIndex = pool->GetIndex( entity );
 			}
 
+			ComponentID_t componentID = pool->aDenseIDs[ compIndex ];
+
 #if CH_CLIENT
 			// Now, update component data
 			// NOTE: i could try to check if it's predicted here and get rid of aOverrideClient
@@ -924,18 +1046,25 @@ void Entity_ReadComponentUpdates( const NetMsg_ComponentUpdates* spReader )
 				continue;
 
 			// a bit of a hack and not implemented properly
-			if ( pool->aComponentFlags.at( componentID ) & EEntityFlag_Predicted )
+			if ( pool->aDenseFlags[ compIndex ] & EEntityFlag_Predicted )
 				continue;
 #endif
 
 			if ( componentUpdateData->values() )
 			{
-				auto             values   = componentUpdateData->values();
-				flexb::Reference flexRoot = flexb::GetRoot( values->data(), values->size() );
+				auto         values = componentUpdateData->values();
+				NetBitReader reader( values->data(), values->size() );
 
-				ReadComponent( flexRoot, regData, componentData );
+				ReadComponent( reader, regData, componentData );
 				// regData->apRead( componentVerifier, values->data(), componentData );
 
+				if ( isTransform )
+					Entity_MarkTransformChanged( *static_cast< CTransform* >( componentData ) );
+
+#if CH_CLIENT
+				EntInterp_AddSample( pool, entity, componentData, spReader->server_time() );
+#endif
+
 				Log_DevF( gLC_Entity, 3, "Parsed component data for entity \"%zd\" - \"%s\"\n", entity, componentName );
 
 				if ( system )
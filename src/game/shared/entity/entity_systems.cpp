@@ -33,7 +33,7 @@ void LightSystem::ComponentRemoved( Entity sEntity, void* spData )
 }
 
 
-static void UpdateLightData( Entity sEntity, CLight* spLight )
+static void UpdateLightData( Entity sEntity, CLight* spLight, EntityComponentPool* spTransformPool )
 {
 #if CH_CLIENT
 	PROF_SCOPE();
@@ -44,7 +44,7 @@ static void UpdateLightData( Entity sEntity, CLight* spLight )
 	if ( spLight->aUseTransform )
 	{
 		glm::mat4 matrix;
-		if ( Entity_GetWorldMatrix( matrix, sEntity ) )
+		if ( Entity_GetWorldMatrix( matrix, sEntity, spTransformPool ) )
 		{
 			spLight->apLight->aPos = Util_GetMatrixPosition( matrix );
 			// spLight->apLight->aAng = glm::degrees( Util_GetMatrixAngles( matrix ) );
@@ -103,27 +103,36 @@ void LightSystem::ComponentUpdated( Entity sEntity, void* spData )
 
 	CH_ASSERT( light->apLight );
 
-	UpdateLightData( sEntity, light );
+	UpdateLightData( sEntity, light, Entity_GetComponentPool< CTransform >() );
 #endif
 }
 
 
+bool LightSystem::GetAccess( EntSysAccess_t& srAccess )
+{
+	// Creates and updates graphics lights, so this stays on the main thread
+	srAccess.Read< CTransform >();
+	srAccess.aInterfaces = EEntSysInterface_Graphics;
+	return true;
+}
+
+
 void LightSystem::Update()
 {
 	PROF_SCOPE();
 
 #if CH_CLIENT
-	for ( Entity entity : aEntities )
-	{
-		auto light = Ent_GetComponent< CLight >( entity, "light" );
+	EntityComponentPool* transformPool = Entity_GetComponentPool< CTransform >();
 
-		if ( !light )
-			continue;
+	for ( size_t i = 0; i < apPool->GetCount(); i++ )
+	{
+		Entity entity = apPool->GetEntityByIndex( i );
+		auto   light  = static_cast< CLight* >( apPool->GetDataByIndex( i ) );
 
 		CH_ASSERT( light->apLight );
 
 		// this is awful
-		UpdateLightData( entity, light );
+		UpdateLightData( entity, light, transformPool );
 	}
 #endif
 }
@@ -176,7 +185,7 @@ void EntSys_ModelInfo::Update()
 {
 	for ( Entity entity : aEntities )
 	{
-		auto modelInfo = Ent_GetComponent< CModelInfo >( entity, "modelInfo" );
+		auto modelInfo = Ent_GetComponent< CModelInfo >( entity );
 
 		CH_ASSERT( modelInfo );
 
@@ -204,6 +213,16 @@ void EntSys_ModelInfo::Update()
 // ------------------------------------------------------------
 
 
+void EntSys_Transform::ComponentAdded( Entity sEntity, void* spData )
+{
+	// Now changes to it can queue it to be rebuilt
+	auto transform     = static_cast< CTransform* >( spData );
+	transform->aEntity = sEntity;
+
+	Entity_MarkTransformChanged( *transform );
+}
+
+
 void EntSys_Transform::ComponentUpdated( Entity sEntity, void* spData )
 {
 	// THIS IS ONLY CALLED ON THE CLIENT THIS WON'T WORK
@@ -211,6 +230,21 @@ void EntSys_Transform::ComponentUpdated( Entity sEntity, void* spData )
 }
 
 
+void EntSys_Transform::ComponentRemoved( Entity sEntity, void* spData )
+{
+	// Falls back to the parent's matrix now
+	Entity_MarkWorldTransformDirty( sEntity );
+}
+
+
+bool EntSys_Transform::GetAccess( EntSysAccess_t& srAccess )
+{
+	// Only draws debug axes with graphics, nothing is written
+	srAccess.aInterfaces = EEntSysInterface_Graphics;
+	return true;
+}
+
+
 void EntSys_Transform::Update()
 {
 	PROF_SCOPE();
@@ -218,13 +252,13 @@ void EntSys_Transform::Update()
 #if CH_CLIENT
 	if ( r_debug_draw_transforms )
 	{
-		for ( Entity entity : aEntities )
+		for ( size_t i = 0; i < apPool->GetCount(); i++ )
 		{
-			// auto transform = Ent_GetComponent< CTransform >( entity, "transform" );
+			Entity entity = apPool->GetEntityByIndex( i );
 
 			// We have to draw them in world space
 			glm::mat4 matrix;
-			if ( !Entity_GetWorldMatrix( matrix, entity ) )
+			if ( !Entity_GetWorldMatrix( matrix, entity, apPool ) )
 				continue;
 
 			// graphics->DrawAxis( transform->aPos, transform->aAng, transform->aScale );
@@ -241,13 +275,23 @@ EntSys_Transform gEntSys_Transform;
 // ------------------------------------------------------------
 
 
+void EntSys_Renderable::ResetMatrixVersion( Entity sEntity )
+{
+	if ( sEntity < aMatrixVersions.size() )
+		aMatrixVersions[ sEntity ] = 0;
+}
+
+
 void EntSys_Renderable::ComponentAdded( Entity sEntity, void* spData )
 {
+	ResetMatrixVersion( sEntity );
 }
 
 
 void EntSys_Renderable::ComponentRemoved( Entity sEntity, void* spData )
 {
+	ResetMatrixVersion( sEntity );
+
 #if CH_CLIENT
 	auto renderComp = static_cast< CRenderable* >( spData );
 
@@ -283,6 +327,9 @@ void EntSys_Renderable::ComponentUpdated( Entity sEntity, void* spData )
 		// no need to update the handle if we're creating it
 		renderData = Ent_CreateRenderable( sEntity );
 		graphics->UpdateRenderableAABB( renderComp->aRenderable );
+
+		// This is a new renderable, so it needs the matrix
+		ResetMatrixVersion( sEntity );
 		return;
 	}
 
@@ -300,26 +347,33 @@ void EntSys_Renderable::ComponentUpdated( Entity sEntity, void* spData )
 }
 
 
+bool EntSys_Renderable::GetAccess( EntSysAccess_t& srAccess )
+{
+	// Hands matrices off to graphics, so this stays on the main thread
+	srAccess.Read< CTransform >();
+	srAccess.aInterfaces = EEntSysInterface_Graphics;
+	return true;
+}
+
+
 void EntSys_Renderable::Update()
 {
 	PROF_SCOPE();
 
 #if CH_CLIENT
-	for ( Entity entity : aEntities )
-	{
-		// TODO: check if any of the transforms are dirty, including the parents, unsure how that would work
-		glm::mat4 matrix;
-		if ( !Entity_GetWorldMatrix( matrix, entity ) )
-			continue;
+	if ( aMatrixVersions.size() != CH_MAX_ENTITIES )
+		aMatrixVersions.assign( CH_MAX_ENTITIES, 0 );
 
-		auto renderComp = Ent_GetComponent< CRenderable >( entity, "renderable" );
+	for ( u32 i = 0; i < apPool->GetCount(); i++ )
+	{
+		Entity                     entity = apPool->GetEntityByIndex( i );
+		const EntWorldTransform_t* world  = Entity_GetCachedWorldTransform( entity );
 
-		if ( !renderComp )
-		{
-			Log_Warn( "oops\n" );
+		// World matrices are rebuilt before this batch if a system before it moved anything, only hand over the ones that changed
+		if ( !world || !world->aValid || aMatrixVersions[ entity ] == world->aVersion )
 			continue;
-		}
 
+		auto          renderComp = static_cast< CRenderable* >( apPool->GetDataByIndex( i ) );
 		Renderable_t* renderData = graphics->GetRenderableData( renderComp->aRenderable );
 
 		if ( !renderData )
@@ -328,8 +382,10 @@ void EntSys_Renderable::Update()
 			continue;
 		}
 
-		renderData->aModelMatrix = matrix;
+		renderData->aModelMatrix = world->aMatrix;
 		graphics->UpdateRenderableAABB( renderComp->aRenderable );
+
+		aMatrixVersions[ entity ] = world->aVersion;
 	}
 #endif
 }
@@ -12,6 +12,7 @@ class LightSystem : public IEntityComponentSystem
 	void ComponentAdded( Entity sEntity, void* spData ) override;
 	void ComponentRemoved( Entity sEntity, void* spData ) override;
 	void ComponentUpdated( Entity sEntity, void* spData ) override;
+	bool GetAccess( EntSysAccess_t& srAccess ) override;
 	void Update() override;
 };
 
@@ -28,7 +29,10 @@ class EntSys_Transform : public IEntityComponentSystem
 	EntSys_Transform() {}
 	~EntSys_Transform() {}
 
+	void ComponentAdded( Entity sEntity, void* spData ) override;
+	void ComponentRemoved( Entity sEntity, void* spData ) override;
 	void ComponentUpdated( Entity sEntity, void* spData ) override;
+	bool GetAccess( EntSysAccess_t& srAccess ) override;
 	void Update() override;
 };
 
@@ -47,7 +51,14 @@ class EntSys_Renderable : public IEntityComponentSystem
 	void ComponentAdded( Entity sEntity, void* spData ) override;
 	void ComponentRemoved( Entity sEntity, void* spData ) override;
 	void ComponentUpdated( Entity sEntity, void* spData ) override;
+	bool GetAccess( EntSysAccess_t& srAccess ) override;
 	void Update() override;
+
+  private:
+	// [Entity] = Version of the cached world matrix last handed to graphics, so unmoved renderables are skipped
+	std::vector< u32 > aMatrixVersions;
+
+	void               ResetMatrixVersion( Entity sEntity );
 };
 
 extern EntSys_Renderable gEntSys_Renderable;
@@ -24,6 +24,9 @@ struct Quat;
 struct NetMsg_UserCmd;
 struct NetMsg_UserCmdBuilder;
 
+struct NetMsg_UserCmdAck;
+struct NetMsg_UserCmdAckBuilder;
+
 struct NetMsg_ServerInfo;
 struct NetMsg_ServerInfoBuilder;
 
@@ -85,7 +88,7 @@ struct SMF_Skybox;
 struct SMF_SkyboxBuilder;
 
 enum ESiduryProtocolVer : uint16_t {
-  ESiduryProtocolVer_Value = 3,
+  ESiduryProtocolVer_Value = 9,
   ESiduryProtocolVer_MIN = ESiduryProtocolVer_Value,
   ESiduryProtocolVer_MAX = ESiduryProtocolVer_Value
 };
@@ -228,11 +231,12 @@ enum EMsgSrc_Server : uint8_t {
   EMsgSrc_Server_EntityList = 8,
   EMsgSrc_Server_Paused = 9,
   EMsgSrc_Server_GameRules = 10,
+  EMsgSrc_Server_UserCmdAck = 11,
   EMsgSrc_Server_MIN = EMsgSrc_Server_Invalid,
-  EMsgSrc_Server_MAX = EMsgSrc_Server_GameRules
+  EMsgSrc_Server_MAX = EMsgSrc_Server_UserCmdAck
 };
 
-inline const EMsgSrc_Server (&EnumValuesEMsgSrc_Server())[11] {
+inline const EMsgSrc_Server (&EnumValuesEMsgSrc_Server())[12] {
   static const EMsgSrc_Server values[] = {
     EMsgSrc_Server_Invalid,
     EMsgSrc_Server_Disconnect,
@@ -244,13 +248,14 @@ inline const EMsgSrc_Server (&EnumValuesEMsgSrc_Server())[11] {
     EMsgSrc_Server_ComponentList,
     EMsgSrc_Server_EntityList,
     EMsgSrc_Server_Paused,
-    EMsgSrc_Server_GameRules
+    EMsgSrc_Server_GameRules,
+    EMsgSrc_Server_UserCmdAck
   };
   return values;
 }
 
 inline const char * const *EnumNamesEMsgSrc_Server() {
-  static const char * const names[12] = {
+  static const char * const names[13] = {
     "Invalid",
     "Disconnect",
     "ConVar",
@@ -262,13 +267,14 @@ inline const char * const *EnumNamesEMsgSrc_Server() {
     "EntityList",
     "Paused",
     "GameRules",
+    "UserCmdAck",
     nullptr
   };
   return names;
 }
 
 inline const char *EnumNameEMsgSrc_Server(EMsgSrc_Server e) {
-  if (::flatbuffers::IsOutRange(e, EMsgSrc_Server_Invalid, EMsgSrc_Server_GameRules)) return "";
+  if (::flatbuffers::IsOutRange(e, EMsgSrc_Server_Invalid, EMsgSrc_Server_UserCmdAck)) return "";
   const size_t index = static_cast<size_t>(e);
   return EnumNamesEMsgSrc_Server()[index];
 }
@@ -437,7 +443,11 @@ struct NetMsg_UserCmd FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
     VT_ANGLES = 4,
     VT_BUTTONS = 6,
     VT_MOVE_TYPE = 8,
-    VT_FLASHLIGHT = 10
+    VT_FLASHLIGHT = 10,
+    VT_SNAPSHOT_ACK = 12,
+    VT_COMMAND_NUMBER = 14,
+    VT_FRAME_TIME = 16,
+    VT_BACKUP = 18
   };
   const Vec3 *angles() const {
     return GetStruct<const Vec3 *>(VT_ANGLES);
@@ -451,12 +461,30 @@ struct NetMsg_UserCmd FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
   bool flashlight() const {
     return GetField<uint8_t>(VT_FLASHLIGHT, 0) != 0;
   }
+  uint32_t snapshot_ack() const {
+    return GetField<uint32_t>(VT_SNAPSHOT_ACK, 0);
+  }
+  uint32_t command_number() const {
+    return GetField<uint32_t>(VT_COMMAND_NUMBER, 0);
+  }
+  float frame_time() const {
+    return GetField<float>(VT_FRAME_TIME, 0.0f);
+  }
+  const ::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_UserCmd>> *backup() const {
+    return GetPointer<const ::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_UserCmd>> *>(VT_BACKUP);
+  }
   bool Verify(::flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<Vec3>(verifier, VT_ANGLES, 4) &&
            VerifyField<int32_t>(verifier, VT_BUTTONS, 4) &&
            VerifyField<int8_t>(verifier, VT_MOVE_TYPE, 1) &&
            VerifyField<uint8_t>(verifier, VT_FLASHLIGHT, 1) &&
+           VerifyField<uint32_t>(verifier, VT_SNAPSHOT_ACK, 4) &&
+           VerifyField<uint32_t>(verifier, VT_COMMAND_NUMBER, 4) &&
+           VerifyField<float>(verifier, VT_FRAME_TIME, 4) &&
+           VerifyOffset(verifier, VT_BACKUP) &&
+           verifier.VerifyVector(backup()) &&
+           verifier.VerifyVectorOfTables(backup()) &&
            verifier.EndTable();
   }
 };
@@ -477,6 +505,18 @@ struct NetMsg_UserCmdBuilder {
   void add_flashlight(bool flashlight) {
     fbb_.AddElement<uint8_t>(NetMsg_UserCmd::VT_FLASHLIGHT, static_cast<uint8_t>(flashlight), 0);
   }
+  void add_snapshot_ack(uint32_t snapshot_ack) {
+    fbb_.AddElement<uint32_t>(NetMsg_UserCmd::VT_SNAPSHOT_ACK, snapshot_ack, 0);
+  }
+  void add_command_number(uint32_t command_number) {
+    fbb_.AddElement<uint32_t>(NetMsg_UserCmd::VT_COMMAND_NUMBER, command_number, 0);
+  }
+  void add_frame_time(float frame_time) {
+    fbb_.AddElement<float>(NetMsg_UserCmd::VT_FRAME_TIME, frame_time, 0.0f);
+  }
+  void add_backup(::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_UserCmd>>> backup) {
+    fbb_.AddOffset(NetMsg_UserCmd::VT_BACKUP, backup);
+  }
   explicit NetMsg_UserCmdBuilder(::flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -493,8 +533,16 @@ inline ::flatbuffers::Offset<NetMsg_UserCmd> CreateNetMsg_UserCmd(
     const Vec3 *angles = nullptr,
     int32_t buttons = 0,
     Net_EPlayerMoveType move_type = Net_EPlayerMoveType_Walk,
-    bool flashlight = false) {
+    bool flashlight = false,
+    uint32_t snapshot_ack = 0,
+    uint32_t command_number = 0,
+    float frame_time = 0.0f,
+    ::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_UserCmd>>> backup = 0) {
   NetMsg_UserCmdBuilder builder_(_fbb);
+  builder_.add_backup(backup);
+  builder_.add_frame_time(frame_time);
+  builder_.add_command_number(command_number);
+  builder_.add_snapshot_ack(snapshot_ack);
   builder_.add_buttons(buttons);
   builder_.add_angles(angles);
   builder_.add_flashlight(flashlight);
@@ -502,6 +550,80 @@ inline ::flatbuffers::Offset<NetMsg_UserCmd> CreateNetMsg_UserCmd(
   return builder_.Finish();
 }
 
+inline ::flatbuffers::Offset<NetMsg_UserCmd> CreateNetMsg_UserCmdDirect(
+    ::flatbuffers::FlatBufferBuilder &_fbb,
+    const Vec3 *angles = nullptr,
+    int32_t buttons = 0,
+    Net_EPlayerMoveType move_type = Net_EPlayerMoveType_Walk,
+    bool flashlight = false,
+    uint32_t snapshot_ack = 0,
+    uint32_t command_number = 0,
+    float frame_time = 0.0f,
+    const std::vector<::flatbuffers::Offset<NetMsg_UserCmd>> *backup = nullptr) {
+  auto backup__ = backup ? _fbb.CreateVector<::flatbuffers::Offset<NetMsg_UserCmd>>(*backup) : 0;
+  return CreateNetMsg_UserCmd(
+      _fbb,
+      angles,
+      buttons,
+      move_type,
+      flashlight,
+      snapshot_ack,
+      command_number,
+      frame_time,
+      backup__);
+}
+
+struct NetMsg_UserCmdAck FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
+  typedef NetMsg_UserCmdAckBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_TICK = 4,
+    VT_COMMAND_NUMBER = 6
+  };
+  uint32_t tick() const {
+    return GetField<uint32_t>(VT_TICK, 0);
+  }
+  uint32_t command_number() const {
+    return GetField<uint32_t>(VT_COMMAND_NUMBER, 0);
+  }
+  bool Verify(::flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_TICK, 4) &&
+           VerifyField<uint32_t>(verifier, VT_COMMAND_NUMBER, 4) &&
+           verifier.EndTable();
+  }
+};
+
+struct NetMsg_UserCmdAckBuilder {
+  typedef NetMsg_UserCmdAck Table;
+  ::flatbuffers::FlatBufferBuilder &fbb_;
+  ::flatbuffers::uoffset_t start_;
+  void add_tick(uint32_t tick) {
+    fbb_.AddElement<uint32_t>(NetMsg_UserCmdAck::VT_TICK, tick, 0);
+  }
+  void add_command_number(uint32_t command_number) {
+    fbb_.AddElement<uint32_t>(NetMsg_UserCmdAck::VT_COMMAND_NUMBER, command_number, 0);
+  }
+  explicit NetMsg_UserCmdAckBuilder(::flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  ::flatbuffers::Offset<NetMsg_UserCmdAck> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = ::flatbuffers::Offset<NetMsg_UserCmdAck>(end);
+    return o;
+  }
+};
+
+inline ::flatbuffers::Offset<NetMsg_UserCmdAck> CreateNetMsg_UserCmdAck(
+    ::flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t tick = 0,
+    uint32_t command_number = 0) {
+  NetMsg_UserCmdAckBuilder builder_(_fbb);
+  builder_.add_command_number(command_number);
+  builder_.add_tick(tick);
+  return builder_.Finish();
+}
+
 struct NetMsg_ServerInfo FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
   typedef NetMsg_ServerInfoBuilder Builder;
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
@@ -595,7 +717,8 @@ struct NetMsg_ClientInfo FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table
   typedef NetMsg_ClientInfoBuilder Builder;
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
     VT_NAME = 4,
-    VT_STEAM_ID = 6
+    VT_STEAM_ID = 6,
+    VT_RATE = 8
   };
   const ::flatbuffers::String *name() const {
     return GetPointer<const ::flatbuffers::String *>(VT_NAME);
@@ -603,11 +726,15 @@ struct NetMsg_ClientInfo FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table
   uint64_t steam_id() const {
     return GetField<uint64_t>(VT_STEAM_ID, 0);
   }
+  uint32_t rate() const {
+    return GetField<uint32_t>(VT_RATE, 0);
+  }
   bool Verify(::flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyOffset(verifier, VT_NAME) &&
            verifier.VerifyString(name()) &&
            VerifyField<uint64_t>(verifier, VT_STEAM_ID, 8) &&
+           VerifyField<uint32_t>(verifier, VT_RATE, 4) &&
            verifier.EndTable();
   }
 };
@@ -622,6 +749,9 @@ struct NetMsg_ClientInfoBuilder {
   void add_steam_id(uint64_t steam_id) {
     fbb_.AddElement<uint64_t>(NetMsg_ClientInfo::VT_STEAM_ID, steam_id, 0);
   }
+  void add_rate(uint32_t rate) {
+    fbb_.AddElement<uint32_t>(NetMsg_ClientInfo::VT_RATE, rate, 0);
+  }
   explicit NetMsg_ClientInfoBuilder(::flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -636,9 +766,11 @@ struct NetMsg_ClientInfoBuilder {
 inline ::flatbuffers::Offset<NetMsg_ClientInfo> CreateNetMsg_ClientInfo(
     ::flatbuffers::FlatBufferBuilder &_fbb,
     ::flatbuffers::Offset<::flatbuffers::String> name = 0,
-    uint64_t steam_id = 0) {
+    uint64_t steam_id = 0,
+    uint32_t rate = 0) {
   NetMsg_ClientInfoBuilder builder_(_fbb);
   builder_.add_steam_id(steam_id);
+  builder_.add_rate(rate);
   builder_.add_name(name);
   return builder_.Finish();
 }
@@ -646,12 +778,14 @@ inline ::flatbuffers::Offset<NetMsg_ClientInfo> CreateNetMsg_ClientInfo(
 inline ::flatbuffers::Offset<NetMsg_ClientInfo> CreateNetMsg_ClientInfoDirect(
     ::flatbuffers::FlatBufferBuilder &_fbb,
     const char *name = nullptr,
-    uint64_t steam_id = 0) {
+    uint64_t steam_id = 0,
+    uint32_t rate = 0) {
   auto name__ = name ? _fbb.CreateString(name) : 0;
   return CreateNetMsg_ClientInfo(
       _fbb,
       name__,
-      steam_id);
+      steam_id,
+      rate);
 }
 
 struct NetMsg_ServerClientInfo FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
@@ -1378,13 +1512,18 @@ inline ::flatbuffers::Offset<NetMsg_EntityUpdate> CreateNetMsg_EntityUpdate(
 struct NetMsg_EntityUpdates FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
   typedef NetMsg_EntityUpdatesBuilder Builder;
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
-    VT_UPDATE_LIST = 4
+    VT_TICK = 4,
+    VT_UPDATE_LIST = 6
   };
+  uint32_t tick() const {
+    return GetField<uint32_t>(VT_TICK, 0);
+  }
   const ::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_EntityUpdate>> *update_list() const {
     return GetPointer<const ::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_EntityUpdate>> *>(VT_UPDATE_LIST);
   }
   bool Verify(::flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_TICK, 4) &&
            VerifyOffset(verifier, VT_UPDATE_LIST) &&
            verifier.VerifyVector(update_list()) &&
            verifier.VerifyVectorOfTables(update_list()) &&
@@ -1396,6 +1535,9 @@ struct NetMsg_EntityUpdatesBuilder {
   typedef NetMsg_EntityUpdates Table;
   ::flatbuffers::FlatBufferBuilder &fbb_;
   ::flatbuffers::uoffset_t start_;
+  void add_tick(uint32_t tick) {
+    fbb_.AddElement<uint32_t>(NetMsg_EntityUpdates::VT_TICK, tick, 0);
+  }
   void add_update_list(::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_EntityUpdate>>> update_list) {
     fbb_.AddOffset(NetMsg_EntityUpdates::VT_UPDATE_LIST, update_list);
   }
@@ -1412,34 +1554,53 @@ struct NetMsg_EntityUpdatesBuilder {
 
 inline ::flatbuffers::Offset<NetMsg_EntityUpdates> CreateNetMsg_EntityUpdates(
     ::flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t tick = 0,
     ::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_EntityUpdate>>> update_list = 0) {
   NetMsg_EntityUpdatesBuilder builder_(_fbb);
   builder_.add_update_list(update_list);
+  builder_.add_tick(tick);
   return builder_.Finish();
 }
 
 inline ::flatbuffers::Offset<NetMsg_EntityUpdates> CreateNetMsg_EntityUpdatesDirect(
     ::flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t tick = 0,
     const std::vector<::flatbuffers::Offset<NetMsg_EntityUpdate>> *update_list = nullptr) {
   auto update_list__ = update_list ? _fbb.CreateVector<::flatbuffers::Offset<NetMsg_EntityUpdate>>(*update_list) : 0;
   return CreateNetMsg_EntityUpdates(
       _fbb,
+      tick,
       update_list__);
 }
 
 struct NetMsg_ComponentUpdates FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
   typedef NetMsg_ComponentUpdatesBuilder Builder;
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
-    VT_UPDATE_LIST = 4
+    VT_TICK = 4,
+    VT_UPDATE_LIST = 6,
+    VT_SERVER_TIME = 8,
+    VT_PARTIAL = 10
   };
+  uint32_t tick() const {
+    return GetField<uint32_t>(VT_TICK, 0);
+  }
   const ::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_ComponentUpdate>> *update_list() const {
     return GetPointer<const ::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_ComponentUpdate>> *>(VT_UPDATE_LIST);
   }
+  double server_time() const {
+    return GetField<double>(VT_SERVER_TIME, 0.0);
+  }
+  bool partial() const {
+    return GetField<uint8_t>(VT_PARTIAL, 0) != 0;
+  }
   bool Verify(::flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_TICK, 4) &&
            VerifyOffset(verifier, VT_UPDATE_LIST) &&
            verifier.VerifyVector(update_list()) &&
            verifier.VerifyVectorOfTables(update_list()) &&
+           VerifyField<double>(verifier, VT_SERVER_TIME, 8) &&
+           VerifyField<uint8_t>(verifier, VT_PARTIAL, 1) &&
            verifier.EndTable();
   }
 };
@@ -1448,9 +1609,18 @@ struct NetMsg_ComponentUpdatesBuilder {
   typedef NetMsg_ComponentUpdates Table;
   ::flatbuffers::FlatBufferBuilder &fbb_;
   ::flatbuffers::uoffset_t start_;
+  void add_tick(uint32_t tick) {
+    fbb_.AddElement<uint32_t>(NetMsg_ComponentUpdates::VT_TICK, tick, 0);
+  }
   void add_update_list(::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_ComponentUpdate>>> update_list) {
     fbb_.AddOffset(NetMsg_ComponentUpdates::VT_UPDATE_LIST, update_list);
   }
+  void add_server_time(double server_time) {
+    fbb_.AddElement<double>(NetMsg_ComponentUpdates::VT_SERVER_TIME, server_time, 0.0);
+  }
+  void add_partial(bool partial) {
+    fbb_.AddElement<uint8_t>(NetMsg_ComponentUpdates::VT_PARTIAL, static_cast<uint8_t>(partial), 0);
+  }
   explicit NetMsg_ComponentUpdatesBuilder(::flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -1464,19 +1634,31 @@ struct NetMsg_ComponentUpdatesBuilder {
 
 inline ::flatbuffers::Offset<NetMsg_ComponentUpdates> CreateNetMsg_ComponentUpdates(
     ::flatbuffers::FlatBufferBuilder &_fbb,
-    ::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_ComponentUpdate>>> update_list = 0) {
+    uint32_t tick = 0,
+    ::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<NetMsg_ComponentUpdate>>> update_list = 0,
+    double server_time = 0.0,
+    bool partial = false) {
   NetMsg_ComponentUpdatesBuilder builder_(_fbb);
+  builder_.add_server_time(server_time);
   builder_.add_update_list(update_list);
+  builder_.add_tick(tick);
+  builder_.add_partial(partial);
   return builder_.Finish();
 }
 
 inline ::flatbuffers::Offset<NetMsg_ComponentUpdates> CreateNetMsg_ComponentUpdatesDirect(
     ::flatbuffers::FlatBufferBuilder &_fbb,
-    const std::vector<::flatbuffers::Offset<NetMsg_ComponentUpdate>> *update_list = nullptr) {
+    uint32_t tick = 0,
+    const std::vector<::flatbuffers::Offset<NetMsg_ComponentUpdate>> *update_list = nullptr,
+    double server_time = 0.0,
+    bool partial = false) {
   auto update_list__ = update_list ? _fbb.CreateVector<::flatbuffers::Offset<NetMsg_ComponentUpdate>>(*update_list) : 0;
   return CreateNetMsg_ComponentUpdates(
       _fbb,
-      update_list__);
+      tick,
+      update_list__,
+      server_time,
+      partial);
 }
 
 struct SMF_Command FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
@@ -155,7 +155,7 @@ bool Phys_CreatePhysShapeComponent( CPhysShape* compPhysShape )
 		default:
 		{
 			// Free a model if we have one
-			if ( compPhysShape->aModel != CH_INVALID_HANDLE )
+			if ( graphics && compPhysShape->aModel != CH_INVALID_HANDLE )
 				graphics->FreeModel( compPhysShape->aModel );
 
 			compPhysShape->aModel = CH_INVALID_HANDLE;
@@ -228,7 +228,7 @@ bool Phys_CreatePhysShapeComponent( CPhysShape* compPhysShape )
 
 static void OnCreatePhysShape( Entity sEntity, CPhysShape* compPhysShape )
 {
-	auto physObject = Ent_GetComponent< CPhysObject >( sEntity, "physObject" );
+	auto physObject = Ent_GetComponent< CPhysObject >( sEntity );
 
 	if ( !physObject || !physObject->apObj )
 		return;
@@ -275,16 +275,19 @@ void EntSys_PhysShape::ComponentUpdated( Entity sEntity, void* spData )
 }
 
 
-void EntSys_PhysShape::Update()
+bool EntSys_PhysShape::GetAccess( EntSysAccess_t& srAccess )
 {
-	for ( Entity entity : aEntities )
-	{
-		auto physShape  = Ent_GetComponent< CPhysShape >( entity, "physShape" );
+	// Creating shapes can free models through graphics, so this stays on the main thread
+	srAccess.aInterfaces = EEntSysInterface_Physics | EEntSysInterface_Graphics;
+	return true;
+}
 
-		CH_ASSERT( physShape );
 
-		if ( !physShape )
-			continue;
+void EntSys_PhysShape::Update()
+{
+	for ( size_t i = 0; i < apPool->GetCount(); i++ )
+	{
+		auto physShape = static_cast< CPhysShape* >( apPool->GetDataByIndex( i ) );
 
 		if ( !physShape->apShape )
 		{
@@ -321,7 +324,7 @@ static void CreatePhysObjectComponent( Entity sEntity, CPhysShape* srCompShape,
 	physObjectInfo.aCustomMass         = srCompObject->aCustomMass;
 	physObjectInfo.aMass               = srCompObject->aMass;
 
-	auto transform                     = Ent_GetComponent< CTransform >( sEntity, "transform" );
+	auto transform                     = Ent_GetComponent< CTransform >( sEntity );
 
 	if ( transform )
 	{
@@ -372,25 +375,34 @@ void EntSys_PhysObject::ComponentUpdated( Entity sEntity, void* spData )
 }
 
 
+bool EntSys_PhysObject::GetAccess( EntSysAccess_t& srAccess )
+{
+	// Creates shapes for objects that don't have one yet, same as EntSys_PhysShape
+	srAccess.Write< CPhysShape >();
+	srAccess.Write< CTransform >();
+	srAccess.aInterfaces = EEntSysInterface_Physics | EEntSysInterface_Graphics;
+	return true;
+}
+
+
 void EntSys_PhysObject::Update()
 {
 	PROF_SCOPE();
 
-	for ( Entity entity : aEntities )
-	{
-		auto physShape = Ent_GetComponent< CPhysShape >( entity, "physShape" );
-		auto physObject = Ent_GetComponent< CPhysObject >( entity, "physObject" );
+	EntityComponentPool*                 transformPool = Entity_GetComponentPool< CTransform >();
+	EntityView< CPhysObject, CPhysShape > view;
 
-		CH_ASSERT( physShape );
-		CH_ASSERT( physObject );
-
-		if ( !physShape || !physObject )
-			continue;
+	// Kept around so this doesn't allocate every frame
+	static std::vector< Entity > toCreate;
+	toCreate.clear();
 
+	view.Each( [ & ]( Entity entity, CPhysObject* physObject, CPhysShape* physShape )
+	{
+		// Created after the loop, so nothing changes the pools while we're going through them
 		if ( !physObject->apObj )
 		{
-			CreatePhysObjectComponent( entity, physShape, physObject );
-			continue;
+			toCreate.push_back( entity );
+			return;
 		}
 
 		if ( physObject->aMotionType != PhysMotionType::Static )
@@ -405,10 +417,10 @@ void EntSys_PhysObject::Update()
 		if ( physObject->aIsSensor.aIsDirty )
 			physObject->apObj->SetSensor( physObject->aIsSensor );
 
-		auto transform = Ent_GetComponent< CTransform >( entity, "transform" );
+		auto transform = static_cast< CTransform* >( transformPool->GetData( entity ) );
 
 		if ( !transform )
-			continue;
+			return;
 
 		physObject->apObj->SetScale( transform->aScale );
 
@@ -422,6 +434,15 @@ void EntSys_PhysObject::Update()
 			physObject->apObj->SetPos( transform->aPos );
 			physObject->apObj->SetAng( transform->aAng );
 		}
+	} );
+
+	for ( Entity entity : toCreate )
+	{
+		auto physObject = Ent_GetComponent< CPhysObject >( entity );
+		auto physShape  = Ent_GetComponent< CPhysShape >( entity );
+
+		if ( physObject && physShape )
+			CreatePhysObjectComponent( entity, physShape, physObject );
 	}
 }
 
@@ -853,6 +874,11 @@ void Phys_GetModelInd( ch_handle_t sModel, PhysDataConcave_t& srData )
 void Phys_Init()
 {
 	Phys_CreateEnv();
+
+	// No debug drawing on a headless server
+	if ( !graphics )
+		return;
+
 	Phys_DebugInit();
 	
 	gPhysDebugFuncs.apDrawLine          = Phys_DrawLine;
@@ -870,7 +896,7 @@ void Phys_Shutdown()
 {
 	for ( auto& [ handle, renderable ] : gPhysRenderables )
 	{
-		if ( !renderable )
+		if ( !renderable || !graphics )
 			continue;
 
 		graphics->FreeRenderable( renderable );
@@ -912,7 +938,7 @@ void Phys_Simulate( IPhysicsEnvironment* spPhysEnv, float sFrameTime )
 	// just to set visible to false
 	for ( auto& [ handle, renderHandle ] : gPhysRenderables )
 	{
-		if ( !renderHandle )
+		if ( !renderHandle || !graphics )
 			continue;
 
 		if ( Renderable_t* renderable = graphics->GetRenderableData( renderHandle ) )
@@ -925,6 +951,17 @@ void Phys_Simulate( IPhysicsEnvironment* spPhysEnv, float sFrameTime )
 }
 
 
+void Phys_SimulateCharacter( IPhysVirtualCharacter* spCharacter, float sFrameTime )
+{
+	PROF_SCOPE();
+
+	if ( !spCharacter )
+		return;
+
+	spCharacter->Update( sFrameTime );
+}
+
+
 void Phys_SetMaxVelocities( IPhysicsObject* spPhysObj )
 {
 	if ( !spPhysObj )
@@ -947,7 +984,7 @@ IPhysicsShape* Phys_CreateShape( Entity sEntity, PhysicsShapeInfo& srShapeInfo )
 	}
 
 	// Attach it to the Entity
-	auto shapeWrapper     = static_cast< CPhysShape* >( Entity_AddComponent( sEntity, "physShape" ) );
+	auto shapeWrapper     = Ent_AddComponent< CPhysShape >( sEntity );
 	shapeWrapper->apShape = shape;
 	shapeWrapper->aBounds = srShapeInfo.aBounds;
 
@@ -981,7 +1018,7 @@ CPhysObject* Phys_CreateObject( Entity sEntity, IPhysicsShape* spShape, PhysicsO
 		return nullptr;
 	}
 
-	CPhysObject* objWrapper         = static_cast< CPhysObject* >( Entity_AddComponent( sEntity, "physObject" ) );
+	CPhysObject* objWrapper         = Ent_AddComponent< CPhysObject >( sEntity );
 	objWrapper->apObj               = object;
 
 	objWrapper->aStartActive        = srObjectInfo.aStartActive;
@@ -85,6 +85,7 @@ class EntSys_PhysShape : public IEntityComponentSystem
 	void ComponentAdded( Entity sEntity, void* spData ) override;
 	void ComponentRemoved( Entity sEntity, void* spData ) override;
 	void ComponentUpdated( Entity sEntity, void* spData ) override;
+	bool GetAccess( EntSysAccess_t& srAccess ) override;
 	void Update() override;
 };
 
@@ -98,6 +99,7 @@ class EntSys_PhysObject : public IEntityComponentSystem
 	void ComponentAdded( Entity sEntity, void* spData ) override;
 	void ComponentRemoved( Entity sEntity, void* spData ) override;
 	void ComponentUpdated( Entity sEntity, void* spData ) override;
+	bool GetAccess( EntSysAccess_t& srAccess ) override;
 	void Update() override;
 };
 
@@ -121,6 +123,9 @@ void                      Phys_DestroyEnv();
 
 // Simulate This Physics Environment
 void                      Phys_Simulate( IPhysicsEnvironment* spPhysEnv, float sFrameTime );
+
+// Step only this character against the world, nothing else in the environment moves
+void                      Phys_SimulateCharacter( IPhysVirtualCharacter* spCharacter, float sFrameTime );
 void                      Phys_SetMaxVelocities( IPhysicsObject* spPhysObj );
 
 // Helper functions for creating physics shapes/objects in the physics engine and adding a component wrapper to the entity
@@ -137,8 +142,8 @@ bool                      Phys_CreatePhysShapeComponent( CPhysShape* compPhysSha
 extern Ch_IPhysics*       ch_physics;
 
 // Helper functions for getting the wrapper physics components
-inline auto GetComp_PhysShape( Entity ent )  { return Ent_GetComponent< CPhysShape >( ent, "physShape" ); }
-inline auto GetComp_PhysObject( Entity ent ) { return Ent_GetComponent< CPhysObject >( ent, "physObject" ); }
+inline auto GetComp_PhysShape( Entity ent )  { return Ent_GetComponent< CPhysShape >( ent ); }
+inline auto GetComp_PhysObject( Entity ent ) { return Ent_GetComponent< CPhysObject >( ent ); }
 
 inline IPhysicsShape* GetComp_PhysShapePtr( Entity ent )
 {
@@ -89,6 +89,10 @@ enum ECommandSource
 };
 
 
+// Max commands the server keeps queued for a client, the oldest are dropped past this
+constexpr u32 CH_USERCMD_QUEUE_SIZE = 64;
+
+
 // Keep in sync with NetMsgUserCmd in sidury.capnp
 struct UserCmd_t
 {
@@ -96,6 +100,12 @@ struct UserCmd_t
 	int             aButtons;
 	EPlayerMoveType aMoveType;
 	bool            aFlashlight;  // Temp, toggles the flashlight on/off
+
+	// Counts up by 1 for every command the client makes, 0 if this isn't a command from the client
+	u32             aCommandNumber;
+
+	// How long this command was held for, movement is simulated over this much time
+	float           aFrameTime;
 };
 
 
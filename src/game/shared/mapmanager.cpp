@@ -13,7 +13,9 @@
 
 #include "speedykeyv/KeyValue.h"
 
+#include <chrono>
 #include <filesystem>
+#include <future>
 
 
 LOG_CHANNEL_REGISTER( Map, ELogColor_DarkGreen );
@@ -24,6 +26,9 @@ chmap::Map*   gpChMap  = nullptr;
 std::string   gMapPath = "";
 
 
+CONVAR_RANGE_FLOAT( map_load_budget, 4, 0.1, 1000, "Most milliseconds spent each frame creating entities while a map is loading" );
+
+
 enum ESMF_CommandVersion : u16
 {
 	ESMF_CommandVersion_Invalid       = 0,
@@ -33,13 +38,20 @@ enum ESMF_CommandVersion : u16
 };
 
 
+static void MapManager_StepLoad( double sMaxTime );
+static void MapManager_CancelLoad();
+
+
 void MapManager_Update()
 {
+	MapManager_StepLoad( map_load_budget / 1000.0 );
 }
 
 
 void MapManager_CloseMap()
 {
+	MapManager_CancelLoad();
+
 	if ( gpChMap )
 	{
 		chmap::Free( gpChMap );
@@ -95,221 +107,603 @@ bool MapManager_MapExists( const std::string& path )
 }
 
 
-static bool MapManager_LoadScene( chmap::Scene& scene )
+// How to write one map value onto a registered component var
+struct MapVarDecode_t
+{
+	const char*  apName;
+	size_t       aNameLen;
+	size_t       aOffset;
+	EEntNetField aType;
+};
+
+
+// Map components that need more than copying values onto vars, spData is the registered component if there is one
+using FMapLoadComponent = void( Entity sEnt, const chmap::Component& srComp, void* spData );
+
+
+// Decode plan for a component type, built the first time a map uses it
+struct MapCompDecode_t
+{
+	EntityComponentPool*          apPool     = nullptr;
+	FMapLoadComponent*            apLoadFunc = nullptr;
+
+	std::vector< MapVarDecode_t > aVars;
+};
+
+
+// A var pointing to another entity in the map, set once every entity exists
+struct MapEntityRef_t
+{
+	EntityComponentPool* apPool;
+	Entity               aEntity;
+	size_t               aOffset;
+	u32                  aMapID;
+};
+
+
+// Map being loaded, see MapManager_LoadMapAsync()
+struct MapLoad_t
+{
+	EMapLoadState                                           aState = EMapLoadState_Idle;
+
+	std::string                                             aPath;
+	ch_string                                               aAbsPath{};
+
+	// Parsing the map files on a background thread
+	std::future< chmap::Map* >                              aParse;
+
+	// Next entity in the primary scene to create, then to parent
+	size_t                                                  aNextCreate = 0;
+	size_t                                                  aNextParent = 0;
+
+	// [Map Entity ID] = Entity
+	std::unordered_map< u32, Entity >                       aEntityHandles;
+
+	// [Component Name] = Decode Plan, names point into gpChMap
+	std::unordered_map< std::string_view, MapCompDecode_t > aCompDecode;
+
+	std::vector< MapEntityRef_t >                           aEntityRefs;
+};
+
+
+static MapLoad_t gMapLoad;
+
+
+static void MapManager_LoadLight( Entity sEnt, const chmap::Component& srComp, void* spData )
+{
+	auto                         light = static_cast< CLight* >( spData );
+	const chmap::ComponentValue* type  = srComp.Find( "type", 4 );
+
+	if ( !light )
+		return;
+
+	if ( !type )
+	{
+		Log_Error( gLC_Map, "Failed to find light type in component\n" );
+		return;
+	}
+
+	// Light types are written by name, numbers were already loaded onto the var
+	if ( type->type == chmap::EComponentType_String )
+	{
+		if ( ch_str_equals( type->aString, "world", 5 ) )
+			light->aType = ELightType_World;
+
+		else if ( ch_str_equals( type->aString, "point", 5 ) )
+			light->aType = ELightType_Point;
+
+		else if ( ch_str_equals( type->aString, "spot", 4 ) )
+			light->aType = ELightType_Spot;
+
+		// else if ( ch_str_equals( type->aString, "capsule" ))
+		// 	light->aType = ELightType_Capsule;
+
+		else
+			Log_ErrorF( gLC_Map, "Unknown Light Type: %s\n", type->aString.data );
+	}
+
+	// This lights everything, no matter where you are
+	if ( light->aType == ELightType_World )
+		Entity_SetAlwaysRelevant( sEnt );
+}
+
+
+// Not a registered component, this is split into a physics shape and object
+static void MapManager_LoadPhysObject( Entity sEnt, const chmap::Component& srComp, void* spData )
 {
-	std::unordered_map< u32, ch_handle_t > entityHandles;
+	const chmap::ComponentValue* path = srComp.Find( "path", 4 );
+	if ( !path )
+	{
+		Log_Error( gLC_Map, "Failed to find physics object path in component\n" );
+		return;
+	}
 
-	for ( chmap::Entity& mapEntity : scene.entites )
+	const chmap::ComponentValue* type = srComp.Find( "type", 4 );
+	if ( !type )
 	{
-		Entity ent = Entity_CreateEntity();
+		Log_Error( gLC_Map, "Failed to find physics object type in component\n" );
+		return;
+	}
 
-		if ( ent == CH_ENT_INVALID )
-		{
+	// why did you keep it split up like this?
+	auto physShape   = Ent_AddComponent< CPhysShape >( sEnt );
+	auto physObject  = Ent_AddComponent< CPhysObject >( sEnt );
+
+	physShape->aPath = path->aString.data;
+
+	if ( ch_str_equals( type->aString, "convex", 6 ) )
+	{
+		physObject->aStartActive   = true;
+		physObject->aMass          = 10.f;
+		physObject->aTransformMode = EPhysTransformMode_Update;
+		physShape->aShapeType      = PhysShapeType::Convex;
+	}
+	else if ( ch_str_equals( type->aString, "static_compound", 15 ) )
+	{
+		physObject->aStartActive   = true;
+		physObject->aMass          = 10.f;
+		physObject->aCustomMass    = true;
+		physObject->aTransformMode = EPhysTransformMode_Update;
+		physObject->aMotionType    = PhysMotionType::Dynamic;
+		physObject->aAllowSleeping = false;
+		physShape->aShapeType      = PhysShapeType::StaticCompound;
+	}
+	else if ( ch_str_equals( type->aString, "mesh", 4 ) )
+		physShape->aShapeType = PhysShapeType::Mesh;
+	else
+		physShape->aShapeType = PhysShapeType::Convex;
+}
+
+
+struct MapCompLoader_t
+{
+	const char*        apName;
+	size_t             aNameLen;
+	FMapLoadComponent* apFunc;
+};
+
+
+static MapCompLoader_t gMapCompLoaders[] = {
+	{ "light", 5, MapManager_LoadLight },
+	{ "phys_object", 11, MapManager_LoadPhysObject },
+};
+
+
+static MapCompDecode_t& MapManager_GetCompDecode( const chmap::Component& srComp )
+{
+	std::string_view name( srComp.name.data, srComp.name.size );
+
+	auto             it = gMapLoad.aCompDecode.find( name );
+	if ( it != gMapLoad.aCompDecode.end() )
+		return it->second;
+
+	MapCompDecode_t& decode = gMapLoad.aCompDecode[ name ];
+
+	for ( const MapCompLoader_t& loader : gMapCompLoaders )
+	{
+		if ( ch_str_equals( srComp.name, loader.apName, loader.aNameLen ) )
+			decode.apLoadFunc = loader.apFunc;
+	}
+
+	auto itReg = GetEntComponentRegistry().aComponentNames.find( name );
+
+	if ( itReg != GetEntComponentRegistry().aComponentNames.end() )
+	{
+		EntComponentData_t* regData = itReg->second;
+		decode.apPool               = Entity_GetComponentPoolByID( regData->aTypeID );
+		decode.aVars.reserve( regData->aVars.size() );
+
+		for ( const auto& [ offset, var ] : regData->aVars )
+			decode.aVars.push_back( { var.apName, var.aNameLen, offset, var.aType } );
+	}
+
+	if ( !decode.apPool && !decode.apLoadFunc )
+		Log_WarnF( gLC_Map, "Unknown Component in Map: \"%s\"\n", srComp.name.data );
+
+	return decode;
+}
+
+
+template< typename T >
+static bool MapManager_DecodeNumber( const chmap::ComponentValue& srValue, void* spVar )
+{
+	if ( srValue.type == chmap::EComponentType_Int )
+		*static_cast< T* >( spVar ) = static_cast< T >( srValue.aInteger );
+
+	else if ( srValue.type == chmap::EComponentType_Double )
+		*static_cast< T* >( spVar ) = static_cast< T >( srValue.aDouble );
+
+	else
+		return false;
+
+	return true;
+}
+
+
+// Copy the floats of a vector, any the map value doesn't have are left alone
+static bool MapManager_DecodeFloats( const chmap::ComponentValue& srValue, void* spVar, u32 sCount )
+{
+	u32 count = 0;
+
+	switch ( srValue.type )
+	{
+		default:
 			return false;
-		}
 
-		// Entity_SetName( ent, mapEntity.name );
-		entityHandles[ mapEntity.id ] = ent;
+		case chmap::EComponentType_Vec2:
+			count = 2;
+			break;
+
+		case chmap::EComponentType_Vec3:
+			count = 3;
+			break;
+
+		case chmap::EComponentType_Vec4:
+			count = 4;
+			break;
+	}
+
+	memcpy( spVar, &srValue.aVec4, std::min( count, sCount ) * sizeof( float ) );
+	return true;
+}
+
+
+// Write a map value onto a component var, returns false if it can't be converted to the var type
+static bool MapManager_DecodeValue( const chmap::ComponentValue& srValue, EEntNetField sType, void* spVar )
+{
+	switch ( sType )
+	{
+		default:
+			return false;
+
+		case EEntNetField_Bool:
+			return MapManager_DecodeNumber< bool >( srValue, spVar );
+
+		case EEntNetField_Float:
+			return MapManager_DecodeNumber< float >( srValue, spVar );
 
-		auto transform                = Ent_AddComponent< CTransform >( ent, "transform" );
+		case EEntNetField_Double:
+			return MapManager_DecodeNumber< double >( srValue, spVar );
 
-		transform->aPos               = mapEntity.pos;
-		transform->aAng               = mapEntity.ang;
-		transform->aScale             = mapEntity.scale;
+		case EEntNetField_S8:
+			return MapManager_DecodeNumber< s8 >( srValue, spVar );
 
-		// Check Built in components (TODO: IMPROVE THIS)
-		for ( chmap::Component& comp : mapEntity.components )
+		case EEntNetField_S16:
+			return MapManager_DecodeNumber< s16 >( srValue, spVar );
+
+		case EEntNetField_S32:
+			return MapManager_DecodeNumber< s32 >( srValue, spVar );
+
+		case EEntNetField_S64:
+			return MapManager_DecodeNumber< s64 >( srValue, spVar );
+
+		case EEntNetField_U8:
+			return MapManager_DecodeNumber< u8 >( srValue, spVar );
+
+		case EEntNetField_U16:
+			return MapManager_DecodeNumber< u16 >( srValue, spVar );
+
+		case EEntNetField_U32:
+			return MapManager_DecodeNumber< u32 >( srValue, spVar );
+
+		case EEntNetField_U64:
+			return MapManager_DecodeNumber< u64 >( srValue, spVar );
+
+		case EEntNetField_StdString:
+			if ( srValue.type != chmap::EComponentType_String )
+				return false;
+
+			static_cast< std::string* >( spVar )->assign( srValue.aString.data, srValue.aString.size );
+			return true;
+
+		case EEntNetField_Vec2:
+			return MapManager_DecodeFloats( srValue, spVar, 2 );
+
+		case EEntNetField_Color3:
+		case EEntNetField_Vec3:
+			return MapManager_DecodeFloats( srValue, spVar, 3 );
+
+		case EEntNetField_Color4:
+		case EEntNetField_Vec4:
+		case EEntNetField_Quat:
+			return MapManager_DecodeFloats( srValue, spVar, 4 );
+	}
+}
+
+
+static void MapManager_LoadComponent( Entity sEnt, const chmap::Component& srComp )
+{
+	MapCompDecode_t& decode = MapManager_GetCompDecode( srComp );
+	void*            data   = nullptr;
+
+	if ( decode.apPool )
+	{
+		data = decode.apPool->Create( sEnt );
+
+		if ( !data )
 		{
-			// Load a renderable
-			if ( ch_str_equals( comp.name, "renderable", 10 ) )
-			{
-				auto it = comp.values.find( "path" );
-				if ( it == comp.values.end() )
-				{
-					Log_Error( gLC_Map, "Failed to find renderable model path in component\n" );
-					continue;
-				}
-
-				if ( it->second.type != chmap::EComponentType_String )
-					continue;
-
-				auto renderable   = Ent_AddComponent< CRenderable >( ent, "renderable" );
-				renderable->aPath = it->second.aString.data;
-
-				// Load other renderable data
-				// for ( const auto& [ name, compValue ] : comp.values )
-				// {
-				// }
-			}
-			else if ( ch_str_equals( comp.name, "light", 5 ) )
-			{
-				auto it = comp.values.find( "type" );
-				if ( it == comp.values.end() )
-				{
-					Log_Error( gLC_Map, "Failed to find light type in component\n" );
-					continue;
-				}
-
-				if ( it->second.type != chmap::EComponentType_String )
-					continue;
-
-				auto light = Ent_AddComponent< CLight >( ent, "light" );
-
-				if ( ch_str_equals( it->second.aString, "world", 5 ) )
-				{
-					light->aType = ELightType_World;
-				}
-				else if ( ch_str_equals( it->second.aString, "point", 5 ) )
-				{
-					light->aType = ELightType_Point;
-				}
-				else if ( ch_str_equals( it->second.aString, "spot", 4 ) )
-				{
-					light->aType = ELightType_Spot;
-				}
-				// else if ( ch_str_equals( it->second.aString, "capsule" ))
-				// {
-				// 	light->aType = ELightType_Capsule;
-				// }
-				else
-				{
-					Log_ErrorF( gLC_Map, "Unknown Light Type: %s\n", it->second.aString.data );
-					continue;
-				}
-
-				// Read the rest of the light data
-				for ( const auto& [ name, compValue ] : comp.values )
-				{
-					if ( ch_str_equals( name.data(), name.size(), "color", 5 ) )
-					{
-						if ( compValue.type != chmap::EComponentType_Vec4 )
-							continue;
-
-						light->color = compValue.aVec4;
-					}
-					else if ( ch_str_equals( name.data(), name.size(), "radius", 6 ) )
-					{
-						if ( compValue.type == chmap::EComponentType_Int )
-							light->aRadius = compValue.aInteger;
-
-						else if ( compValue.type == chmap::EComponentType_Double )
-							light->aRadius = compValue.aDouble;
-					}
-				}
-			}
-			else if ( ch_str_equals( comp.name, "phys_object", 11 ) )
-			{
-				auto it = comp.values.find( "path" );
-				if ( it == comp.values.end() )
-				{
-					Log_Error( gLC_Map, "Failed to find physics object path in component\n" );
-					continue;
-				}
-
-				auto itType = comp.values.find( "type" );
-				if ( itType == comp.values.end() )
-				{
-					Log_Error( gLC_Map, "Failed to find physics object type in component\n" );
-					continue;
-				}
-
-				// why did you keep it split up like this?
-				auto physShape   = Ent_AddComponent< CPhysShape >( ent, "physShape" );
-				auto physObject  = Ent_AddComponent< CPhysObject >( ent, "physObject" );
-
-				physShape->aPath = it->second.aString.data;
-
-				if ( ch_str_equals( itType->second.aString, "convex", 6 ) )
-				{
-					physObject->aStartActive   = true;
-					physObject->aMass          = 10.f;
-					physObject->aTransformMode = EPhysTransformMode_Update;
-					physShape->aShapeType      = PhysShapeType::Convex;
-				}
-				else if ( ch_str_equals( itType->second.aString, "static_compound", 15 ) )
-				{
-					physObject->aStartActive   = true;
-					physObject->aMass          = 10.f;
-					physObject->aCustomMass    = true;
-					physObject->aTransformMode = EPhysTransformMode_Update;
-					physObject->aMotionType    = PhysMotionType::Dynamic;
-					physObject->aAllowSleeping = false;
-					physShape->aShapeType      = PhysShapeType::StaticCompound;
-				}
-				else if ( ch_str_equals( itType->second.aString, "mesh", 4 ) )
-					physShape->aShapeType = PhysShapeType::Mesh;
-				else
-					physShape->aShapeType = PhysShapeType::Convex;
+			Log_ErrorF( gLC_Map, "Failed to create component \"%s\"\n", srComp.name.data );
+			return;
+		}
 
-			}
-			else
-			{
-				// TODO: Try to search for this component
+		for ( const MapVarDecode_t& var : decode.aVars )
+		{
+			const chmap::ComponentValue* value = srComp.Find( var.apName, var.aNameLen );
+
+			if ( !value )
+				continue;
 
+			// Map entity IDs are turned into entities once they all exist
+			if ( var.aType == EEntNetField_Entity && value->type == chmap::EComponentType_Int )
+			{
+				gMapLoad.aEntityRefs.push_back( { decode.apPool, sEnt, var.aOffset, static_cast< u32 >( value->aInteger ) } );
+				continue;
 			}
+
+			if ( !MapManager_DecodeValue( *value, var.aType, static_cast< char* >( data ) + var.aOffset ) )
+				Log_DevF( gLC_Map, 2, "Can't load \"%s\" on component \"%s\", value is the wrong type\n", var.apName, srComp.name.data );
 		}
 	}
 
-	// Check entity parents
-	for ( chmap::Entity& mapEntity : scene.entites )
+	if ( decode.apLoadFunc )
+		decode.apLoadFunc( sEnt, srComp, data );
+}
+
+
+// Create an entity from the map, returns CH_ENT_INVALID if we're out of entities
+static Entity MapManager_CreateEntity( chmap::Entity& mapEntity )
+{
+	Entity ent = Entity_CreateEntity();
+
+	if ( ent == CH_ENT_INVALID )
+		return CH_ENT_INVALID;
+
+	// Entity_SetName( ent, mapEntity.name );
+	auto transform    = Ent_AddComponent< CTransform >( ent );
+
+	transform->aPos   = mapEntity.pos;
+	transform->aAng   = mapEntity.ang;
+	transform->aScale = mapEntity.scale;
+
+	for ( u32 compI = 0; compI < mapEntity.componentCount; compI++ )
+		MapManager_LoadComponent( ent, mapEntity.components[ compI ] );
+
+	return ent;
+}
+
+
+static double MapManager_GetTime()
+{
+	return std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+
+static void MapManager_FailLoad()
+{
+	Log_ErrorF( gLC_Map, "Failed to Load Map: \"%s\"\n", gMapLoad.aPath.c_str() );
+	gMapLoad.aState = EMapLoadState_Failed;
+}
+
+
+// The map files are parsed, set up the map so we can start creating entities
+static void MapManager_FinishParse( chmap::Map* map )
+{
+	if ( map == nullptr )
+	{
+		MapManager_FailLoad();
+		return;
+	}
+
+	gpChMap           = map;
+	gpMap             = new SiduryMap;
+	gpMap->aMapPath   = gMapLoad.aPath;
+
+	gMapPath.assign( gMapLoad.aAbsPath.data, gMapLoad.aAbsPath.size );
+	FileSys_InsertSearchPath( 0, gMapLoad.aAbsPath.data, gMapLoad.aAbsPath.size );
+
+	gMapLoad.aState = EMapLoadState_Creating;
+}
+
+
+// Create and parent entities from the primary scene until we run out of time, a time of 0 does everything
+// Returns true when every entity is done, the load state is set to failed if we run out of entities
+static bool MapManager_CreateEntities( double sMaxTime )
+{
+	chmap::Scene& scene     = gpChMap->scenes[ gpChMap->primaryScene ];
+	double        startTime = MapManager_GetTime();
+
+	// Parents are done after every entity exists, since they can be in any order
+	while ( gMapLoad.aNextCreate < scene.entites.size() || gMapLoad.aNextParent < scene.entites.size() )
 	{
+		if ( sMaxTime > 0.0 && MapManager_GetTime() - startTime > sMaxTime )
+			return false;
+
+		if ( gMapLoad.aNextCreate < scene.entites.size() )
+		{
+			chmap::Entity& mapEntity = scene.entites[ gMapLoad.aNextCreate++ ];
+			Entity         ent       = MapManager_CreateEntity( mapEntity );
+
+			if ( ent == CH_ENT_INVALID )
+			{
+				Log_ErrorF( gLC_Map, "Failed to Load Primary Scene, Out of Entities: \"%s\" - Scene \"%s\"\n", gMapLoad.aPath.c_str(), scene.name.data );
+				MapManager_FailLoad();
+				return false;
+			}
+
+			gMapLoad.aEntityHandles[ mapEntity.id ] = ent;
+			gpMap->aMapEntities.push_back( ent );
+			continue;
+		}
+
+		chmap::Entity& mapEntity = scene.entites[ gMapLoad.aNextParent++ ];
+
 		if ( mapEntity.parent == UINT32_MAX )
 			continue;
 
-		auto itID     = entityHandles.find( mapEntity.id );
-		auto itParent = entityHandles.find( mapEntity.parent );
+		auto itID     = gMapLoad.aEntityHandles.find( mapEntity.id );
+		auto itParent = gMapLoad.aEntityHandles.find( mapEntity.parent );
 
-		if ( itID == entityHandles.end() || itParent == entityHandles.end() )
+		if ( itID == gMapLoad.aEntityHandles.end() || itParent == gMapLoad.aEntityHandles.end() )
 		{
-			Log_ErrorF( "Failed to parent entity %d", mapEntity.id );
+			Log_ErrorF( gLC_Map, "Failed to parent entity %d", mapEntity.id );
 			continue;
 		}
 
 		Entity_ParentEntity( itID->second, itParent->second );
 	}
+
+	return true;
 }
 
 
-bool MapManager_LoadMap( const std::string& path )
+static void MapManager_FinishLoad()
 {
-	ch_string absPath = MapManager_FindMap( path );
+	for ( const MapEntityRef_t& ref : gMapLoad.aEntityRefs )
+	{
+		void* data = ref.apPool->GetData( ref.aEntity );
+		auto  it   = gMapLoad.aEntityHandles.find( ref.aMapID );
 
-	if ( !absPath.data )
+		if ( !data )
+			continue;
+
+		if ( it == gMapLoad.aEntityHandles.end() )
+		{
+			Log_ErrorF( gLC_Map, "Failed to find entity %d referenced by a component\n", ref.aMapID );
+			continue;
+		}
+
+		*reinterpret_cast< Entity* >( static_cast< char* >( data ) + ref.aOffset ) = it->second;
+	}
+
+	if ( gpChMap->skybox )
 	{
-		Log_WarnF( gLC_Map, "Map does not exist: \"%s\"\n", path.c_str() );
-		return false;
+		Entity skyboxEnt      = Entity_CreateEntity();
+		auto   skybox         = Ent_AddComponent< CSkybox >( skyboxEnt );
+		skybox->aMaterialPath = gpChMap->skybox;
+
+		gpMap->aMapEntities.push_back( skyboxEnt );
 	}
 
-	chmap::Map* map = chmap::Load( absPath.data, absPath.size );
+	gMapLoad.aEntityHandles.clear();
+	gMapLoad.aCompDecode.clear();
+	gMapLoad.aEntityRefs.clear();
+	gMapLoad.aState = EMapLoadState_Loaded;
 
-	if ( map == nullptr )
+	Log_MsgF( gLC_Map, "Loaded Map: \"%s\"\n", gMapLoad.aPath.c_str() );
+}
+
+
+// Move the map load along, a time of 0 finishes it
+static void MapManager_StepLoad( double sMaxTime )
+{
+	PROF_SCOPE();
+
+	if ( gMapLoad.aState == EMapLoadState_Parsing )
 	{
-		Log_ErrorF( gLC_Map, "Failed to Load Map: \"%s\"\n", path.c_str() );
-		return false;
+		// Don't wait on the parse unless we're finishing the load now
+		if ( sMaxTime > 0.0 && gMapLoad.aParse.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready )
+			return;
+
+		MapManager_FinishParse( gMapLoad.aParse.get() );
 	}
 
-	FileSys_InsertSearchPath( 0, absPath.data, absPath.size );
+	if ( gMapLoad.aState == EMapLoadState_Creating && MapManager_CreateEntities( sMaxTime ) )
+		MapManager_FinishLoad();
+}
+
 
-	// Only load the primary scene for now
-	// Each scene gets it's own editor context
-	// TODO: make an editor project system
-	if ( !MapManager_LoadScene( map->scenes[ map->primaryScene ] ) )
+static void MapManager_CancelLoad()
+{
+	// Wait for the parse to finish, we can't stop it partway through
+	if ( gMapLoad.aState == EMapLoadState_Parsing )
 	{
-		Log_ErrorF( gLC_Map, "Failed to Load Primary Scene: \"%s\" - Scene \"%s\"\n", path.c_str(), map->scenes[ map->primaryScene ].name );
-		return false;
+		chmap::Map* map = gMapLoad.aParse.get();
+
+		if ( map )
+			chmap::Free( map );
 	}
 
-	if ( map->skybox )
+	if ( gMapLoad.aAbsPath.data )
+		ch_str_free( gMapLoad.aAbsPath.data );
+
+	gMapLoad.aState    = EMapLoadState_Idle;
+	gMapLoad.aAbsPath  = {};
+	gMapLoad.aEntityHandles.clear();
+	gMapLoad.aCompDecode.clear();
+	gMapLoad.aEntityRefs.clear();
+}
+
+
+bool MapManager_LoadMapAsync( const std::string& path )
+{
+	MapManager_CloseMap();
+
+	ch_string absPath = MapManager_FindMap( path );
+
+	if ( !absPath.data )
 	{
-		Entity skyboxEnt      = Entity_CreateEntity();
-		auto   skybox         = Ent_AddComponent< CSkybox >( skyboxEnt, "skybox" );
-		skybox->aMaterialPath = map->skybox;
+		Log_WarnF( gLC_Map, "Map does not exist: \"%s\"\n", path.c_str() );
+		return false;
 	}
 
+	gMapLoad.aState      = EMapLoadState_Parsing;
+	gMapLoad.aPath       = path;
+	gMapLoad.aAbsPath    = absPath;
+	gMapLoad.aNextCreate = 0;
+	gMapLoad.aNextParent = 0;
+
+	// The path is kept around in gMapLoad until the load is done
+	gMapLoad.aParse      = std::async( std::launch::async, [ absPath ]()
+	{
+		return chmap::Load( absPath.data, absPath.size );
+	} );
+
 	return true;
 }
 
 
+bool MapManager_LoadMap( const std::string& path )
+{
+	if ( !MapManager_LoadMapAsync( path ) )
+		return false;
+
+	MapManager_StepLoad( 0.0 );
+	return gMapLoad.aState == EMapLoadState_Loaded;
+}
+
+
+EMapLoadState MapManager_GetLoadState()
+{
+	return gMapLoad.aState;
+}
+
+
+float MapManager_GetLoadProgress()
+{
+	switch ( gMapLoad.aState )
+	{
+		default:
+		case EMapLoadState_Idle:
+		case EMapLoadState_Failed:
+		case EMapLoadState_Parsing:
+			return 0.f;
+
+		case EMapLoadState_Loaded:
+			return 1.f;
+
+		case EMapLoadState_Creating:
+		{
+			size_t count = gpChMap->scenes[ gpChMap->primaryScene ].entites.size();
+
+			if ( count == 0 )
+				return 1.f;
+
+			return ( gMapLoad.aNextCreate + gMapLoad.aNextParent ) / ( count * 2.f );
+		}
+	}
+}
+
+
 SiduryMap* MapManager_CreateMap()
 {
 	return nullptr;
@@ -403,7 +797,13 @@ std::string_view MapManager_GetMapName()
 	if ( !gpMap )
 		return "";
 
-	return gpMap->aMapInfo->mapName;
+	if ( gpMap->aMapInfo )
+		return gpMap->aMapInfo->mapName;
+
+	if ( gpChMap && gpChMap->name.data )
+		return std::string_view( gpChMap->name.data, gpChMap->name.size );
+
+	return "";
 }
 
 
@@ -428,10 +828,10 @@ bool MapManager_LoadWorldModel()
 
 	gpMap->aMapEntities.push_back( worldEntity );
 
-	auto transform  = Ent_AddComponent< CTransform >( worldEntity, "transform" );
-	auto renderable = Ent_AddComponent< CRenderable >( worldEntity, "renderable" );
-	auto physShape  = Ent_AddComponent< CPhysShape >( worldEntity, "physShape" );
-	auto physObject = Ent_AddComponent< CPhysObject >( worldEntity, "physObject" );
+	auto transform  = Ent_AddComponent< CTransform >( worldEntity );
+	auto renderable = Ent_AddComponent< CRenderable >( worldEntity );
+	auto physShape  = Ent_AddComponent< CPhysShape >( worldEntity );
+	auto physObject = Ent_AddComponent< CPhysObject >( worldEntity );
 
 	CH_ASSERT( transform );
 	CH_ASSERT( renderable );
@@ -440,6 +840,9 @@ bool MapManager_LoadWorldModel()
 
 	renderable->aPath = gpMap->aMapInfo->modelPath;
 
+	// The world model covers the whole map, so it's always in range
+	Entity_SetAlwaysRelevant( worldEntity );
+
 	// rotate the world model
 	transform->aAng = gpMap->aMapInfo->ang;
 
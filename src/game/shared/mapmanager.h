@@ -91,9 +91,27 @@ struct CMapRoot
 };
 
 
+// Maps are parsed on a background thread, then their entities are created a few at a time each MapManager_Update()
+enum EMapLoadState
+{
+	EMapLoadState_Idle,
+	EMapLoadState_Parsing,   // Reading the map files on a background thread
+	EMapLoadState_Creating,  // Creating entities from the primary scene, map_load_budget limits the time spent each frame
+	EMapLoadState_Loaded,
+	EMapLoadState_Failed,
+};
+
+
 ch_string                         MapManager_FindMap( const std::string& srPath );
 bool                              MapManager_MapExists( const std::string& srPath );
 bool                              MapManager_LoadMap( const std::string& srPath );
+
+// Start loading a map without waiting for it, returns false if the map doesn't exist
+bool                              MapManager_LoadMapAsync( const std::string& srPath );
+EMapLoadState                     MapManager_GetLoadState();
+
+// From 0 to 1, how many entities in the map are done
+float                             MapManager_GetLoadProgress();
 // SiduryMap*       MapManager_CreateMap();
 void                              MapManager_WriteMap( const std::string& srPath );
 void                              MapManager_CloseMap();
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "main.h"
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+// ---------------------------------------------------------------------------
+// Bit packed buffers for network messages
+//
+// Values are packed down to the bit, integers are written as varints (7 bits per group + a continue bit),
+// and signed integers are zigzag encoded first so small negative numbers stay small
+
+
+// Largest value we will quantize a float to, anything past this is sent as a full float
+constexpr double CH_NET_QUANTIZE_MAX = 1 << 30;
+
+
+inline u64 Net_ZigZagEncode( s64 sValue )
+{
+	return ( static_cast< u64 >( sValue ) << 1 ) ^ static_cast< u64 >( sValue >> 63 );
+}
+
+
+inline s64 Net_ZigZagDecode( u64 sValue )
+{
+	return static_cast< s64 >( sValue >> 1 ) ^ -static_cast< s64 >( sValue & 1 );
+}
+
+
+class NetBitWriter
+{
+  public:
+	std::vector< u8 > aData;
+	size_t            aBitPos = 0;
+
+	void Clear()
+	{
+		aData.clear();
+		aBitPos = 0;
+	}
+
+	size_t GetSize() const
+	{
+		return aData.size();
+	}
+
+	const u8* GetData() const
+	{
+		return aData.data();
+	}
+
+	void WriteBit( bool sValue )
+	{
+		if ( ( aBitPos & 7 ) == 0 )
+			aData.push_back( 0 );
+
+		if ( sValue )
+			aData.back() |= 1 << ( aBitPos & 7 );
+
+		aBitPos++;
+	}
+
+	// Write the lowest sCount bits of sValue, up to 64
+	void WriteBits( u64 sValue, u32 sCount )
+	{
+		for ( u32 i = 0; i < sCount; i++ )
+			WriteBit( ( sValue >> i ) & 1 );
+	}
+
+	void WriteVarUInt( u64 sValue )
+	{
+		while ( sValue >= 0x80 )
+		{
+			WriteBits( ( sValue & 0x7F ) | 0x80, 8 );
+			sValue >>= 7;
+		}
+
+		WriteBits( sValue, 8 );
+	}
+
+	void WriteVarSInt( s64 sValue )
+	{
+		WriteVarUInt( Net_ZigZagEncode( sValue ) );
+	}
+
+	void WriteFloat( float sValue )
+	{
+		u32 bits;
+		memcpy( &bits, &sValue, sizeof( bits ) );
+		WriteBits( bits, 32 );
+	}
+
+	void WriteDouble( double sValue )
+	{
+		u64 bits;
+		memcpy( &bits, &sValue, sizeof( bits ) );
+		WriteBits( bits, 64 );
+	}
+
+	// Write a float snapped to a multiple of sPrecision, or a full float if sPrecision is 0 or the value is out of range
+	void WriteQuantizedFloat( float sValue, float sPrecision )
+	{
+		double scaled = sPrecision > 0.f ? std::round( sValue / sPrecision ) : 0.0;
+
+		if ( sPrecision <= 0.f || !std::isfinite( scaled ) || std::abs( scaled ) > CH_NET_QUANTIZE_MAX )
+		{
+			WriteBit( false );
+			WriteFloat( sValue );
+			return;
+		}
+
+		WriteBit( true );
+		WriteVarSInt( static_cast< s64 >( scaled ) );
+	}
+
+	void WriteString( std::string_view sValue )
+	{
+		WriteVarUInt( sValue.size() );
+
+		for ( char c : sValue )
+			WriteBits( static_cast< u8 >( c ), 8 );
+	}
+};
+
+
+class NetBitReader
+{
+  public:
+	const u8* apData    = nullptr;
+	size_t    aSize     = 0;
+	size_t    aBitPos   = 0;
+
+	// Set if we tried reading past the end of the buffer, all reads after that return 0
+	bool      aOverflow = false;
+
+	NetBitReader( const u8* spData, size_t sSize ) :
+		apData( spData ), aSize( sSize )
+	{
+	}
+
+	bool ReadBit()
+	{
+		if ( aBitPos >= aSize * 8 )
+		{
+			aOverflow = true;
+			return false;
+		}
+
+		bool value = ( apData[ aBitPos >> 3 ] >> ( aBitPos & 7 ) ) & 1;
+		aBitPos++;
+		return value;
+	}
+
+	u64 ReadBits( u32 sCount )
+	{
+		u64 value = 0;
+
+		for ( u32 i = 0; i < sCount; i++ )
+			value |= static_cast< u64 >( ReadBit() ) << i;
+
+		return value;
+	}
+
+	u64 ReadVarUInt()
+	{
+		u64 value = 0;
+
+		for ( u32 shift = 0; shift < 64; shift += 7 )
+		{
+			u64 group = ReadBits( 8 );
+			value |= ( group & 0x7F ) << shift;
+
+			if ( !( group & 0x80 ) || aOverflow )
+				break;
+		}
+
+		return value;
+	}
+
+	s64 ReadVarSInt()
+	{
+		return Net_ZigZagDecode( ReadVarUInt() );
+	}
+
+	float ReadFloat()
+	{
+		u32   bits = static_cast< u32 >( ReadBits( 32 ) );
+		float value;
+		memcpy( &value, &bits, sizeof( value ) );
+		return value;
+	}
+
+	double ReadDouble()
+	{
+		u64    bits = ReadBits( 64 );
+		double value;
+		memcpy( &value, &bits, sizeof( value ) );
+		return value;
+	}
+
+	float ReadQuantizedFloat( float sPrecision )
+	{
+		if ( !ReadBit() )
+			return ReadFloat();
+
+		return static_cast< float >( static_cast< double >( ReadVarSInt() ) * sPrecision );
+	}
+
+	std::string ReadString()
+	{
+		u64         size = ReadVarUInt();
+		std::string value;
+
+		// Don't let a bad length allocate a huge string
+		if ( size > aSize )
+		{
+			aOverflow = true;
+			return value;
+		}
+
+		value.resize( size );
+
+		for ( u64 i = 0; i < size; i++ )
+			value[ i ] = static_cast< char >( ReadBits( 8 ) );
+
+		return value;
+	}
+};
@@ -12,6 +12,7 @@
 #include <sys/types.h>
 #include <sys/ioctl.h>
 #include <errno.h>
+#include <algorithm>
 
 LOG_REGISTER_CHANNEL2( Network, LogColor::DarkCyan );
 
@@ -30,9 +31,21 @@ static ChVector< Socket_t > gSockets;
 
 //=============================================================================
 
+int Net_GetError()
+{
+	return errno;
+}
+
+
+const char* Net_ErrorString( int sError )
+{
+	return strerror( sError );
+}
+
+
 const char* Net_ErrorString()
 {
-	return "fixme";
+	return Net_ErrorString( Net_GetError() );
 }
 
 // temp
@@ -410,6 +423,112 @@ int Net_Write( Socket_t sSocket, ch_sockaddr& srAddr, const char* spData, int sL
 }
 
 
+int Net_ReadBatch( Socket_t sSocket, NetReadBatch_t& srBatch )
+{
+	mmsghdr msgs[ CH_NET_BATCH_COUNT ];
+	iovec   iovecs[ CH_NET_BATCH_COUNT ];
+
+	memset( msgs, 0, sizeof( msgs ) );
+
+	for ( int i = 0; i < CH_NET_BATCH_COUNT; i++ )
+	{
+		iovecs[ i ].iov_base          = srBatch.aPackets[ i ].aData;
+		iovecs[ i ].iov_len           = CH_NET_PACKET_SIZE;
+
+		msgs[ i ].msg_hdr.msg_iov     = &iovecs[ i ];
+		msgs[ i ].msg_hdr.msg_iovlen  = 1;
+		msgs[ i ].msg_hdr.msg_name    = &srBatch.aPackets[ i ].aAddr;
+		msgs[ i ].msg_hdr.msg_namelen = sizeof( ch_sockaddr );
+	}
+
+	srBatch.aCount = 0;
+
+	int ret        = recvmmsg( sSocket, msgs, CH_NET_BATCH_COUNT, MSG_DONTWAIT, nullptr );
+
+	if ( ret == -1 )
+	{
+		int errno_ = errno;
+
+		if ( errno_ == EWOULDBLOCK || errno_ == EAGAIN || errno_ == ECONNREFUSED )
+			return 0;
+
+		Log_ErrorF( gLC_Network, "Failed to read from socket: %s\n", Net_ErrorString() );
+		return -1;
+	}
+
+	for ( int i = 0; i < ret; i++ )
+	{
+		srBatch.aPackets[ i ].aLen = msgs[ i ].msg_len;
+
+		if ( msgs[ i ].msg_hdr.msg_flags & MSG_TRUNC )
+		{
+			Log_WarnF( gLC_Network, "Dropping datagram larger than %d bytes from \"%s\"\n", CH_NET_PACKET_SIZE, Net_AddrToString( srBatch.aPackets[ i ].aAddr ) );
+			srBatch.aPackets[ i ].aLen = 0;
+		}
+	}
+
+	srBatch.aCount = ret;
+	return ret;
+}
+
+
+int Net_FlushWrites( Socket_t sSocket, NetWriteQueue_t& srQueue )
+{
+	mmsghdr msgs[ CH_NET_BATCH_COUNT ];
+	iovec   iovecs[ CH_NET_BATCH_COUNT ];
+
+	int     written = 0;
+	size_t  start   = 0;
+
+	while ( start < srQueue.aPackets.size() )
+	{
+		int count = std::min< size_t >( srQueue.aPackets.size() - start, CH_NET_BATCH_COUNT );
+
+		memset( msgs, 0, sizeof( mmsghdr ) * count );
+
+		for ( int i = 0; i < count; i++ )
+		{
+			NetWriteQueue_t::Packet_t& packet = srQueue.aPackets[ start + i ];
+
+			iovecs[ i ].iov_base              = srQueue.aData.data() + packet.aOffset;
+			iovecs[ i ].iov_len               = packet.aLen;
+
+			msgs[ i ].msg_hdr.msg_iov         = &iovecs[ i ];
+			msgs[ i ].msg_hdr.msg_iovlen      = 1;
+			msgs[ i ].msg_hdr.msg_name        = &packet.aAddr;
+			msgs[ i ].msg_hdr.msg_namelen     = sizeof( ch_sockaddr );
+		}
+
+		int ret = sendmmsg( sSocket, msgs, count, 0 );
+
+		if ( ret == -1 )
+		{
+			int errno_ = errno;
+
+			// The socket buffer is full, drop the rest
+			if ( errno_ == EWOULDBLOCK || errno_ == EAGAIN )
+			{
+				Log_DevF( gLC_Network, 1, "Socket buffer full, dropping %zd datagrams\n", srQueue.aPackets.size() - start );
+				break;
+			}
+
+			// sendmmsg only fails on the first datagram, skip it and keep sending the rest
+			Log_ErrorF( gLC_Network, "Failed to write to socket: %s\n", Net_ErrorString( errno_ ) );
+			srQueue.aPackets[ start ].aError = errno_;
+			start++;
+			continue;
+		}
+
+		for ( int i = 0; i < ret; i++ )
+			written += msgs[ i ].msg_len;
+
+		start += ret;
+	}
+
+	return written;
+}
+
+
 int Net_MakeSocketBroadcastCapable( Socket_t sSocket )
 {
 	int i = 1;
@@ -1,6 +1,17 @@
+#include "main.h"
 #include "flatbuffers/flatbuffers.h"
 #include "net_main.h"
 
+#include <algorithm>
+#include <cstring>
+
+
+LOG_CHANNEL( Network );
+
+
+CONVAR_FLOAT( net_fragment_timeout, 2.0, "Seconds to wait for the rest of a fragmented message before dropping it" );
+CONVAR_FLOAT( net_reliable_resend, 0.2, "Seconds to wait for an ack before resending a reliable message, raised to twice the round trip time on slow connections" );
+
 
 #if 0
 int Net_ReadPacked( Socket_t sSocket, char* spData, int sLen, ch_sockaddr* spFrom )
@@ -20,12 +31,574 @@ int Net_ReadPacked( Socket_t sSocket, char* spData, int sLen, ch_sockaddr* spFro
 #endif
 
 
+// ---------------------------------------------------------------------------
+// Fragmentation
+
+
+struct NetReassembly_t
+{
+	ch_sockaddr         aAddr;
+	u16                 aMessageID;
+	u16                 aCount;
+	u16                 aReceived;
+	int                 aLastLen;
+	double              aStartTime;
+	bool                aActive = false;
+
+	std::vector< bool > aHave;
+
+	// Reused between messages, so this only allocates until it's grown to the largest message we get
+	std::vector< char > aData;
+};
+
+
+static NetReassembly_t gNetReassembly[ CH_NET_REASSEMBLY_SLOTS ];
+static u16             gNetMessageID = 0;
+
+
+// Game time, like the client timeouts, so these don't expire while the game is stalled on a long frame or a map load
+static double Net_GetTime()
+{
+	return Game_GetCurTime();
+}
+
+
+// Calls srFunc( header, data, len ) for each datagram this message is split into
+template< typename Func >
+static bool Net_SplitMessage( const char* spData, int sLen, Func srFunc )
+{
+	if ( sLen > CH_NET_MAX_MESSAGE_SIZE )
+	{
+		Log_ErrorF( gLC_Network, "Message too large to send: %d bytes, max is %d\n", sLen, CH_NET_MAX_MESSAGE_SIZE );
+		return false;
+	}
+
+	NetPacketHeader_t header{};
+
+	if ( sLen <= CH_NET_FRAGMENT_SIZE )
+	{
+		header.aType  = ENetPacket_Whole;
+		header.aCount = 1;
+		srFunc( header, spData, sLen );
+		return true;
+	}
+
+	header.aType      = ENetPacket_Fragment;
+	header.aMessageID = gNetMessageID++;
+	header.aCount     = ( sLen + CH_NET_FRAGMENT_SIZE - 1 ) / CH_NET_FRAGMENT_SIZE;
+
+	for ( u16 i = 0; i < header.aCount; i++ )
+	{
+		int offset    = i * CH_NET_FRAGMENT_SIZE;
+		header.aIndex = i;
+		srFunc( header, spData + offset, std::min( CH_NET_FRAGMENT_SIZE, sLen - offset ) );
+	}
+
+	return true;
+}
+
+
+int Net_WriteMessage( Socket_t sSocket, ch_sockaddr& srAddr, const char* spData, int sLen )
+{
+	alignas( 8 ) char packet[ CH_NET_MTU ];
+	int               sent   = 0;
+	bool              failed = false;
+
+	bool              valid  = Net_SplitMessage( spData, sLen, [ & ]( const NetPacketHeader_t& srHeader, const char* spFragment, int sFragmentLen )
+	{
+		memcpy( packet, &srHeader, sizeof( NetPacketHeader_t ) );
+		memcpy( packet + sizeof( NetPacketHeader_t ), spFragment, sFragmentLen );
+
+		int write = Net_Write( sSocket, srAddr, packet, sizeof( NetPacketHeader_t ) + sFragmentLen );
+
+		if ( write <= 0 )
+			failed = true;
+		else
+			sent += write;
+	} );
+
+	if ( !valid || failed )
+		return -1;
+
+	return sent;
+}
+
+
 int Net_WriteFlatBuffer( Socket_t sSocket, ch_sockaddr& srAddr, flatbuffers::FlatBufferBuilder& srBuilder )
 {
-	return Net_Write( sSocket, srAddr, reinterpret_cast< const char* >( srBuilder.GetBufferPointer() ), srBuilder.GetSize() );
+	return Net_WriteMessage( sSocket, srAddr, reinterpret_cast< const char* >( srBuilder.GetBufferPointer() ), srBuilder.GetSize() );
+}
+
+
+static NetReassembly_t* Net_FindReassembly( const ch_sockaddr& srFrom, const NetPacketHeader_t& srHeader )
+{
+	double           time   = Net_GetTime();
+	NetReassembly_t* reuse  = nullptr;
+	NetReassembly_t* free   = nullptr;
+	NetReassembly_t* oldest = nullptr;
+
+	for ( NetReassembly_t& slot : gNetReassembly )
+	{
+		if ( slot.aActive && time - slot.aStartTime > net_fragment_timeout )
+		{
+			Log_DevF( gLC_Network, 2, "Dropping incomplete message %d from %s, got %d of %d fragments\n",
+			          slot.aMessageID, Net_AddrToString( slot.aAddr ), slot.aReceived, slot.aCount );
+			slot.aActive = false;
+		}
+
+		if ( !slot.aActive )
+		{
+			if ( !free )
+				free = &slot;
+
+			continue;
+		}
+
+		if ( slot.aMessageID == srHeader.aMessageID && Net_AddrEqual( slot.aAddr, srFrom ) )
+		{
+			if ( slot.aCount == srHeader.aCount )
+				return &slot;
+
+			// A new message reusing the ID, the old one is never going to finish
+			reuse = &slot;
+			break;
+		}
+
+		if ( !oldest || slot.aStartTime < oldest->aStartTime )
+			oldest = &slot;
+	}
+
+	NetReassembly_t* slot = reuse ? reuse : free ? free : oldest;
+
+	slot->aAddr      = srFrom;
+	slot->aMessageID = srHeader.aMessageID;
+	slot->aCount     = srHeader.aCount;
+	slot->aReceived  = 0;
+	slot->aLastLen   = 0;
+	slot->aStartTime = time;
+	slot->aActive    = true;
+
+	slot->aHave.assign( srHeader.aCount, false );
+	slot->aData.resize( srHeader.aCount * CH_NET_FRAGMENT_SIZE );
+
+	return slot;
+}
+
+
+const char* Net_ReadMessage( const ch_sockaddr& srFrom, const char* spData, int sLen, int& srMsgLen )
+{
+	srMsgLen = 0;
+
+	if ( sLen < (int)sizeof( NetPacketHeader_t ) )
+		return nullptr;
+
+	NetPacketHeader_t header;
+	memcpy( &header, spData, sizeof( NetPacketHeader_t ) );
+
+	const char* data    = spData + sizeof( NetPacketHeader_t );
+	int         dataLen = sLen - sizeof( NetPacketHeader_t );
+
+	if ( header.aType == ENetPacket_Whole )
+	{
+		srMsgLen = dataLen;
+		return data;
+	}
+
+	if ( header.aType != ENetPacket_Fragment )
+		return nullptr;
+
+	bool lastFragment = header.aIndex + 1 == header.aCount;
+
+	// Every fragment but the last one is full
+	if ( header.aCount < 2 || header.aCount > CH_NET_MAX_FRAGMENTS || header.aIndex >= header.aCount || dataLen > CH_NET_FRAGMENT_SIZE ||
+	     ( !lastFragment && dataLen != CH_NET_FRAGMENT_SIZE ) )
+	{
+		Log_DevF( gLC_Network, 1, "Invalid fragment from %s\n", Net_AddrToString( const_cast< ch_sockaddr& >( srFrom ) ) );
+		return nullptr;
+	}
+
+	NetReassembly_t* slot = Net_FindReassembly( srFrom, header );
+
+	if ( slot->aHave[ header.aIndex ] )
+		return nullptr;
+
+	memcpy( slot->aData.data() + header.aIndex * CH_NET_FRAGMENT_SIZE, data, dataLen );
+	slot->aHave[ header.aIndex ] = true;
+	slot->aReceived++;
+
+	if ( lastFragment )
+		slot->aLastLen = dataLen;
+
+	if ( slot->aReceived < slot->aCount )
+		return nullptr;
+
+	// Done, the data stays in the slot until it's reused
+	slot->aActive = false;
+	srMsgLen      = ( slot->aCount - 1 ) * CH_NET_FRAGMENT_SIZE + slot->aLastLen;
+	return slot->aData.data();
+}
+
+
+void Net_ClearFragments()
+{
+	for ( NetReassembly_t& slot : gNetReassembly )
+		slot.aActive = false;
+}
+
+
+void Net_QueueWrite( NetWriteQueue_t& srQueue, ch_sockaddr& srAddr, const char* spData, int sLen )
+{
+	NetWriteQueue_t::Packet_t& packet = srQueue.aPackets.emplace_back();
+	packet.aAddr                      = srAddr;
+	packet.aOffset                    = srQueue.aData.size();
+	packet.aLen                       = sLen;
+	packet.aError                     = 0;
+
+	srQueue.aData.insert( srQueue.aData.end(), spData, spData + sLen );
+}
+
+
+void Net_QueueMessage( NetWriteQueue_t& srQueue, ch_sockaddr& srAddr, const char* spData, int sLen )
+{
+	Net_SplitMessage( spData, sLen, [ & ]( const NetPacketHeader_t& srHeader, const char* spFragment, int sFragmentLen )
+	{
+		NetWriteQueue_t::Packet_t& packet = srQueue.aPackets.emplace_back();
+		packet.aAddr                      = srAddr;
+		packet.aOffset                    = srQueue.aData.size();
+		packet.aLen                       = sizeof( NetPacketHeader_t ) + sFragmentLen;
+		packet.aError                     = 0;
+
+		const char* header                = reinterpret_cast< const char* >( &srHeader );
+		srQueue.aData.insert( srQueue.aData.end(), header, header + sizeof( NetPacketHeader_t ) );
+		srQueue.aData.insert( srQueue.aData.end(), spFragment, spFragment + sFragmentLen );
+	} );
+}
+
+
+void Net_QueueWriteFlatBuffer( NetWriteQueue_t& srQueue, ch_sockaddr& srAddr, flatbuffers::FlatBufferBuilder& srBuilder )
+{
+	Net_QueueMessage( srQueue, srAddr, reinterpret_cast< const char* >( srBuilder.GetBufferPointer() ), srBuilder.GetSize() );
+}
+
+
+// ---------------------------------------------------------------------------
+// Network Channels
+
+
+// Newer sequence numbers win, with wrap around
+static bool Net_SequenceGreater( u16 sA, u16 sB )
+{
+	return ( sA > sB && sA - sB <= 32768 ) || ( sA < sB && sB - sA > 32768 );
+}
+
+
+void NetChannel_Reset( NetChannel_t& srChannel )
+{
+	srChannel.aLocalSequence    = 0;
+	srChannel.aNextSendReliable = 0;
+	srChannel.aReliable.clear();
+
+	srChannel.aHasRemote        = false;
+	srChannel.aRemoteSequence   = 0;
+	srChannel.aAckBits          = 0;
+	srChannel.aNextRecvReliable = 0;
+
+	srChannel.aRTT              = 0.0;
+	srChannel.aOverflow         = false;
+
+	for ( NetChannelSent_t& sent : srChannel.aSent )
+		sent.aValid = false;
+
+	for ( NetChannelReceived_t& received : srChannel.aReceived )
+		received.aValid = false;
+}
+
+
+static void NetChannel_AckSequence( NetChannel_t& srChannel, u16 sSequence, double sTime )
+{
+	NetChannelSent_t& sent = srChannel.aSent[ sSequence % CH_NET_SEQUENCE_HISTORY ];
+
+	if ( !sent.aValid || sent.aAcked || sent.aSequence != sSequence )
+		return;
+
+	sent.aAcked = true;
+
+	// Smoothed so one slow packet doesn't throw off resends
+	double rtt  = sTime - sent.aTime;
+
+	if ( srChannel.aRTT == 0.0 )
+		srChannel.aRTT = rtt;
+	else
+		srChannel.aRTT += ( rtt - srChannel.aRTT ) * 0.1;
+
+	if ( !sent.aReliable )
+		return;
+
+	for ( NetChannelReliable_t& reliable : srChannel.aReliable )
+	{
+		if ( reliable.aID == sent.aReliableID )
+		{
+			reliable.aAcked = true;
+			break;
+		}
+	}
+
+	while ( srChannel.aReliable.size() && srChannel.aReliable.front().aAcked )
+		srChannel.aReliable.pop_front();
+}
+
+
+// Returns false if we already got this packet, or it's too old to tell
+static bool NetChannel_MarkReceived( NetChannel_t& srChannel, u16 sSequence )
+{
+	if ( !srChannel.aHasRemote )
+	{
+		srChannel.aHasRemote      = true;
+		srChannel.aRemoteSequence = sSequence;
+		srChannel.aAckBits        = 0;
+		return true;
+	}
+
+	if ( Net_SequenceGreater( sSequence, srChannel.aRemoteSequence ) )
+	{
+		u16 shift = sSequence - srChannel.aRemoteSequence;
+
+		// The old remote sequence becomes bit shift - 1
+		if ( shift > 32 )
+			srChannel.aAckBits = 0;
+		else
+			srChannel.aAckBits = static_cast< u32 >( ( static_cast< u64 >( srChannel.aAckBits ) << shift ) | ( 1ull << ( shift - 1 ) ) );
+
+		srChannel.aRemoteSequence = sSequence;
+		return true;
+	}
+
+	u16 diff = srChannel.aRemoteSequence - sSequence;
+
+	if ( diff == 0 || diff > 32 )
+		return false;
+
+	u32 bit = 1u << ( diff - 1 );
+
+	if ( srChannel.aAckBits & bit )
+		return false;
+
+	srChannel.aAckBits |= bit;
+	return true;
 }
 
 
+void NetChannel_Read( NetChannel_t& srChannel, const char* spData, int sLen, const FNetChannel_Read& srFunc )
+{
+	if ( sLen < (int)sizeof( NetChannelHeader_t ) )
+		return;
+
+	NetChannelHeader_t header;
+	memcpy( &header, spData, sizeof( NetChannelHeader_t ) );
+
+	if ( header.aFlags & ENetChannelFlag_HasAck )
+	{
+		double time = Net_GetTime();
+
+		NetChannel_AckSequence( srChannel, header.aAck, time );
+
+		for ( u16 i = 0; i < 32; i++ )
+		{
+			if ( header.aAckBits & ( 1u << i ) )
+				NetChannel_AckSequence( srChannel, header.aAck - ( i + 1 ), time );
+		}
+	}
+
+	if ( !NetChannel_MarkReceived( srChannel, header.aSequence ) )
+		return;
+
+	const char* data    = spData + sizeof( NetChannelHeader_t );
+	int         dataLen = sLen - sizeof( NetChannelHeader_t );
+
+	if ( !( header.aFlags & ENetChannelFlag_Reliable ) )
+	{
+		srFunc( data, dataLen );
+		return;
+	}
+
+	if ( header.aReliableID != srChannel.aNextRecvReliable )
+	{
+		// Already handed this one over, it was resent before our ack got there
+		if ( !Net_SequenceGreater( header.aReliableID, srChannel.aNextRecvReliable ) )
+			return;
+
+		u16 ahead = header.aReliableID - srChannel.aNextRecvReliable;
+
+		if ( ahead >= CH_NET_RELIABLE_WINDOW )
+		{
+			Log_DevF( gLC_Network, 1, "Dropping reliable message %d, too far ahead of %d\n", header.aReliableID, srChannel.aNextRecvReliable );
+			return;
+		}
+
+		// Hold onto it until everything before it arrives
+		NetChannelReceived_t& received = srChannel.aReceived[ header.aReliableID % CH_NET_RELIABLE_WINDOW ];
+		received.aID                   = header.aReliableID;
+		received.aValid                = true;
+		received.aData.assign( data, data + dataLen );
+		return;
+	}
+
+	srFunc( data, dataLen );
+	srChannel.aNextRecvReliable++;
+
+	// Hand over anything that was waiting on this one
+	while ( true )
+	{
+		NetChannelReceived_t& received = srChannel.aReceived[ srChannel.aNextRecvReliable % CH_NET_RELIABLE_WINDOW ];
+
+		if ( !received.aValid || received.aID != srChannel.aNextRecvReliable )
+			break;
+
+		received.aValid = false;
+		srFunc( received.aData.data(), received.aData.size() );
+		srChannel.aNextRecvReliable++;
+	}
+}
+
+
+// Keep a copy of a reliable message until it's acked
+static bool NetChannel_AddReliable( NetChannel_t& srChannel, const char* spData, int sLen, u16& srID )
+{
+	if ( srChannel.aOverflow )
+		return false;
+
+	if ( srChannel.aReliable.size() >= CH_NET_RELIABLE_WINDOW )
+	{
+		Log_ErrorF( gLC_Network, "Too many reliable messages waiting on an ack\n" );
+		srChannel.aOverflow = true;
+		return false;
+	}
+
+	NetChannelReliable_t& reliable = srChannel.aReliable.emplace_back();
+	reliable.aID                   = srChannel.aNextSendReliable++;
+	reliable.aLastSent             = Net_GetTime();
+	reliable.aData.assign( spData, spData + sLen );
+
+	srID                           = reliable.aID;
+	return true;
+}
+
+
+// Put the channel header on a message and give it to sSend( data, len )
+template< typename Func >
+static auto NetChannel_Send( NetChannel_t& srChannel, const char* spData, int sLen, bool sReliable, u16 sReliableID, Func sSend )
+{
+	NetChannelHeader_t header{};
+	header.aSequence   = srChannel.aLocalSequence++;
+	header.aReliableID = sReliableID;
+
+	if ( sReliable )
+		header.aFlags |= ENetChannelFlag_Reliable;
+
+	if ( srChannel.aHasRemote )
+	{
+		header.aFlags  |= ENetChannelFlag_HasAck;
+		header.aAck     = srChannel.aRemoteSequence;
+		header.aAckBits = srChannel.aAckBits;
+	}
+
+	NetChannelSent_t& sent = srChannel.aSent[ header.aSequence % CH_NET_SEQUENCE_HISTORY ];
+	sent.aSequence         = header.aSequence;
+	sent.aReliableID       = sReliableID;
+	sent.aValid            = true;
+	sent.aAcked            = false;
+	sent.aReliable         = sReliable;
+	sent.aTime             = Net_GetTime();
+
+	srChannel.aSendBuffer.resize( sizeof( NetChannelHeader_t ) + sLen );
+	memcpy( srChannel.aSendBuffer.data(), &header, sizeof( NetChannelHeader_t ) );
+	memcpy( srChannel.aSendBuffer.data() + sizeof( NetChannelHeader_t ), spData, sLen );
+
+	return sSend( srChannel.aSendBuffer.data(), (int)srChannel.aSendBuffer.size() );
+}
+
+
+int NetChannel_Write( NetChannel_t& srChannel, Socket_t sSocket, ch_sockaddr& srAddr, const char* spData, int sLen, bool sReliable )
+{
+	u16 reliableID = 0;
+
+	if ( sReliable && !NetChannel_AddReliable( srChannel, spData, sLen, reliableID ) )
+		return -1;
+
+	return NetChannel_Send( srChannel, spData, sLen, sReliable, reliableID, [ & ]( const char* spMsg, int sMsgLen )
+	{
+		return Net_WriteMessage( sSocket, srAddr, spMsg, sMsgLen );
+	} );
+}
+
+
+int NetChannel_WriteFlatBuffer( NetChannel_t& srChannel, Socket_t sSocket, ch_sockaddr& srAddr, flatbuffers::FlatBufferBuilder& srBuilder, bool sReliable )
+{
+	return NetChannel_Write( srChannel, sSocket, srAddr, reinterpret_cast< const char* >( srBuilder.GetBufferPointer() ), srBuilder.GetSize(), sReliable );
+}
+
+
+void NetChannel_Queue( NetChannel_t& srChannel, NetWriteQueue_t& srQueue, ch_sockaddr& srAddr, const char* spData, int sLen, bool sReliable )
+{
+	u16 reliableID = 0;
+
+	if ( sReliable && !NetChannel_AddReliable( srChannel, spData, sLen, reliableID ) )
+		return;
+
+	NetChannel_Send( srChannel, spData, sLen, sReliable, reliableID, [ & ]( const char* spMsg, int sMsgLen )
+	{
+		Net_QueueMessage( srQueue, srAddr, spMsg, sMsgLen );
+	} );
+}
+
+
+void NetChannel_QueueFlatBuffer( NetChannel_t& srChannel, NetWriteQueue_t& srQueue, ch_sockaddr& srAddr, flatbuffers::FlatBufferBuilder& srBuilder, bool sReliable )
+{
+	NetChannel_Queue( srChannel, srQueue, srAddr, reinterpret_cast< const char* >( srBuilder.GetBufferPointer() ), srBuilder.GetSize(), sReliable );
+}
+
+
+template< typename Func >
+static bool NetChannel_ResendReliable( NetChannel_t& srChannel, Func sSend )
+{
+	if ( srChannel.aOverflow )
+		return false;
+
+	double time       = Net_GetTime();
+
+	// Don't resend faster than the other side could possibly ack it
+	double resendTime = std::max( (double)net_reliable_resend, srChannel.aRTT * 2.0 );
+
+	for ( NetChannelReliable_t& reliable : srChannel.aReliable )
+	{
+		if ( reliable.aAcked || time - reliable.aLastSent < resendTime )
+			continue;
+
+		reliable.aLastSent = time;
+		NetChannel_Send( srChannel, reliable.aData.data(), reliable.aData.size(), true, reliable.aID, sSend );
+	}
+
+	return true;
+}
+
+
+bool NetChannel_Resend( NetChannel_t& srChannel, Socket_t sSocket, ch_sockaddr& srAddr )
+{
+	return NetChannel_ResendReliable( srChannel, [ & ]( const char* spMsg, int sMsgLen )
+	{
+		return Net_WriteMessage( sSocket, srAddr, spMsg, sMsgLen );
+	} );
+}
+
+
+bool NetChannel_QueueResend( NetChannel_t& srChannel, NetWriteQueue_t& srQueue, ch_sockaddr& srAddr )
+{
+	return NetChannel_ResendReliable( srChannel, [ & ]( const char* spMsg, int sMsgLen )
+	{
+		Net_QueueMessage( srQueue, srAddr, spMsg, sMsgLen );
+	} );
+}
+
 #if 0
 void Net_TestPacked()
 {
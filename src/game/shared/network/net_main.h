@@ -3,6 +3,10 @@
 
 #include "flatbuffers/flatbuffers.h"
 
+#include <cstring>
+#include <deque>
+#include <functional>
+
 
 enum ENetType : char
 {
@@ -35,10 +39,40 @@ struct ch_sockaddr
 };
 
 
-struct NetChannel_t
+inline bool Net_AddrEqual( const ch_sockaddr& srA, const ch_sockaddr& srB )
 {
+	return srA.sa_family == srB.sa_family && memcmp( srA.sa_data, srB.sa_data, sizeof( srA.sa_data ) ) == 0;
+}
+
+
+inline bool operator==( const ch_sockaddr& srA, const ch_sockaddr& srB )
+{
+	return Net_AddrEqual( srA, srB );
+}
+
+
+// Hashing Support for ch_sockaddr, so addresses can be used to look up who sent a packet
+namespace std
+{
+	template<> struct hash< ch_sockaddr >
+	{
+		size_t operator()( ch_sockaddr const& srAddr ) const
+		{
+			// FNV-1a
+			u64 value = 14695981039346656037ull ^ (u16)srAddr.sa_family;
+			value *= 1099511628211ull;
+
+			for ( unsigned char byte : srAddr.sa_data )
+			{
+				value ^= byte;
+				value *= 1099511628211ull;
+			}
+
+			return (size_t)value;
+		}
+	};
+}
 
-};
 
 #ifdef _WIN32
 
@@ -61,6 +95,13 @@ using Socket_t = int;
 // General Network Functions
 
 
+// Error from the last failed socket call, grab it right away, any other call can change it
+int         Net_GetError();
+
+// Readable name for an error from Net_GetError()
+const char* Net_ErrorString( int sError );
+
+// Readable name for the error from the last failed socket call
 const char* Net_ErrorString();
 
 bool        Net_Init();
@@ -79,13 +120,247 @@ int         Net_Connect( Socket_t sSocket, ch_sockaddr& srAddr );
 // Read Incoming Data from a Socket
 int         Net_Read( Socket_t sSocket, char* spData, int sLen, ch_sockaddr* spFrom );
 
-// Write Data to a Socket
+// Write a single Datagram to a Socket
 int         Net_Write( Socket_t sSocket, ch_sockaddr& srAddr, const char* spData, int sLen );
+
+// Write a Message to a Socket, split into fragments if it doesn't fit in one datagram
+// Returns the amount of bytes sent, or -1 if any fragment failed
+int         Net_WriteMessage( Socket_t sSocket, ch_sockaddr& srAddr, const char* spData, int sLen );
 int         Net_WriteFlatBuffer( Socket_t sSocket, ch_sockaddr& spAddr, flatbuffers::FlatBufferBuilder& srBuilder );
 
 int         Net_MakeSocketBroadcastCapable( Socket_t sSocket );
 
 
+// ---------------------------------------------------------------------------
+// Batched Reads and Writes
+// Moves many datagrams in one system call (recvmmsg/sendmmsg on Linux), other platforms do one call per datagram
+
+
+// Most datagrams read or sent in one system call
+constexpr int CH_NET_BATCH_COUNT = 64;
+
+// Largest datagram we can read, anything bigger is dropped
+constexpr int CH_NET_PACKET_SIZE = 8192;
+
+
+struct NetPacket_t
+{
+	ch_sockaddr aAddr;
+	int         aLen;
+
+	// Aligned so the message after the packet header can be verified in place
+	alignas( 8 ) char aData[ CH_NET_PACKET_SIZE ];
+};
+
+
+// Preallocated packets to read into, this is large, so keep it around instead of putting it on the stack
+struct NetReadBatch_t
+{
+	NetPacket_t aPackets[ CH_NET_BATCH_COUNT ];
+	int         aCount = 0;
+};
+
+
+// Datagrams waiting to be sent, the data is copied in, so the messages don't need to stay around until the flush
+// Cleared instead of freed, so queueing stops allocating after the first few ticks
+struct NetWriteQueue_t
+{
+	struct Packet_t
+	{
+		ch_sockaddr aAddr;
+		size_t      aOffset;
+		int         aLen;
+
+		// Set by Net_FlushWrites() to the error from Net_GetError() if this failed to send, 0 if it didn't
+		int         aError;
+	};
+
+	std::vector< Packet_t > aPackets;
+	std::vector< char >     aData;
+
+	void                    Clear()
+	{
+		aPackets.clear();
+		aData.clear();
+	}
+};
+
+
+// Read as many waiting datagrams as fit in the batch, returns the amount read, 0 if there was nothing, or -1 on an error
+int         Net_ReadBatch( Socket_t sSocket, NetReadBatch_t& srBatch );
+
+// Queue a single datagram
+void        Net_QueueWrite( NetWriteQueue_t& srQueue, ch_sockaddr& srAddr, const char* spData, int sLen );
+
+// Queue a message, split into fragments if it doesn't fit in one datagram
+void        Net_QueueMessage( NetWriteQueue_t& srQueue, ch_sockaddr& srAddr, const char* spData, int sLen );
+void        Net_QueueWriteFlatBuffer( NetWriteQueue_t& srQueue, ch_sockaddr& srAddr, flatbuffers::FlatBufferBuilder& srBuilder );
+
+// Send everything queued and return the amount of bytes sent, this doesn't clear the queue so you can check what failed
+// If the socket buffer fills up, the rest are dropped like any other lost packet
+int         Net_FlushWrites( Socket_t sSocket, NetWriteQueue_t& srQueue );
+
+
+// ---------------------------------------------------------------------------
+// Fragmentation
+// Every datagram starts with a packet header, messages larger than CH_NET_FRAGMENT_SIZE are split into fragments
+// and put back together on the other side before being handed to the game
+
+
+// Largest datagram we send, kept under the common internet MTU so routers don't fragment it for us
+constexpr int CH_NET_MTU                = 1200;
+
+// Most fragments a message can be split into, anything bigger is not sent
+constexpr int CH_NET_MAX_FRAGMENTS      = 1024;
+
+// Amount of messages we can be reassembling at once, the oldest one is dropped when this is full
+constexpr int CH_NET_REASSEMBLY_SLOTS   = 32;
+
+
+enum ENetPacket : u8
+{
+	ENetPacket_Whole,     // The entire message is in this packet
+	ENetPacket_Fragment,  // One piece of a larger message
+};
+
+
+// Kept at 8 bytes so the message data after it stays aligned for the flatbuffer verifier
+struct NetPacketHeader_t
+{
+	ENetPacket aType;
+	u8         aReserved;
+	u16        aMessageID;
+	u16        aIndex;
+	u16        aCount;
+};
+
+
+static_assert( sizeof( NetPacketHeader_t ) == 8 );
+
+
+constexpr int CH_NET_FRAGMENT_SIZE      = CH_NET_MTU - sizeof( NetPacketHeader_t );
+constexpr int CH_NET_MAX_MESSAGE_SIZE   = CH_NET_FRAGMENT_SIZE * CH_NET_MAX_FRAGMENTS;
+
+
+// Read the packet header off a received datagram
+// Returns the message if it's complete, or nullptr if this is a fragment of one we're still waiting on, or the packet is invalid
+// The returned data stays valid until the next call
+const char* Net_ReadMessage( const ch_sockaddr& srFrom, const char* spData, int sLen, int& srMsgLen );
+
+// Drop all partially received messages
+void        Net_ClearFragments();
+
+
 // ---------------------------------------------------------------------------
 // Network Channels
+// Sits on top of messages, every message gets a sequence number and acks for what we got from the other side
+// Reliable messages are kept until acked and resent if they take too long, and are handed to the game in the order they were sent
+// Unreliable messages are for state that is sent again every tick anyway, they are handed over as soon as they arrive
+
+
+// Amount of sent packets we remember for acks
+constexpr int CH_NET_SEQUENCE_HISTORY = 256;
+
+// Most reliable messages waiting on an ack, the connection is considered broken past this
+constexpr int CH_NET_RELIABLE_WINDOW  = 256;
+
+
+enum ENetChannelFlag : u8
+{
+	ENetChannelFlag_None     = 0,
+	ENetChannelFlag_Reliable = ( 1 << 0 ),  // This message is on the reliable channel
+	ENetChannelFlag_HasAck   = ( 1 << 1 ),  // The ack fields are valid, not set until we've got something from the other side
+};
+
+
+// Kept at 16 bytes so the message data after it stays aligned for the flatbuffer verifier
+struct NetChannelHeader_t
+{
+	u16 aSequence;
+	u16 aAck;         // Latest sequence we got from the other side
+	u32 aAckBits;     // Bit N is set if we got aAck - ( N + 1 )
+	u16 aReliableID;  // Order of this message on the reliable channel
+	u8  aFlags;       // ENetChannelFlag
+	u8  aReserved[ 5 ];
+};
+
+
+static_assert( sizeof( NetChannelHeader_t ) == 16 );
+
+
+struct NetChannelSent_t
+{
+	u16    aSequence;
+	u16    aReliableID;
+	bool   aValid    = false;
+	bool   aAcked    = false;
+	bool   aReliable = false;
+	double aTime;
+};
+
+
+struct NetChannelReliable_t
+{
+	u16                 aID;
+	bool                aAcked = false;
+	double              aLastSent;
+	std::vector< char > aData;
+};
+
+
+struct NetChannelReceived_t
+{
+	u16                 aID;
+	bool                aValid = false;
+	std::vector< char > aData;
+};
+
+
+struct NetChannel_t
+{
+	// Sending
+	u16                                 aLocalSequence = 0;
+	u16                                 aNextSendReliable = 0;
+	NetChannelSent_t                    aSent[ CH_NET_SEQUENCE_HISTORY ];
+	std::deque< NetChannelReliable_t >  aReliable;
+
+	// Receiving
+	bool                                aHasRemote = false;
+	u16                                 aRemoteSequence = 0;
+	u32                                 aAckBits = 0;
+	u16                                 aNextRecvReliable = 0;
+
+	// Reliable messages that arrived before the ones sent ahead of them
+	NetChannelReceived_t                aReceived[ CH_NET_RELIABLE_WINDOW ];
+
+	// Smoothed round trip time in seconds, 0 until we get our first ack
+	double                              aRTT = 0.0;
+
+	// Set when too many reliable messages are waiting on an ack, nothing else can be sent reliably after this
+	bool                                aOverflow = false;
+
+	// Message with the header on it, reused so sending doesn't allocate
+	std::vector< char >                 aSendBuffer;
+};
+
+
+// Called for each message ready to be handed to the game
+using FNetChannel_Read = std::function< void( const char* spData, int sLen ) >;
+
+
+void        NetChannel_Reset( NetChannel_t& srChannel );
+
+// Read a message sent through a channel, srFunc is called for the message and any reliable ones that were waiting on it
+void        NetChannel_Read( NetChannel_t& srChannel, const char* spData, int sLen, const FNetChannel_Read& srFunc );
+
+// Send a message through a channel, returns the amount of bytes sent, or -1 if it failed
+int         NetChannel_Write( NetChannel_t& srChannel, Socket_t sSocket, ch_sockaddr& srAddr, const char* spData, int sLen, bool sReliable );
+int         NetChannel_WriteFlatBuffer( NetChannel_t& srChannel, Socket_t sSocket, ch_sockaddr& srAddr, flatbuffers::FlatBufferBuilder& srBuilder, bool sReliable );
+
+void        NetChannel_Queue( NetChannel_t& srChannel, NetWriteQueue_t& srQueue, ch_sockaddr& srAddr, const char* spData, int sLen, bool sReliable );
+void        NetChannel_QueueFlatBuffer( NetChannel_t& srChannel, NetWriteQueue_t& srQueue, ch_sockaddr& srAddr, flatbuffers::FlatBufferBuilder& srBuilder, bool sReliable );
 
+// Send reliable messages again if they haven't been acked in time, call this every update
+// Returns false if the channel overflowed and the connection should be dropped
+bool        NetChannel_Resend( NetChannel_t& srChannel, Socket_t sSocket, ch_sockaddr& srAddr );
+bool        NetChannel_QueueResend( NetChannel_t& srChannel, NetWriteQueue_t& srQueue, ch_sockaddr& srAddr );
@@ -41,12 +41,16 @@ inline Socket_t Net_ToSocket( SOCKET sSocket )
 
 //=============================================================================
 
-const char* Net_ErrorString()
+int Net_GetError()
 {
-#ifdef _WIN32
-	int code = CH_SOCKET_ERROR;
+	return CH_SOCKET_ERROR;
+}
 
-	switch ( code )
+
+const char* Net_ErrorString( int sError )
+{
+#ifdef _WIN32
+	switch ( sError )
 	{
 		case WSAEINTR:              return "WSAEINTR";
 		case WSAEBADF:              return "WSAEBADF";
@@ -95,11 +99,17 @@ const char* Net_ErrorString()
 		default:                    return "NO ERROR";
 	}
 #else
-	return strerror( CH_SOCKET_ERROR );
+	return strerror( sError );
 #endif
 }
 
 
+const char* Net_ErrorString()
+{
+	return Net_ErrorString( Net_GetError() );
+}
+
+
 bool Net_Init()
 {
 	gNetInit = false;
@@ -488,6 +498,59 @@ int Net_Write( Socket_t sSocket, ch_sockaddr& srAddr, const char* spData, int sL
 }
 
 
+// No recvmmsg/sendmmsg on Windows, so these do one call per datagram
+int Net_ReadBatch( Socket_t sSocket, NetReadBatch_t& srBatch )
+{
+	srBatch.aCount = 0;
+
+	while ( srBatch.aCount < CH_NET_BATCH_COUNT )
+	{
+		NetPacket_t& packet = srBatch.aPackets[ srBatch.aCount ];
+		int          ret    = Net_Read( sSocket, packet.aData, CH_NET_PACKET_SIZE, &packet.aAddr );
+
+		if ( ret == -1 )
+			return srBatch.aCount ? srBatch.aCount : -1;
+
+		if ( ret == 0 )
+			break;
+
+		packet.aLen = ret;
+		srBatch.aCount++;
+	}
+
+	return srBatch.aCount;
+}
+
+
+int Net_FlushWrites( Socket_t sSocket, NetWriteQueue_t& srQueue )
+{
+	int written = 0;
+
+	for ( NetWriteQueue_t::Packet_t& packet : srQueue.aPackets )
+	{
+		int ret = sendto( (SOCKET)sSocket, srQueue.aData.data() + packet.aOffset, packet.aLen, 0, (struct sockaddr*)&packet.aAddr, sizeof( ch_sockaddr ) );
+
+		if ( ret == -1 )
+		{
+			// Grab this before logging, which can change it
+			int error = Net_GetError();
+
+			// The socket buffer is full, drop the rest
+			if ( error == WSAEWOULDBLOCK )
+				break;
+
+			Log_ErrorF( gLC_Network, "Failed to write to socket: %s\n", Net_ErrorString( error ) );
+			packet.aError = error;
+			continue;
+		}
+
+		written += ret;
+	}
+
+	return written;
+}
+
+
 int Net_MakeSocketBroadcastCapable( Socket_t sSocket )
 {
 	int i = 1;
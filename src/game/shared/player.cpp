@@ -97,6 +97,13 @@ CONVAR_FLOAT( cl_zoom_duration, 0.4 );
 
 CONVAR_FLOAT( cl_duck_time, 0.4 );
 
+CONVAR_RANGE_INT( sv_usercmd_max_per_tick, 16, 1, CH_USERCMD_QUEUE_SIZE, CVARF_SERVER, "Max commands run for a client each tick, the rest wait for the next tick" );
+CONVAR_RANGE_FLOAT( sv_usercmd_time_buffer, 0.25, 0, 2, CVARF_SERVER, "Seconds of movement a client can save up and run at once, for commands arriving in bursts" );
+
+#if CH_SERVER
+CONVAR_FLOAT_EXT( sv_usercmd_max_frametime );
+#endif
+
 CONVAR_BOOL( sv_land_smoothing, 1 );
 CONVAR_FLOAT( sv_land_max_speed, 30 );
 CONVAR_FLOAT( sv_land_vel_scale, 1 );  // 0.01
@@ -334,6 +341,13 @@ void PlayerManager::ComponentUpdated( Entity sEntity, void* spData )
 }
 
 
+bool PlayerManager::GetAccess( EntSysAccess_t& srAccess )
+{
+	// Players are moved by the game loop through Update( frameTime ), nothing happens alongside the other systems
+	return true;
+}
+
+
 bool PlayerManager::SetCurrentPlayer( Entity player )
 {
 	CH_ASSERT( apMove );
@@ -365,7 +379,7 @@ bool PlayerManager::SetCurrentPlayer( Entity player )
 	apMove->apCamDir       = GetComp_Direction( playerInfo->aCamera );
 	apMove->apCamera       = GetCamera( playerInfo->aCamera );
 
-	apMove->apDir          = Ent_GetComponent< CDirection >( player, "direction" );
+	apMove->apDir          = Ent_GetComponent< CDirection >( player );
 	apMove->apRigidBody    = GetRigidBody( player );
 	apMove->apTransform    = GetTransform( player );
 	apMove->apCharacter    = apMove->apCharacter;
@@ -389,9 +403,49 @@ void PlayerManager::Init()
 }
 
 
+// Create the physics shapes and virtual character used for player movement
+static IPhysVirtualCharacter* Player_CreateCharacter()
+{
+	// ------------------------------------------------------------------------------
+	// Setup Physics Shapes
+
+	PhysicsShapeInfo charShapeInfo( PhysShapeType::Cylinder );
+	charShapeInfo.aBounds                  = { gPlayerPhysHeight, 0.377, 1 };
+
+	gPlayerShapeStanding  = GetPhysEnv()->CreateShape( charShapeInfo );
+
+	PhysicsShapeInfo duckShapeInfo( PhysShapeType::Cylinder );
+	duckShapeInfo.aBounds = { gPlayerPhysHeightDuck, 0.377, 1 };
+
+	gPlayerShapeCrouch    = GetPhysEnv()->CreateShape( duckShapeInfo );
+
+	// ------------------------------------------------------------------------------
+	// Setup Virtual Character Physics Object
+
+	PhysVirtualCharacterSettings charSettings{};
+	charSettings.shape                     = gPlayerShapeStanding;
+	charSettings.up                        = vec_up;
+	charSettings.mass                      = PLAYER_MASS;
+	charSettings.maxSlopeAngle             = 35;
+	//charSettings.predictiveContactDistance = 20.f;
+	//charSettings.characterPadding    = 0.2f;
+	//charSettings.collisionTolerance  = 0.2f;
+
+	// charSettings.maxCollisionIterations    = 25;
+	// charSettings.maxConstraintIterations   = 50;
+
+	IPhysVirtualCharacter* character = GetPhysEnv()->CreateVirtualCharacter( charSettings );
+
+	character->SetRotation( AngToQuat( glm::radians( glm::vec3( 90.f, 0.f, 0.f ) ) ) );
+	character->SetShapeOffset( { 0, gPlayerPhysHeight / 2.f, 0 } );
+
+	return character;
+}
+
+
 void PlayerManager::Create( Entity player )
 {
-	CPlayerInfo* playerInfo = Ent_GetComponent< CPlayerInfo >( player, "playerInfo" );
+	CPlayerInfo* playerInfo = Ent_GetComponent< CPlayerInfo >( player );
 	CH_ASSERT( playerInfo );
 
 #if CH_CLIENT
@@ -411,18 +465,18 @@ void PlayerManager::Create( Entity player )
 	// ------------------------------------------------------------------------------
 	// Setup Player Entity Components
 
-	auto playerMove = Ent_AddComponent< CPlayerMoveData >( player, "playerMoveData" );
+	auto playerMove = Ent_AddComponent< CPlayerMoveData >( player );
 
-	Ent_AddComponent( player, "rigidBody" );
-	Ent_AddComponent( player, "direction" );
+	Ent_AddComponent< CRigidBody >( player );
+	Ent_AddComponent< CDirection >( player );
 
-	auto renderable   = Ent_AddComponent< CRenderable >( player, "renderable" );
+	auto renderable   = Ent_AddComponent< CRenderable >( player );
 	renderable->aPath = DEFAULT_PROTOGEN_PATH;
 
-	auto flashlight   = Ent_AddComponent< CLight >( player, "light" );
-	auto zoom         = Ent_AddComponent< CPlayerZoom >( player, "playerZoom" );
-	auto transform    = Ent_AddComponent< CTransform >( player, "transform" );
-	auto health       = Ent_AddComponent< CHealth >( player, "health" );
+	auto flashlight   = Ent_AddComponent< CLight >( player );
+	auto zoom         = Ent_AddComponent< CPlayerZoom >( player );
+	auto transform    = Ent_AddComponent< CTransform >( player );
+	auto health       = Ent_AddComponent< CHealth >( player );
 	//auto suit         = Ent_AddComponent< CSuit >( player, "suit" );
 
 	CH_ASSERT( flashlight );
@@ -444,10 +498,10 @@ void PlayerManager::Create( Entity player )
 	Entity_ParentEntity( playerInfo->aCamera, player );
 	// Entity_ParentEntity( playerInfo->aFlashlight, player );
 
-	Ent_AddComponent( playerInfo->aCamera, "transform" );
-	Ent_AddComponent( playerInfo->aCamera, "direction" );
+	Ent_AddComponent< CTransform >( playerInfo->aCamera );
+	Ent_AddComponent< CDirection >( playerInfo->aCamera );
 
-	CCamera* camera = Ent_AddComponent< CCamera >( playerInfo->aCamera, "camera" );
+	CCamera* camera = Ent_AddComponent< CCamera >( playerInfo->aCamera );
 	camera->aFov    = r_fov;
 
 	zoom->aOrigFov             = r_fov;
@@ -463,40 +517,10 @@ void PlayerManager::Create( Entity player )
 	// flashlight->color    = { r_flashlight_brightness, r_flashlight_brightness, r_flashlight_brightness };
 	flashlight->color.Edit()  = { r_flashlight_color.x, r_flashlight_color.y, r_flashlight_color.z, r_flashlight_brightness };
 
-	// ------------------------------------------------------------------------------
-	// Setup Physics Shapes
-
-	PhysicsShapeInfo charShapeInfo( PhysShapeType::Cylinder );
-	charShapeInfo.aBounds                  = { gPlayerPhysHeight, 0.377, 1 };
-
-	gPlayerShapeStanding  = GetPhysEnv()->CreateShape( charShapeInfo );
-
-	PhysicsShapeInfo duckShapeInfo( PhysShapeType::Cylinder );
-	duckShapeInfo.aBounds = { gPlayerPhysHeightDuck, 0.377, 1 };
-
-	gPlayerShapeCrouch    = GetPhysEnv()->CreateShape( duckShapeInfo );
-
 	// ------------------------------------------------------------------------------
 	// Setup Virtual Character Physics Object
 
-	PhysVirtualCharacterSettings charSettings{};
-	charSettings.shape                     = gPlayerShapeStanding;
-	charSettings.up                        = vec_up;
-	charSettings.mass                      = PLAYER_MASS;
-	charSettings.maxSlopeAngle             = 35;
-	//charSettings.predictiveContactDistance = 20.f;
-	//charSettings.characterPadding    = 0.2f;
-	//charSettings.collisionTolerance  = 0.2f;
-
-	// charSettings.maxCollisionIterations    = 25;
-	// charSettings.maxConstraintIterations   = 50;
-
-	IPhysVirtualCharacter* character = GetPhysEnv()->CreateVirtualCharacter( charSettings );
-
-	playerMove->apCharacter          = character;
-
-	character->SetRotation( AngToQuat( glm::radians( glm::vec3( 90.f, 0.f, 0.f ) ) ) );
-	character->SetShapeOffset( { 0, gPlayerPhysHeight / 2.f, 0 } );
+	playerMove->apCharacter = Player_CreateCharacter();
 
 	// auto compPhysShape        = Ent_AddComponent< CPhysShape >( player, "physShape" );
 	// compPhysShape->aShapeType = PhysShapeType::Cylinder;
@@ -613,10 +637,10 @@ void Player_UpdateFlashlight( Entity player, bool sToggle )
 	CH_ASSERT( playerInfo->aCamera );
 
 	CTransform* transform    = GetTransform( player );
-	CLight*     flashlight   = Ent_GetComponent< CLight >( player, "light" );
+	CLight*     flashlight   = Ent_GetComponent< CLight >( player );
 
 	CTransform* camTransform = GetTransform( playerInfo->aCamera );
-	auto        camDir       = Ent_GetComponent< CDirection >( playerInfo->aCamera, "direction" );
+	auto        camDir       = Ent_GetComponent< CDirection >( playerInfo->aCamera );
 
 	CH_ASSERT( transform );
 	CH_ASSERT( camTransform );
@@ -701,8 +725,6 @@ void PlayerManager::Update( float frameTime )
 		PROF_SCOPE_NAMED( "Player" );
 		CH_PROF_ZONE_TEXT( client->name.c_str(), client->name.size() );
 
-		UserCmd_t& userCmd    = client->aUserCmd;
-
 		auto playerInfo = GetPlayerInfo( player );
 		// auto camera     = GetCamera( player );
 
@@ -711,24 +733,25 @@ void PlayerManager::Update( float frameTime )
 
 		if ( !Game_IsPaused() )
 		{
-			// Update Client UserCmd
-			auto transform    = GetTransform( player );
-			auto camTransform = GetTransform( playerInfo->aCamera );
-
-			CH_ASSERT( transform );
-			CH_ASSERT( camTransform );
+			// Commands can't run more time than has passed here, plus a little saved up for when they arrive late
+			// Always leave room for the longest command, or it would never run
+			float maxTime        = frameTime + glm::max( (float)sv_usercmd_time_buffer, (float)sv_usercmd_max_frametime );
+			client->aUserCmdTime = glm::min( client->aUserCmdTime + frameTime, maxTime );
 
-			// transform.aAng[PITCH] = -mouse.y;
-			camTransform->aAng.Edit()[ PITCH ] = userCmd.aAng[ PITCH ];
-			camTransform->aAng.Edit()[ YAW ]   = userCmd.aAng[ YAW ];
-			camTransform->aAng.Edit()[ ROLL ]  = userCmd.aAng[ ROLL ];
+			// Run movement once for every command the client sent, instead of once a tick with whatever came in last
+			for ( int i = 0; i < sv_usercmd_max_per_tick && client->aUserCmdQueue.size(); i++ )
+			{
+				// Wait for more time to pass, if they keep sending too much the queue fills up and drops them
+				if ( client->aUserCmdQueue.front().aFrameTime > client->aUserCmdTime )
+					break;
 
-			transform->aAng.Set( { 0.f, DegreeConstrain( userCmd.aAng[ YAW ] ), 0.f } );
+				client->aUserCmd = client->aUserCmdQueue.front();
+				client->aUserCmdQueue.pop_front();
 
-			ClampAngles( camTransform );
+				client->aUserCmdTime -= client->aUserCmd.aFrameTime;
 
-			apMove->MovePlayer( player, &userCmd );
-			Player_UpdateFlashlight( player, userCmd.aFlashlight );
+				RunUserCmd( player, playerInfo, client->aUserCmd );
+			}
 		}
 
 		UpdateView( playerInfo, player );
@@ -737,6 +760,163 @@ void PlayerManager::Update( float frameTime )
 }
 
 
+static void ApplyUserCmdAngles( CTransform* spTransform, CTransform* spCamTransform, const UserCmd_t& srUserCmd )
+{
+	// transform.aAng[PITCH] = -mouse.y;
+	spCamTransform->aAng.Edit()[ PITCH ] = srUserCmd.aAng[ PITCH ];
+	spCamTransform->aAng.Edit()[ YAW ]   = srUserCmd.aAng[ YAW ];
+	spCamTransform->aAng.Edit()[ ROLL ]  = srUserCmd.aAng[ ROLL ];
+
+	spTransform->aAng.Set( { 0.f, DegreeConstrain( srUserCmd.aAng[ YAW ] ), 0.f } );
+
+	ClampAngles( spCamTransform );
+}
+
+
+void PlayerManager::RunUserCmd( Entity player, CPlayerInfo* playerInfo, UserCmd_t& srUserCmd )
+{
+	PROF_SCOPE();
+
+	auto transform    = GetTransform( player );
+	auto camTransform = GetTransform( playerInfo->aCamera );
+
+	CH_ASSERT( transform );
+	CH_ASSERT( camTransform );
+
+	ApplyUserCmdAngles( transform, camTransform, srUserCmd );
+
+	// Movement reads gFrameTime, so simulate over the time this command was held for instead of the tick
+	float tickFrameTime = gFrameTime;
+	gFrameTime          = srUserCmd.aFrameTime;
+
+	apMove->MovePlayer( player, &srUserCmd );
+	Player_UpdateFlashlight( player, srUserCmd.aFlashlight );
+
+	// Step the character over this command, the same way the client predicts it
+	// Stepping once a tick after all commands ran would only apply the velocity from the last one
+	auto playerMove = GetPlayerMoveData( player );
+	Phys_SimulateCharacter( playerMove->apCharacter, srUserCmd.aFrameTime );
+	apMove->UpdatePosition( player );
+
+	gFrameTime = tickFrameTime;
+}
+
+
+#if CH_CLIENT
+bool PlayerManager::SaveMoveState( Entity player, PlayerMoveState_t& srState )
+{
+	auto playerMove = GetPlayerMoveData( player );
+	auto transform  = GetTransform( player );
+	auto rigidBody  = GetRigidBody( player );
+
+	if ( !playerMove || !transform || !rigidBody )
+		return false;
+
+	srState.aPos              = transform->aPos;
+	srState.aAng              = transform->aAng;
+	srState.aVel              = rigidBody->aVel;
+
+	srState.aMoveType         = playerMove->aMoveType;
+	srState.aPlayerFlags      = playerMove->aPlayerFlags;
+	srState.aPrevPlayerFlags  = playerMove->aPrevPlayerFlags;
+	srState.aMaxSpeed         = playerMove->aMaxSpeed;
+
+	srState.aPrevViewHeight   = playerMove->aPrevViewHeight;
+	srState.aTargetViewHeight = playerMove->aTargetViewHeight;
+	srState.aOutViewHeight    = playerMove->aOutViewHeight;
+	srState.aDuckDuration     = playerMove->aDuckDuration;
+	srState.aDuckTime         = playerMove->aDuckTime;
+
+	return true;
+}
+
+
+void PlayerManager::RestoreMoveState( Entity player, const PlayerMoveState_t& srState )
+{
+	auto playerMove = GetPlayerMoveData( player );
+	auto transform  = GetTransform( player );
+	auto rigidBody  = GetRigidBody( player );
+
+	if ( !playerMove || !transform || !rigidBody )
+		return;
+
+	transform->aPos                = srState.aPos;
+	transform->aAng                = srState.aAng;
+	rigidBody->aVel                = srState.aVel;
+
+	playerMove->aMoveType          = srState.aMoveType;
+	playerMove->aPlayerFlags       = srState.aPlayerFlags;
+	playerMove->aPrevPlayerFlags   = srState.aPrevPlayerFlags;
+	playerMove->aMaxSpeed          = srState.aMaxSpeed;
+
+	playerMove->aPrevViewHeight    = srState.aPrevViewHeight;
+	playerMove->aTargetViewHeight  = srState.aTargetViewHeight;
+	playerMove->aOutViewHeight     = srState.aOutViewHeight;
+	playerMove->aDuckDuration      = srState.aDuckDuration;
+	playerMove->aDuckTime          = srState.aDuckTime;
+
+	if ( playerMove->apCharacter )
+	{
+		playerMove->apCharacter->SetPosition( srState.aPos );
+		playerMove->apCharacter->SetLinearVelocity( srState.aVel );
+	}
+}
+
+
+void PlayerManager::PredictUserCmd( Entity player, const UserCmd_t& srUserCmd, bool sReplay )
+{
+	PROF_SCOPE();
+
+	auto playerInfo = GetPlayerInfo( player );
+	auto playerMove = GetPlayerMoveData( player );
+	auto transform  = GetTransform( player );
+
+	if ( !playerInfo || !playerMove || !transform )
+		return;
+
+	auto camTransform = GetTransform( playerInfo->aCamera );
+
+	if ( !camTransform )
+		return;
+
+	// The server only makes a physics character for its own players, so make one here to predict with
+	if ( !playerMove->apCharacter )
+	{
+		playerMove->apCharacter = Player_CreateCharacter();
+		playerMove->apCharacter->SetPosition( transform->aPos );
+
+		apMove->aPredictedMoveType = EPlayerMoveType_Count;
+	}
+
+	apMove->SetPlayer( player );
+
+	// The server changes the move type through commands like noclip, so set up the character for it when it changes
+	if ( apMove->aPredictedMoveType != playerMove->aMoveType )
+	{
+		apMove->SetMoveType( *playerMove, playerMove->aMoveType );
+		apMove->aPredictedMoveType = playerMove->aMoveType;
+	}
+
+	UserCmd_t userCmd = srUserCmd;
+	ApplyUserCmdAngles( transform, camTransform, userCmd );
+
+	float frameTime    = gFrameTime;
+	gFrameTime         = userCmd.aFrameTime;
+	apMove->aReplaying = sReplay;
+
+	apMove->MovePlayer( player, &userCmd );
+
+	// Step the character over this command, like the server's physics update does after running commands
+	// Only the character, the rest of the world comes from the server and replays would step it again for every command
+	Phys_SimulateCharacter( playerMove->apCharacter, userCmd.aFrameTime );
+	apMove->UpdatePosition( player );
+
+	apMove->aReplaying = false;
+	gFrameTime         = frameTime;
+}
+#endif
+
+
 void PlayerManager::UpdateLocalPlayer()
 {
 	PROF_SCOPE();
@@ -758,7 +938,7 @@ void PlayerManager::UpdateLocalPlayer()
 
 		auto     playerMove = GetPlayerMoveData( player );
 		auto     transform  = GetTransform( player );
-		CLight*  flashlight = Ent_GetComponent< CLight >( player, "light" );
+		CLight*  flashlight = Ent_GetComponent< CLight >( player );
 
 		auto     camTransform = GetTransform( playerInfo->aCamera );
 		// auto     camera     = GetCamera( playerInfo->aCamera );
@@ -771,9 +951,7 @@ void PlayerManager::UpdateLocalPlayer()
 
 		apMove->SetPlayer( player );
 
-		// TODO: prediction
-		// apMove->MovePlayer( gLocalPlayer, &userCmd );
-	
+		// Movement for the local player is predicted in CL_PredictUserCmds
 		// Player_UpdateFlashlight( player, &userCmd );
 	
 		// TEMP
@@ -800,7 +978,7 @@ void PlayerManager::UpdateLocalPlayer()
 		// if ( ( cl_thirdperson && cl_playermodel_enable ) || !playerInfo->aIsLocalPlayer )
 		if ( cl_playermodel_enable && ( cl_thirdperson || !playerInfo->aIsLocalPlayer ) )
 		{
-			auto renderComp = Ent_GetComponent< CRenderable >( player, "renderable" );
+			auto renderComp = Ent_GetComponent< CRenderable >( player );
 
 			// I hate this so much
 			if ( renderComp->aRenderable == CH_INVALID_HANDLE )
@@ -878,7 +1056,7 @@ void PlayerManager::UpdateLocalPlayer()
 		else
 		{
 			// Make sure this thing is hidden
-			auto renderComp = Ent_GetComponent< CRenderable >( player, "renderable" );
+			auto renderComp = Ent_GetComponent< CRenderable >( player );
 			if ( renderComp->aRenderable == CH_INVALID_HANDLE )
 				continue;
 
@@ -1245,10 +1423,12 @@ void PlayerMovement::SetPlayer( Entity player )
 	apMove         = GetPlayerMoveData( player );
 	apRigidBody    = GetRigidBody( player );
 	apTransform    = GetTransform( player );
-	apDir          = Ent_GetComponent< CDirection >( player, "direction" );
+	apDir          = Ent_GetComponent< CDirection >( player );
 
-#if CH_SERVER
+	// Only the local player has a character on the client, for prediction
 	apCharacter = apMove->apCharacter;
+
+#if CH_SERVER
 	CH_ASSERT( apCharacter );
 #endif
 
@@ -1517,7 +1697,7 @@ void PlayerMovement::DisplayPlayerStats( Entity player ) const
 	CTransform* camTransform = GetTransform( playerInfo->aCamera );
 	CCamera*    camera       = GetCamera( playerInfo->aCamera );
 
-	auto        flashlight   = Ent_GetComponent< CLight >( player, "light" );
+	auto        flashlight   = Ent_GetComponent< CLight >( player );
 
 	float speed        = glm::length( glm::vec2( rigidBody->aVel.Get().x, rigidBody->aVel.Get().y ) );
 
@@ -1923,7 +2103,7 @@ void PlayerMovement::StopStepSound( bool force )
 
 void PlayerMovement::PlayStepSound()
 {
-	if ( !cl_step_sound )
+	if ( !cl_step_sound || aReplaying )
 		return;
 
 	//float vel = glm::length( glm::vec2(aVelocity.x, aVelocity.y) ); 
@@ -1968,7 +2148,7 @@ void PlayerMovement::StopImpactSound()
 
 void PlayerMovement::PlayImpactSound()
 {
-	if ( !cl_impact_sound )
+	if ( !cl_impact_sound || aReplaying )
 		return;
 
 	//float vel = glm::length( glm::vec2(aVelocity.x, aVelocity.y) ); 
@@ -2209,7 +2389,7 @@ void PlayerMovement::DoSmoothLand( bool wasOnGround )
 			apMove->aLandTime  = 0.f;
 
 			// This is shoddy and is only here to be funny
-			auto health        = Ent_GetComponent< CHealth >( aPlayer, "health" );
+			auto health        = Ent_GetComponent< CHealth >( aPlayer );
 			health->aHealth.Edit() -= ( landVel * 50 );
 		}
 
@@ -2443,6 +2623,13 @@ void PlayerMovement::Accelerate( float wishSpeed, glm::vec3 wishDir, bool inAir
 
 
 #if CH_SERVER
+bool PlayerSpawnManager::GetAccess( EntSysAccess_t& srAccess )
+{
+	// Only holds the spawn points, there's nothing to update
+	return true;
+}
+
+
 Transform PlayerSpawnManager::SelectSpawnTransform()
 {
 	if ( aEntities.empty() )
@@ -2459,7 +2646,7 @@ Transform PlayerSpawnManager::SelectSpawnTransform()
 	if ( aEntities.size() > 1 )
 		index = rand_u64( 0, aEntities.size() - 1 );
 	
-	auto transform = Ent_GetComponent< CTransform >( aEntities[ index ], "transform" );
+	auto transform = Ent_GetComponent< CTransform >( aEntities[ index ] );
 
 	if ( !transform )
 	{
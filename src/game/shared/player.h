@@ -114,6 +114,29 @@ struct CPlayerInfo
 };
 
 
+// Parts of a player that movement changes, saved after each command so client prediction can be checked and rolled back
+struct PlayerMoveState_t
+{
+	// Command this is the result of, 0 if unknown
+	u32             aCommandNumber    = 0;
+
+	glm::vec3       aPos{};
+	glm::vec3       aAng{};
+	glm::vec3       aVel{};
+
+	EPlayerMoveType aMoveType         = EPlayerMoveType_Walk;
+	PlayerFlags     aPlayerFlags      = PlyNone;
+	PlayerFlags     aPrevPlayerFlags  = PlyNone;
+	float           aMaxSpeed         = 0.f;
+
+	float           aPrevViewHeight   = 0.f;
+	float           aTargetViewHeight = 0.f;
+	float           aOutViewHeight    = 0.f;
+	float           aDuckDuration     = 0.f;
+	float           aDuckTime         = 0.f;
+};
+
+
 // idk if we need any info here really
 #if CH_SERVER
 struct CPlayerSpawn
@@ -221,6 +244,14 @@ class PlayerMovement // : public ComponentSystem
 
 	IPhysVirtualCharacter* apCharacter    = nullptr;
 
+#if CH_CLIENT
+	// Set while running commands again during prediction, so sounds only play the first time
+	bool                   aReplaying         = false;
+
+	// Move type the predicted character was last set up for
+	EPlayerMoveType        aPredictedMoveType = EPlayerMoveType_Count;
+#endif
+
 	// CPhysShape*      apPhysShape = nullptr;
 	// CPhysObject*     apPhysObj   = nullptr;
 
@@ -245,6 +276,7 @@ public:
 
 	void                    ComponentAdded( Entity sEntity, void* spData ) override;
 	void                    ComponentUpdated( Entity sEntity, void* spData ) override;
+	bool                    GetAccess( EntSysAccess_t& srAccess ) override;
 
 	// Set's current player to manage, and prepares all components for use
 	bool                    SetCurrentPlayer( Entity player );
@@ -256,6 +288,18 @@ public:
 	void                    Update( float frameTime );  // ??
 	void                    UpdateLocalPlayer();
 
+	// Apply the view angles from this command and run movement over its frame time
+	void                    RunUserCmd( Entity player, CPlayerInfo* playerInfo, UserCmd_t& srUserCmd );
+
+#if CH_CLIENT
+	// Client side prediction, returns false if the player is missing anything movement needs
+	bool                    SaveMoveState( Entity player, PlayerMoveState_t& srState );
+	void                    RestoreMoveState( Entity player, const PlayerMoveState_t& srState );
+
+	// Run movement for a command ahead of the server, and step the character physics over it
+	void                    PredictUserCmd( Entity player, const UserCmd_t& srUserCmd, bool sReplay );
+#endif
+
 	void                    UpdateView( CPlayerInfo* info, Entity player );
 	void                    DoMouseLook( Entity player );
 	
@@ -268,17 +312,18 @@ extern PlayerManager players;
 class PlayerSpawnManager : public IEntityComponentSystem
 {
   public:
+	bool      GetAccess( EntSysAccess_t& srAccess ) override;
 	Transform SelectSpawnTransform();
 };
 #endif
 
 
 // convinence
-inline auto GetPlayerMoveData( Entity ent ) { return Ent_GetComponent< CPlayerMoveData >( ent, "playerMoveData" ); }
-inline auto GetPlayerZoom( Entity ent )     { return Ent_GetComponent< CPlayerZoom >(  ent, "playerZoom" ); }
-inline auto GetPlayerInfo( Entity ent )     { return Ent_GetComponent< CPlayerInfo >( ent, "playerInfo" ); }
-inline auto GetTransform( Entity ent )      { return Ent_GetComponent< CTransform >( ent, "transform" ); }
-inline auto GetCamera( Entity ent )         { return Ent_GetComponent< CCamera >( ent, "camera" ); }
-inline auto GetRigidBody( Entity ent )      { return Ent_GetComponent< CRigidBody >( ent, "rigidBody" ); }
-inline auto GetComp_Direction( Entity ent ) { return Ent_GetComponent< CDirection >( ent, "direction" ); }
+inline auto GetPlayerMoveData( Entity ent ) { return Ent_GetComponent< CPlayerMoveData >( ent ); }
+inline auto GetPlayerZoom( Entity ent )     { return Ent_GetComponent< CPlayerZoom >(  ent ); }
+inline auto GetPlayerInfo( Entity ent )     { return Ent_GetComponent< CPlayerInfo >( ent ); }
+inline auto GetTransform( Entity ent )      { return Ent_GetComponent< CTransform >( ent ); }
+inline auto GetCamera( Entity ent )         { return Ent_GetComponent< CCamera >( ent ); }
+inline auto GetRigidBody( Entity ent )      { return Ent_GetComponent< CRigidBody >( ent ); }
+inline auto GetComp_Direction( Entity ent ) { return Ent_GetComponent< CDirection >( ent ); }
 
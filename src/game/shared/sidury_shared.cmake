@@ -32,6 +32,10 @@ set(
     ${SIDURY_SHARED_DIR}/entity/entity.h
     ${SIDURY_SHARED_DIR}/entity/entity_component_pool.cpp
     ${SIDURY_SHARED_DIR}/entity/entity_components_base.cpp
+    ${SIDURY_SHARED_DIR}/entity/entity_interp.cpp
+    ${SIDURY_SHARED_DIR}/entity/entity_interp.h
+    ${SIDURY_SHARED_DIR}/entity/entity_scheduler.cpp
+    ${SIDURY_SHARED_DIR}/entity/entity_scheduler.h
     ${SIDURY_SHARED_DIR}/entity/entity_serialization.cpp
     ${SIDURY_SHARED_DIR}/entity/entity_systems.cpp
     ${SIDURY_SHARED_DIR}/entity/entity_systems.h
@@ -39,6 +43,7 @@ set(
 	# networking
 	${SIDURY_SHARED_DIR}/network/net_main.cpp
 	${SIDURY_SHARED_DIR}/network/net_main.h
+	${SIDURY_SHARED_DIR}/network/net_bitbuffer.h
 
 	../../shared/map_system.cpp
 	../../shared/map_system.h
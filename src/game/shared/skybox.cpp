@@ -247,6 +247,14 @@ void SkyboxSystem::ComponentUpdated( Entity sEntity, void* spData )
 }
 
 
+bool SkyboxSystem::GetAccess( EntSysAccess_t& srAccess )
+{
+	// Update() doesn't touch anything right now
+	srAccess.aThreadSafe = true;
+	return true;
+}
+
+
 void SkyboxSystem::Update()
 {
 	// gViewport[ 0 ]
@@ -257,7 +265,7 @@ void SkyboxSystem::Update()
 static SkyboxSystem gEntSys_Skybox;
 
 
-CH_STRUCT_REGISTER_COMPONENT( CSkybox, skybox, EEntComponentNetType_Both, ECompRegFlag_None )
+CH_STRUCT_REGISTER_COMPONENT( CSkybox, skybox, EEntComponentNetType_Both, ECompRegFlag_AlwaysRelevant )
 {
 	CH_REGISTER_COMPONENT_VAR2( EEntNetField_StdString, std::string, aMaterialPath, materialPath, ECompRegFlag_None );
 	CH_REGISTER_COMPONENT_SYS2( SkyboxSystem, gEntSys_Skybox );
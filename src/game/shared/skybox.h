@@ -37,6 +37,8 @@ class SkyboxSystem : public IEntityComponentSystem
 	// Called when the component data has been updated (ONLY ON CLIENT RIGHT NOW)
 	virtual void ComponentUpdated( Entity sEntity, void* spData );
 
+	virtual bool GetAccess( EntSysAccess_t& srAccess );
+
 	virtual void Update();
 };
 
@@ -32,6 +32,9 @@ CH_STRUCT_REGISTER_COMPONENT( CSound, sound, EEntComponentNetType_Both, ECompReg
 	//CH_REGISTER_COMPONENT_VAR2( EEntNetField_Float, float, aVelocity, velocity, ECompRegFlag_None );
 	CH_REGISTER_COMPONENT_VAR2( EEntNetField_Bool, bool, aStartPlayback, startPlayback, ECompRegFlag_None );
 
+	// Sounds can be heard from further away than most things can be seen
+	CH_REGISTER_COMPONENT_NET_PRIORITY( 2.f );
+
 	CH_REGISTER_COMPONENT_SYS2( EntSys_Sound, gEntSys_SoundSystem );
 }
 
@@ -78,6 +81,15 @@ void EntSys_Sound::ComponentUpdated( Entity sEntity, void* spData )
 }
 
 
+bool EntSys_Sound::GetAccess( EntSysAccess_t& srAccess )
+{
+	// Talks to the audio system, so this stays on the main thread
+	srAccess.Read< CTransform >();
+	srAccess.aInterfaces = EEntSysInterface_Audio;
+	return true;
+}
+
+
 void EntSys_Sound::Update()
 {
 #if CH_CLIENT
@@ -90,12 +102,10 @@ void EntSys_Sound::Update()
 	// audio->SetDopplerScale( snd_doppler_scale );
 	// audio->SetSoundTravelSpeed( snd_travel_speed );
 
-	for ( Entity entity : aEntities )
+	for ( size_t i = 0; i < apPool->GetCount(); i++ )
 	{
-		auto sound = Ent_GetComponent< CSound >( entity, "sound" );
-
-		if ( !sound )
-			continue;
+		Entity entity = apPool->GetEntityByIndex( i );
+		auto   sound  = static_cast< CSound* >( apPool->GetDataByIndex( i ) );
 
 		if ( sound->aHandle == CH_INVALID_HANDLE )
 		{
@@ -39,6 +39,7 @@ class EntSys_Sound : public IEntityComponentSystem
 	void ComponentAdded( Entity sEntity, void* spData ) override;
 	void ComponentRemoved( Entity sEntity, void* spData ) override;
 	void ComponentUpdated( Entity sEntity, void* spData ) override;
+	bool GetAccess( EntSysAccess_t& srAccess ) override;
 	void Update() override;
 };
 
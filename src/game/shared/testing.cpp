@@ -126,7 +126,7 @@ class ProtogenSystem : public IEntityComponentSystem
 	{
 #if CH_CLIENT
 		// Add a renderable component
-		auto renderable = Ent_GetComponent< CRenderable >( sEntity, "renderable" );
+		auto renderable = Ent_GetComponent< CRenderable >( sEntity );
 
 		if ( !renderable )
 			return;
@@ -190,20 +190,20 @@ void CreateProtogen_f( const std::string& path )
 
 	Entity proto = Entity_CreateEntity();
 
-	Ent_AddComponent( proto, "protogen" );
+	Ent_AddComponent< CProtogen >( proto );
 
 	// ch_handle_t       model          = graphics->LoadModel( path );
 
-	CRenderable* renderable     = Ent_AddComponent< CRenderable >( proto, "renderable" );
+	CRenderable* renderable     = Ent_AddComponent< CRenderable >( proto );
 	renderable->aPath           = path;
 	// renderable->aModel          = model;
 
 	// CRenderable_t* renderComp  = Ent_AddComponent< CRenderable_t >( proto, "renderable" );
 	// renderComp->aHandle        = graphics->CreateRenderable( model );
 
-	CTransform* transform       = Ent_AddComponent< CTransform >( proto, "transform" );
+	CTransform* transform       = Ent_AddComponent< CTransform >( proto );
 
-	auto        playerTransform = Ent_GetComponent< CTransform >( player, "transform" );
+	auto        playerTransform = Ent_GetComponent< CTransform >( player );
 
 	transform->aPos            = playerTransform->aPos;
 	transform->aScale.Set( { vrcmdl_scale, vrcmdl_scale, vrcmdl_scale } );
@@ -539,7 +539,7 @@ void TEST_CL_UpdateProtos( float frameTime )
 		// if ( !transformDirty )
 		// 	continue;
 
-		auto renderComp = Ent_GetComponent< CRenderable >( proto, "renderable" );
+		auto renderComp = Ent_GetComponent< CRenderable >( proto );
 
 		CH_ASSERT( renderComp );
 
@@ -651,7 +651,7 @@ void TEST_SV_UpdateProtos( float frameTime )
 			targetChanged            = true;
 		}
 
-		auto playerTransform = Ent_GetComponent< CTransform >( protoLook.aLookTarget, "transform" );
+		auto playerTransform = Ent_GetComponent< CTransform >( protoLook.aLookTarget );
 
 		// CH_ASSERT( playerTransform );
 
@@ -662,7 +662,7 @@ void TEST_SV_UpdateProtos( float frameTime )
 			continue;
 		}
 
-		auto protoTransform = Ent_GetComponent< CTransform >( proto, "transform" );
+		auto protoTransform = Ent_GetComponent< CTransform >( proto );
 
 		// glm::length( renderable->aModelMatrix ) == 0.f
 
@@ -789,14 +789,14 @@ static void cmd_sound_test( const std::string& srPath, bool sServer )
 #endif
 
 #if CH_CLIENT
-	auto playerTransform = Ent_GetComponent< CTransform >( gLocalPlayer, "transform" );
+	auto playerTransform = Ent_GetComponent< CTransform >( gLocalPlayer );
 #else
 	Entity player = SV_GetCommandClientEntity();
 
 	if ( player == CH_ENT_INVALID )
 		return;
 
-	auto playerTransform = Ent_GetComponent< CTransform >( player, "transform" );
+	auto playerTransform = Ent_GetComponent< CTransform >( player );
 #endif
 
 	if ( !playerTransform )
@@ -815,8 +815,8 @@ static void cmd_sound_test( const std::string& srPath, bool sServer )
 	else
 		gAudioTestEntitiesCl.push_back( soundEnt );
 
-	auto transform           = Ent_AddComponent< CTransform >( soundEnt, "transform" );
-	auto sound               = Ent_AddComponent< CSound >( soundEnt, "sound" );
+	auto transform           = Ent_AddComponent< CTransform >( soundEnt );
+	auto sound               = Ent_AddComponent< CSound >( soundEnt );
 
 	transform->aPos          = playerTransform->aPos;
 	transform->aAng          = playerTransform->aAng;
@@ -858,7 +858,7 @@ CONCMD( snd_test_cl_clear )
 
 	for ( Entity entity : gAudioTestEntitiesCl )
 	{
-		CSound* sound = Ent_GetComponent< CSound >( entity, "sound" );
+		CSound* sound = Ent_GetComponent< CSound >( entity );
 
 		if ( sound )
 		{
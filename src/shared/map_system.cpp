@@ -1,10 +1,176 @@
 #include "map_system.h"
 #include "core/json5.h"
 
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+#ifdef _WIN32
+  #define WIN32_LEAN_AND_MEAN
+  #define NOMINMAX
+  #include <Windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
 
 using namespace chmap;
 
 
+// Entities parsed in one job when loading a scene across threads
+constexpr size_t CH_MAP_ENTITY_CHUNK = 256;
+
+// Size of each block in a scene arena, larger allocations get a block of their own
+constexpr size_t CH_MAP_ARENA_BLOCK  = 64 * 1024;
+
+
+// Set on threads running ParallelFor jobs, so nested calls don't start more threads
+static thread_local bool gMapWorkerThread = false;
+
+
+// A compiled scene mapped into memory
+struct chmap::SceneFile
+{
+	const char* data    = nullptr;
+	size_t      size    = 0;
+
+#ifdef _WIN32
+	HANDLE      file    = INVALID_HANDLE_VALUE;
+	HANDLE      mapping = nullptr;
+#endif
+};
+
+
+// Bump allocator owning the component values and strings of a scene
+struct chmap::SceneArena
+{
+	std::vector< char* >                              blocks;
+	char*                                             cur  = nullptr;
+	size_t                                            left = 0;
+
+	// [String] = Interned copy in the arena
+	std::unordered_map< std::string_view, ch_string > interned;
+
+	SceneArena()                    = default;
+	SceneArena( const SceneArena& ) = delete;
+
+	~SceneArena()
+	{
+		for ( char* block : blocks )
+			free( block );
+	}
+
+	void* Alloc( size_t size )
+	{
+		size = ( size + 7 ) & ~(size_t)7;
+
+		if ( size > left )
+		{
+			size_t blockSize = std::max( size, CH_MAP_ARENA_BLOCK );
+			cur              = static_cast< char* >( malloc( blockSize ) );
+			left             = blockSize;
+			blocks.push_back( cur );
+		}
+
+		void* out = cur;
+		cur += size;
+		left -= size;
+		return out;
+	}
+
+	template< typename T >
+	T* AllocArray( size_t count )
+	{
+		if ( count == 0 )
+			return nullptr;
+
+		T* out = static_cast< T* >( Alloc( count * sizeof( T ) ) );
+
+		for ( size_t i = 0; i < count; i++ )
+			new ( &out[ i ] ) T;
+
+		return out;
+	}
+
+	ch_string CopyString( const char* string, size_t size )
+	{
+		char* out = static_cast< char* >( Alloc( size + 1 ) );
+		memcpy( out, string, size );
+		out[ size ] = '\0';
+		return { out, size };
+	}
+
+	// Only copies the string the first time it's seen
+	ch_string Intern( const char* string, size_t size )
+	{
+		auto it = interned.find( std::string_view( string, size ) );
+
+		if ( it != interned.end() )
+			return it->second;
+
+		ch_string copy = CopyString( string, size );
+		interned[ std::string_view( copy.data, copy.size ) ] = copy;
+		return copy;
+	}
+
+	// Take the blocks of an arena filled on another thread
+	void Merge( SceneArena& other )
+	{
+		blocks.insert( blocks.end(), other.blocks.begin(), other.blocks.end() );
+
+		other.blocks.clear();
+		other.interned.clear();
+		other.cur  = nullptr;
+		other.left = 0;
+	}
+};
+
+
+// Run func( i ) for every i in [0, count) across worker threads and wait for them to finish
+// Results should be written to slot i, so they come out in the same order no matter which thread ran them
+template< typename FUNC >
+static void ParallelFor( size_t count, FUNC func )
+{
+	size_t threadCount = std::min< size_t >( std::thread::hardware_concurrency(), count );
+
+	if ( threadCount <= 1 || gMapWorkerThread )
+	{
+		for ( size_t i = 0; i < count; i++ )
+			func( i );
+
+		return;
+	}
+
+	std::atomic< size_t > next = 0;
+
+	auto                  worker = [ & ]()
+	{
+		gMapWorkerThread = true;
+
+		for ( size_t i = next.fetch_add( 1 ); i < count; i = next.fetch_add( 1 ) )
+			func( i );
+
+		gMapWorkerThread = false;
+	};
+
+	std::vector< std::thread > threads;
+	threads.reserve( threadCount - 1 );
+
+	for ( size_t i = 1; i < threadCount; i++ )
+		threads.emplace_back( worker );
+
+	// This thread helps out too
+	worker();
+
+	for ( std::thread& thread : threads )
+		thread.join();
+}
+
+
 // returns true if the match failed
 static bool CheckJsonType( JsonObject_t& object, EJsonType type )
 {
@@ -61,7 +227,7 @@ static VECTOR JsonToVector( JsonObject_t& object )
 }
 
 
-static void LoadComponent( Scene& scene, Entity& entity, JsonObject_t& cur )
+static void LoadComponent( SceneArena& arena, Entity& entity, JsonObject_t& cur )
 {
 	if ( CheckJsonType( cur, EJsonType_Object ) )
 	{
@@ -77,35 +243,31 @@ static void LoadComponent( Scene& scene, Entity& entity, JsonObject_t& cur )
 	}
 
 	// Check if this component already exists
-	for ( Component& component : entity.components )
+	for ( u32 compI = 0; compI < entity.componentCount; compI++ )
 	{
-		if ( ch_str_equals( component.name, cur.name.data ) )
+		if ( ch_str_equals( entity.components[ compI ].name, cur.name.data ) )
 		{
 			Log_ErrorF( "Entity already has a \"%s\" component\n", cur.name.data );
 			return;
 		}
 	}
 
-	Component& comp = entity.components.emplace_back();
-	comp.name       = ch_str_copy( cur.name.data, cur.name.size );
+	Component& comp = entity.components[ entity.componentCount++ ];
+	comp.name       = arena.Intern( cur.name.data, cur.name.size );
+	comp.values     = arena.AllocArray< ComponentValue >( cur.aObjects.aCount );
 
 	for ( u64 objI = 0; objI < cur.aObjects.aCount; objI++ )
 	{
 		JsonObject_t& object = cur.aObjects.apData[ objI ];
 
-		// ComponentValue& value = comp.values.emplace_back();
-		// CopyString( value.name, object.name.data, strlen( object.name.data ) );
-
-		// TODO: why is this a hash map? just make it a simple struct array
-		// I think the only reason was for easy matching to see if a component already exists
-		auto it = comp.values.find( object.name.data );
-		if ( it != comp.values.end() )
+		if ( comp.Find( object.name.data, object.name.size ) )
 		{
 			Log_ErrorF( "Entity already has a \"%s\" component value!\n", object.name.data );
 			continue;
 		}
 
-		ComponentValue& value = comp.values[ object.name.data ];
+		ComponentValue& value = comp.values[ comp.valueCount++ ];
+		value.name            = arena.Intern( object.name.data, object.name.size );
 
 		switch ( object.aType )
 		{
@@ -125,7 +287,7 @@ static void LoadComponent( Scene& scene, Entity& entity, JsonObject_t& cur )
 
 			case EJsonType_String:
 				value.type    = EComponentType_String;
-				value.aString = ch_str_copy( object.aString.data, object.aString.size );
+				value.aString = arena.CopyString( object.aString.data, object.aString.size );
 				break;
 
 			case EJsonType_Array:
@@ -154,16 +316,15 @@ static void LoadComponent( Scene& scene, Entity& entity, JsonObject_t& cur )
 }
 
 
-static void LoadEntity( Scene& scene, JsonObject_t& object )
+// Returns false if this isn't a valid entity
+static bool LoadEntity( SceneArena& arena, Entity& entity, JsonObject_t& object )
 {
 	if ( CheckJsonType( object, EJsonType_Object ) )
 	{
 		Log_Error( "Entity is not a Json Object type\n" );
-		return;
+		return false;
 	}
 
-	Entity& entity = scene.entites.emplace_back();
-
 	for ( u64 objI = 0; objI < object.aObjects.aCount; objI++ )
 	{
 		JsonObject_t& cur = object.aObjects.apData[ objI ];
@@ -187,7 +348,7 @@ static void LoadEntity( Scene& scene, JsonObject_t& object )
 			if ( CheckJsonType( cur, EJsonType_String ) )
 				continue;
 
-			entity.name = ch_str_copy( cur.aString.data, cur.aString.size );
+			entity.name = arena.CopyString( cur.aString.data, cur.aString.size );
 		}
 		else if ( ch_str_equals( cur.name, "pos", 3 ) )
 		{
@@ -215,41 +376,541 @@ static void LoadEntity( Scene& scene, JsonObject_t& object )
 			if ( CheckJsonType( cur, EJsonType_Object ) )
 				continue;
 
+			if ( entity.components )
+			{
+				Log_Error( "Entity has more than one components list\n" );
+				continue;
+			}
+
+			// Room for every component, duplicates are skipped so some of it may go unused
+			entity.components = arena.AllocArray< Component >( cur.aObjects.aCount );
+
 			for ( u64 compI = 0; compI < cur.aObjects.aCount; compI++ )
 			{
-				LoadComponent( scene, entity, cur.aObjects.apData[ compI ] );
+				LoadComponent( arena, entity, cur.aObjects.apData[ compI ] );
 			}
 		}
 	}
+
+	return true;
 }
 
 
-static void FreeScene( Scene& scene )
+// ------------------------------------------------------------------------------------------------------
+// Compiled Scenes
+
+
+static SceneFile* MapSceneFile( const char* path )
 {
-	for ( Entity& entity : scene.entites )
+#ifdef _WIN32
+	HANDLE file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+
+	if ( file == INVALID_HANDLE_VALUE )
+		return nullptr;
+
+	LARGE_INTEGER fileSize;
+	if ( !GetFileSizeEx( file, &fileSize ) || fileSize.QuadPart <= 0 )
 	{
-		if ( entity.name.data )
-			ch_str_free( entity.name.data );
+		CloseHandle( file );
+		return nullptr;
+	}
+
+	HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	void*  data    = mapping ? MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) : nullptr;
 
-		for ( Component& component : entity.components )
+	if ( !data )
+	{
+		if ( mapping )
+			CloseHandle( mapping );
+
+		CloseHandle( file );
+		return nullptr;
+	}
+
+	SceneFile* sceneFile = new SceneFile;
+	sceneFile->data      = static_cast< const char* >( data );
+	sceneFile->size      = fileSize.QuadPart;
+	sceneFile->file      = file;
+	sceneFile->mapping   = mapping;
+	return sceneFile;
+#else
+	int fd = open( path, O_RDONLY );
+
+	if ( fd == -1 )
+		return nullptr;
+
+	struct stat info;
+	if ( fstat( fd, &info ) != 0 || info.st_size <= 0 )
+	{
+		close( fd );
+		return nullptr;
+	}
+
+	// The mapping stays valid after the file is closed
+	void* data = mmap( nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+
+	if ( data == MAP_FAILED )
+		return nullptr;
+
+	SceneFile* sceneFile = new SceneFile;
+	sceneFile->data      = static_cast< const char* >( data );
+	sceneFile->size      = info.st_size;
+	return sceneFile;
+#endif
+}
+
+
+static void UnmapSceneFile( SceneFile* file )
+{
+#ifdef _WIN32
+	UnmapViewOfFile( file->data );
+	CloseHandle( file->mapping );
+	CloseHandle( file->file );
+#else
+	munmap( const_cast< char* >( file->data ), file->size );
+#endif
+
+	delete file;
+}
+
+
+// Size and write time of a json5 scene, stored in the compiled scene to tell if it's out of date
+static bool GetSceneSourceStamp( const char* path, u64& size, s64& time )
+{
+	std::error_code err;
+
+	size = fs::file_size( path, err );
+	if ( err )
+		return false;
+
+	time = fs::last_write_time( path, err ).time_since_epoch().count();
+	return !err;
+}
+
+
+static size_t AlignCompiledOffset( size_t offset )
+{
+	return ( offset + 7 ) & ~(size_t)7;
+}
+
+
+// Make sure every table in the file is in bounds, returns nullptr if it's not a valid compiled scene
+static const CompiledSceneHeader* GetCompiledSceneHeader( const SceneFile* file )
+{
+	if ( file->size < sizeof( CompiledSceneHeader ) )
+		return nullptr;
+
+	auto header = reinterpret_cast< const CompiledSceneHeader* >( file->data );
+
+	if ( header->magic != CH_MAP_COMPILED_MAGIC || header->version != CH_MAP_COMPILED_VERSION )
+		return nullptr;
+
+	auto tableFits = [ & ]( u32 offset, u64 count, u64 itemSize )
+	{
+		return offset % 8 == 0 && offset + count * itemSize <= file->size;
+	};
+
+	if ( !tableFits( header->entityOffset, header->entityCount, sizeof( CompiledEntity ) ) ||
+	     !tableFits( header->componentOffset, header->componentCount, sizeof( CompiledComponent ) ) ||
+	     !tableFits( header->valueOffset, header->valueCount, sizeof( CompiledValue ) ) ||
+	     !tableFits( header->stringPoolOffset, header->stringPoolSize, 1 ) )
+	{
+		return nullptr;
+	}
+
+	return header;
+}
+
+
+// Tables of a mapped compiled scene
+struct CompiledSceneView
+{
+	const CompiledSceneHeader* header;
+	const CompiledEntity*      entities;
+	const CompiledComponent*   components;
+	const CompiledValue*       values;
+	char*                      pool;
+
+	// Returns false if the string isn't in the string pool
+	bool GetString( const CompiledString& string, ch_string& out ) const
+	{
+		if ( (u64)string.offset + string.size >= header->stringPoolSize || pool[ string.offset + string.size ] != '\0' )
+			return false;
+
+		out.data = pool + string.offset;
+		out.size = string.size;
+		return true;
+	}
+};
+
+
+// Returns false if the entity points outside of the tables
+static bool ReadCompiledEntity( Entity& entity, const CompiledEntity& compiledEnt, const CompiledSceneView& view, Component* components, ComponentValue* values )
+{
+	entity.id     = compiledEnt.id;
+	entity.parent = compiledEnt.parent;
+	entity.pos    = compiledEnt.pos;
+	entity.ang    = compiledEnt.ang;
+	entity.scale  = compiledEnt.scale;
+
+	if ( !view.GetString( compiledEnt.name, entity.name ) )
+		return false;
+
+	// No name
+	if ( entity.name.size == 0 )
+		entity.name = {};
+
+	if ( (u64)compiledEnt.firstComponent + compiledEnt.componentCount > view.header->componentCount )
+		return false;
+
+	entity.components     = components + compiledEnt.firstComponent;
+	entity.componentCount = compiledEnt.componentCount;
+
+	for ( u32 compI = 0; compI < compiledEnt.componentCount; compI++ )
+	{
+		const CompiledComponent& compiledComp = view.components[ compiledEnt.firstComponent + compI ];
+		Component&               comp         = entity.components[ compI ];
+
+		if ( !view.GetString( compiledComp.name, comp.name ) )
+			return false;
+
+		if ( (u64)compiledComp.firstValue + compiledComp.valueCount > view.header->valueCount )
+			return false;
+
+		comp.values     = values + compiledComp.firstValue;
+		comp.valueCount = compiledComp.valueCount;
+
+		for ( u32 valueI = 0; valueI < compiledComp.valueCount; valueI++ )
 		{
-			if ( component.name.data )
-				ch_str_free( component.name.data );
+			const CompiledValue& compiledValue = view.values[ compiledComp.firstValue + valueI ];
+			ComponentValue&      value         = comp.values[ valueI ];
+
+			// Names are already interned by the string pool
+			if ( !view.GetString( compiledValue.name, value.name ) )
+				return false;
+
+			value.type = static_cast< EComponentType >( compiledValue.type );
 
-			for ( auto& [key, value] : component.values )
+			switch ( value.type )
 			{
-				if ( value.aString.data )
-					ch_str_free( value.aString.data );
+				default:
+					value.type = EComponentType_Invalid;
+					break;
+
+				case EComponentType_String:
+					if ( !view.GetString( compiledValue.aString, value.aString ) )
+						return false;
+
+					break;
+
+				case EComponentType_Int:
+					value.aInteger = compiledValue.aInteger;
+					break;
+
+				case EComponentType_Double:
+					value.aDouble = compiledValue.aDouble;
+					break;
+
+				case EComponentType_Vec2:
+					value.aVec2 = glm::vec2( compiledValue.aVec[ 0 ], compiledValue.aVec[ 1 ] );
+					break;
+
+				case EComponentType_Vec3:
+					value.aVec3 = glm::vec3( compiledValue.aVec[ 0 ], compiledValue.aVec[ 1 ], compiledValue.aVec[ 2 ] );
+					break;
+
+				case EComponentType_Vec4:
+					value.aVec4 = glm::vec4( compiledValue.aVec[ 0 ], compiledValue.aVec[ 1 ], compiledValue.aVec[ 2 ], compiledValue.aVec[ 3 ] );
+					break;
 			}
 		}
 	}
 
-	if ( scene.name.data )
-		ch_str_free( scene.name.data );
+	return true;
 }
 
 
-static bool LoadScene( Map* map, const char* scenePath, s64 scenePathLen = -1 )
+// Read a compiled scene in place, strings in the scene point into the mapped file
+// If sourceSize or sourceTime are set, the scene has to have been compiled from a json5 file with that size and write time
+static bool ReadCompiledScene( Scene& scene, const char* path, u64 sourceSize, s64 sourceTime )
+{
+	SceneFile* file = MapSceneFile( path );
+
+	if ( !file )
+		return false;
+
+	const CompiledSceneHeader* header = GetCompiledSceneHeader( file );
+
+	if ( !header )
+	{
+		Log_WarnF( "Invalid compiled scene, rebuilding it: \"%s\"\n", path );
+		UnmapSceneFile( file );
+		return false;
+	}
+
+	// Out of date
+	if ( ( sourceSize || sourceTime ) && ( header->sourceSize != sourceSize || header->sourceTime != sourceTime ) )
+	{
+		UnmapSceneFile( file );
+		return false;
+	}
+
+	if ( header->sceneFormatVersion < CH_MAP_SCENE_VERSION )
+	{
+		Log_ErrorF( "Scene version mismatch, expected version %d, got version %d\n", CH_MAP_SCENE_VERSION, header->sceneFormatVersion );
+		UnmapSceneFile( file );
+		return false;
+	}
+
+	CompiledSceneView view;
+	view.header              = header;
+	view.entities            = reinterpret_cast< const CompiledEntity* >( file->data + header->entityOffset );
+	view.components          = reinterpret_cast< const CompiledComponent* >( file->data + header->componentOffset );
+	view.values              = reinterpret_cast< const CompiledValue* >( file->data + header->valueOffset );
+	view.pool                = const_cast< char* >( file->data + header->stringPoolOffset );
+
+	scene.sceneFormatVersion = header->sceneFormatVersion;
+	scene.dateCreated        = header->dateCreated;
+	scene.dateModified       = header->dateModified;
+	scene.changeNumber       = header->changeNumber;
+	scene.file               = file;
+	scene.arena              = new SceneArena;
+
+	// Every component and value in the scene goes in one allocation each, laid out the same as their tables
+	Component*      components = scene.arena->AllocArray< Component >( header->componentCount );
+	ComponentValue* values     = scene.arena->AllocArray< ComponentValue >( header->valueCount );
+
+	scene.entites.resize( header->entityCount );
+
+	std::atomic< bool > valid = true;
+
+	// Every entity only reads its own part of the tables, so they're read in chunks across threads
+	ParallelFor( ( header->entityCount + CH_MAP_ENTITY_CHUNK - 1 ) / CH_MAP_ENTITY_CHUNK, [ & ]( size_t chunk )
+	{
+		size_t end = std::min< size_t >( ( chunk + 1 ) * CH_MAP_ENTITY_CHUNK, header->entityCount );
+
+		for ( size_t entI = chunk * CH_MAP_ENTITY_CHUNK; entI < end && valid; entI++ )
+		{
+			if ( !ReadCompiledEntity( scene.entites[ entI ], view.entities[ entI ], view, components, values ) )
+				valid = false;
+		}
+	} );
+
+	if ( !valid )
+	{
+		Log_WarnF( "Invalid compiled scene, rebuilding it: \"%s\"\n", path );
+		scene.entites.clear();
+		scene.file = nullptr;
+		UnmapSceneFile( file );
+
+		delete scene.arena;
+		scene.arena = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+
+// Strings written to a compiled scene, each unique string is only stored once
+struct CompiledStringPool
+{
+	std::vector< char >                    data;
+	std::unordered_map< std::string, u32 > offsets;
+
+	CompiledString Add( const char* string, size_t size )
+	{
+		if ( !string )
+			size = 0;
+
+		auto [ it, added ] = offsets.try_emplace( std::string( string ? string : "", size ), (u32)data.size() );
+
+		if ( added )
+		{
+			data.insert( data.end(), it->first.begin(), it->first.end() );
+			data.push_back( '\0' );
+		}
+
+		return { it->second, (u32)size };
+	}
+};
+
+
+// The temporary file for a compiled scene, unique to this process and thread
+static std::string GetCompileTempPath( const char* path )
+{
+#ifdef _WIN32
+	unsigned long processID = GetCurrentProcessId();
+#else
+	unsigned long processID = getpid();
+#endif
+
+	size_t threadID = std::hash< std::thread::id >{}( std::this_thread::get_id() );
+
+	char   suffix[ 64 ];
+	snprintf( suffix, sizeof( suffix ), ".%lu.%zx.tmp", processID, threadID );
+
+	return std::string( path ) + suffix;
+}
+
+
+bool chmap::CompileScene( const Scene& scene, const char* path, u64 sourceSize, s64 sourceTime )
+{
+	std::vector< CompiledEntity >    entities;
+	std::vector< CompiledComponent > components;
+	std::vector< CompiledValue >     values;
+	CompiledStringPool               pool;
+
+	entities.reserve( scene.entites.size() );
+
+	for ( const Entity& entity : scene.entites )
+	{
+		CompiledEntity& compiledEnt = entities.emplace_back();
+		compiledEnt.id              = entity.id;
+		compiledEnt.parent          = entity.parent;
+		compiledEnt.name            = pool.Add( entity.name.data, entity.name.size );
+		compiledEnt.pos             = entity.pos;
+		compiledEnt.ang             = entity.ang;
+		compiledEnt.scale           = entity.scale;
+		compiledEnt.firstComponent  = components.size();
+		compiledEnt.componentCount  = entity.componentCount;
+
+		for ( u32 compI = 0; compI < entity.componentCount; compI++ )
+		{
+			const Component&   comp         = entity.components[ compI ];
+			CompiledComponent& compiledComp = components.emplace_back();
+			compiledComp.name               = pool.Add( comp.name.data, comp.name.size );
+			compiledComp.firstValue         = values.size();
+			compiledComp.valueCount         = comp.valueCount;
+
+			for ( const ComponentValue& value : comp )
+			{
+				CompiledValue& compiledValue = values.emplace_back();
+				memset( &compiledValue, 0, sizeof( CompiledValue ) );
+
+				compiledValue.name = pool.Add( value.name.data, value.name.size );
+				compiledValue.type = value.type;
+
+				switch ( value.type )
+				{
+					default:
+						compiledValue.type = EComponentType_Invalid;
+						break;
+
+					case EComponentType_String:
+						compiledValue.aString = pool.Add( value.aString.data, value.aString.size );
+						break;
+
+					case EComponentType_Int:
+						compiledValue.aInteger = value.aInteger;
+						break;
+
+					case EComponentType_Double:
+						compiledValue.aDouble = value.aDouble;
+						break;
+
+					case EComponentType_Vec2:
+						memcpy( compiledValue.aVec, &value.aVec2, sizeof( glm::vec2 ) );
+						break;
+
+					case EComponentType_Vec3:
+						memcpy( compiledValue.aVec, &value.aVec3, sizeof( glm::vec3 ) );
+						break;
+
+					case EComponentType_Vec4:
+						memcpy( compiledValue.aVec, &value.aVec4, sizeof( glm::vec4 ) );
+						break;
+				}
+			}
+		}
+	}
+
+	CompiledSceneHeader header{};
+	header.magic              = CH_MAP_COMPILED_MAGIC;
+	header.version            = CH_MAP_COMPILED_VERSION;
+	header.sceneFormatVersion = scene.sceneFormatVersion;
+	header.changeNumber       = scene.changeNumber;
+	header.dateCreated        = scene.dateCreated;
+	header.dateModified       = scene.dateModified;
+	header.sourceSize         = sourceSize;
+	header.sourceTime         = sourceTime;
+	header.entityCount        = entities.size();
+	header.componentCount     = components.size();
+	header.valueCount         = values.size();
+	header.stringPoolSize     = pool.data.size();
+
+	size_t size               = sizeof( CompiledSceneHeader );
+	size_t entityOffset       = size = AlignCompiledOffset( size );
+	size_t componentOffset    = size = AlignCompiledOffset( size + entities.size() * sizeof( CompiledEntity ) );
+	size_t valueOffset        = size = AlignCompiledOffset( size + components.size() * sizeof( CompiledComponent ) );
+	size_t stringPoolOffset   = size = AlignCompiledOffset( size + values.size() * sizeof( CompiledValue ) );
+	size += pool.data.size();
+
+	if ( size > UINT32_MAX )
+	{
+		Log_ErrorF( "Scene is too large to compile: \"%s\"\n", path );
+		return false;
+	}
+
+	header.entityOffset     = entityOffset;
+	header.componentOffset  = componentOffset;
+	header.valueOffset      = valueOffset;
+	header.stringPoolOffset = stringPoolOffset;
+
+	std::vector< char > out( size, 0 );
+	memcpy( out.data(), &header, sizeof( header ) );
+	memcpy( out.data() + entityOffset, entities.data(), entities.size() * sizeof( CompiledEntity ) );
+	memcpy( out.data() + componentOffset, components.data(), components.size() * sizeof( CompiledComponent ) );
+	memcpy( out.data() + valueOffset, values.data(), values.size() * sizeof( CompiledValue ) );
+	memcpy( out.data() + stringPoolOffset, pool.data.data(), pool.data.size() );
+
+	// Write to a temporary file first, so nothing ever maps a half written scene
+	// Other processes or threads can compile the same scene at once, so each one gets its own file
+	std::string tempPath = GetCompileTempPath( path );
+	FILE*       file     = fopen( tempPath.c_str(), "wb" );
+
+	if ( !file )
+		return false;
+
+	bool wrote = fwrite( out.data(), 1, out.size(), file ) == out.size();
+	wrote &= fclose( file ) == 0;
+
+	std::error_code err;
+
+	if ( wrote )
+		fs::rename( tempPath, path, err );
+
+	if ( !wrote || err )
+	{
+		fs::remove( tempPath, err );
+		return false;
+	}
+
+	return true;
+}
+
+
+// ------------------------------------------------------------------------------------------------------
+
+
+static void FreeScene( Scene& scene )
+{
+	if ( scene.file )
+	{
+		UnmapSceneFile( scene.file );
+		scene.file = nullptr;
+	}
+
+	// Every string and value in the scene is in the arena or the compiled scene
+	delete scene.arena;
+	scene.arena = nullptr;
+	scene.name  = {};
+}
+
+
+// Parse a json5 scene, everything in it is copied into the scene arena
+static bool LoadSceneJson( Scene& scene, const char* scenePath, s64 scenePathLen = -1 )
 {
 	ch_string_auto data = FileSys_ReadFile( scenePath, scenePathLen );
 
@@ -265,10 +926,7 @@ static bool LoadScene( Map* map, const char* scenePath, s64 scenePathLen = -1 )
 		return false;
 	}
 
-	ch_string_auto sceneName = FileSys_GetFileNameNoExt( scenePath, scenePathLen );
-
-	Scene       scene;
-	scene.name = ch_str_copy( sceneName.data, sceneName.size );
+	scene.arena = new SceneArena;
 
 	for ( size_t i = 0; i < root.aObjects.aCount; i++ )
 	{
@@ -279,7 +937,6 @@ static bool LoadScene( Map* map, const char* scenePath, s64 scenePathLen = -1 )
 			if ( CheckJsonType( cur, EJsonType_Int ) )
 			{
 				Json_Free( &root );
-				FreeScene( scene );
 				return false;
 			}
 
@@ -289,7 +946,6 @@ static bool LoadScene( Map* map, const char* scenePath, s64 scenePathLen = -1 )
 			{
 				Log_ErrorF( "Scene version mismatch, expected version %d, got version %d\n", CH_MAP_SCENE_VERSION, scene.sceneFormatVersion );
 				Json_Free( &root );
-				FreeScene( scene );
 				return false;
 			}
 		}
@@ -319,18 +975,109 @@ static bool LoadScene( Map* map, const char* scenePath, s64 scenePathLen = -1 )
 			if ( CheckJsonType( cur, EJsonType_Array ) )
 				continue;
 
-			for ( u64 objI = 0; objI < cur.aObjects.aCount; objI++ )
+			// Entities are parsed in chunks across threads, then invalid ones are removed so the order stays the same
+			// Each chunk fills its own arena, which is merged into the scene arena afterwards
+			size_t                    firstEnt   = scene.entites.size();
+			size_t                    entCount   = cur.aObjects.aCount;
+			size_t                    chunkCount = ( entCount + CH_MAP_ENTITY_CHUNK - 1 ) / CH_MAP_ENTITY_CHUNK;
+			std::vector< char >       entValid( entCount, 0 );
+			std::vector< SceneArena > chunkArenas( chunkCount );
+
+			scene.entites.resize( firstEnt + entCount );
+
+			ParallelFor( chunkCount, [ & ]( size_t chunk )
+			{
+				size_t end = std::min( ( chunk + 1 ) * CH_MAP_ENTITY_CHUNK, entCount );
+
+				for ( size_t objI = chunk * CH_MAP_ENTITY_CHUNK; objI < end; objI++ )
+					entValid[ objI ] = LoadEntity( chunkArenas[ chunk ], scene.entites[ firstEnt + objI ], cur.aObjects.apData[ objI ] );
+			} );
+
+			for ( SceneArena& chunkArena : chunkArenas )
+				scene.arena->Merge( chunkArena );
+
+			size_t validCount = firstEnt;
+
+			for ( size_t objI = 0; objI < entCount; objI++ )
 			{
-				LoadEntity( scene, cur.aObjects.apData[ objI ] );
+				if ( !entValid[ objI ] )
+					continue;
+
+				if ( validCount != firstEnt + objI )
+					scene.entites[ validCount ] = std::move( scene.entites[ firstEnt + objI ] );
+
+				validCount++;
 			}
+
+			scene.entites.resize( validCount );
+		}
+	}
+
+	Json_Free( &root );
+	return true;
+}
+
+
+// Load a scene from the compiled scene if it's up to date, otherwise from the json5 scene, compiling it for next time
+static bool LoadScene( Scene& scene, const ch_string& jsonPath, const ch_string& compiledPath )
+{
+	u64   sourceSize = 0;
+	s64   sourceTime = 0;
+	bool  haveSource = GetSceneSourceStamp( jsonPath.data, sourceSize, sourceTime );
+
+	bool  loaded     = false;
+
+	// Maps can ship without the json5 scenes, then the compiled scene is used as is
+	if ( ReadCompiledScene( scene, compiledPath.data, sourceSize, sourceTime ) )
+	{
+		loaded = true;
+	}
+	else if ( haveSource )
+	{
+		if ( !LoadSceneJson( scene, jsonPath.data, jsonPath.size ) )
+		{
+			FreeScene( scene );
+			return false;
+		}
+
+		// Read it back from the compiled scene, so strings are shared across the whole scene and the values are in one allocation
+		Scene compiled;
+
+		if ( CompileScene( scene, compiledPath.data, sourceSize, sourceTime ) && ReadCompiledScene( compiled, compiledPath.data, sourceSize, sourceTime ) )
+		{
+			FreeScene( scene );
+			scene = std::move( compiled );
+		}
+		else
+		{
+			Log_WarnF( "Failed to write compiled scene, loading from json5: \"%s\"\n", compiledPath.data );
 		}
+
+		loaded = true;
 	}
 
-	map->scenes.push_back( scene );
+	if ( !loaded )
+		return false;
+
+	ch_string_auto sceneName = FileSys_GetFileNameNoExt( compiledPath.data, compiledPath.size );
+	scene.name               = scene.arena->CopyString( sceneName.data, sceneName.size );
+
 	return true;
 }
 
 
+// A scene found in the scenes folder, loaded on a worker thread
+struct SceneLoad
+{
+	ch_string scenePath;
+	ch_string jsonPath;
+	ch_string compiledPath;
+
+	Scene     scene;
+	bool      loaded = false;
+};
+
+
 Map* chmap::Load( const char* path, u64 pathLen )
 {
 	// Load mapInfo.json5 to kick things off
@@ -442,18 +1189,65 @@ Map* chmap::Load( const char* path, u64 pathLen )
 
 	std::vector< ch_string > scenePaths = FileSys_ScanDir( scenesDir.data, scenesDir.size, ReadDir_NoDirs | ReadDir_Recursive );
 
+	// Sorted so scenes end up in the same order no matter what order the file system lists them in
+	std::sort( scenePaths.begin(), scenePaths.end(), []( const ch_string& a, const ch_string& b )
+	{
+		return strcmp( a.data, b.data ) < 0;
+	} );
+
+	std::vector< SceneLoad > sceneLoads;
+
 	for ( const ch_string& scenePath : scenePaths )
 	{
-		if ( !ch_str_ends_with( scenePath, ".json5", 6 ) )
+		bool isJson     = ch_str_ends_with( scenePath, ".json5", 6 );
+		bool isCompiled = ch_str_ends_with( scenePath, ".chscene", 8 );
+
+		if ( !isJson && !isCompiled )
 			continue;
 
-		const ch_string strings[]     = { scenesDir, scenePath };
-		ch_string_auto  scenePathFull = ch_str_join( 2, strings );
+		// Path without the extension
+		const char*    baseStrings[] = { scenesDir.data, scenePath.data };
+		const size_t   baseSizes[]   = { scenesDir.size, scenePath.size - ( isJson ? 6 : 8 ) };
+		ch_string_auto basePath      = ch_str_join( 2, baseStrings, baseSizes );
 
-		if ( !LoadScene( map, scenePathFull.data ) )	
+		const char*    jsonStrings[] = { basePath.data, ".json5" };
+		const size_t   jsonSizes[]   = { basePath.size, 6 };
+		ch_string      jsonPath      = ch_str_join( 2, jsonStrings, jsonSizes );
+
+		// Compiled scenes are loaded with their json5 scene if it's there
+		if ( isCompiled && FileSys_IsFile( jsonPath.data, jsonPath.size, true ) )
 		{
-			Log_ErrorF( "Failed to load map scene: Map \"%s\" - Scene \"%s\"\n", path, scenePath.data );
+			ch_str_free( jsonPath.data );
+			continue;
 		}
+
+		const char*  compiledStrings[] = { basePath.data, ".chscene" };
+		const size_t compiledSizes[]   = { basePath.size, 8 };
+
+		SceneLoad&   sceneLoad         = sceneLoads.emplace_back();
+		sceneLoad.scenePath            = scenePath;
+		sceneLoad.jsonPath             = jsonPath;
+		sceneLoad.compiledPath         = ch_str_join( 2, compiledStrings, compiledSizes );
+	}
+
+	// Scenes are loaded across threads, and added to the map in the order they were found
+	ParallelFor( sceneLoads.size(), [ & ]( size_t i )
+	{
+		SceneLoad& sceneLoad = sceneLoads[ i ];
+		sceneLoad.loaded     = LoadScene( sceneLoad.scene, sceneLoad.jsonPath, sceneLoad.compiledPath );
+	} );
+
+	map->scenes.reserve( sceneLoads.size() );
+
+	for ( SceneLoad& sceneLoad : sceneLoads )
+	{
+		if ( sceneLoad.loaded )
+			map->scenes.push_back( std::move( sceneLoad.scene ) );
+		else
+			Log_ErrorF( "Failed to load map scene: Map \"%s\" - Scene \"%s\"\n", path, sceneLoad.scenePath.data );
+
+		ch_str_free( sceneLoad.jsonPath.data );
+		ch_str_free( sceneLoad.compiledPath.data );
 	}
 
 	ch_str_free( scenePaths.data(), scenePaths.size() );
@@ -16,6 +16,13 @@ namespace chmap
 constexpr u32 CH_MAP_VERSION       = 1;
 constexpr u32 CH_MAP_SCENE_VERSION = 1;
 
+// Compiled scene files, see the Compiled Scenes section below
+constexpr u32 CH_MAP_COMPILED_MAGIC   = 'C' | ( 'H' << 8 ) | ( 'S' << 16 ) | ( 'C' << 24 );
+constexpr u32 CH_MAP_COMPILED_VERSION = 1;
+
+struct SceneFile;
+struct SceneArena;
+
 
 // Component Data for an entity
 enum EComponentType
@@ -36,7 +43,7 @@ enum EComponentType
 
 struct ComponentValue
 {
-	// char*          name = nullptr;
+	ch_string      name;
 	EComponentType type = EComponentType_Invalid;
 
 	union
@@ -70,11 +77,35 @@ struct ComponentValue
 };
 
 
+// Values are stored in one flat array per scene, each component owns a range of it
+// Value names are interned, so values with the same name share the same string
 struct Component
 {
-	ch_string                                              name;
-	// std::vector< ComponentValue >                     values{};
-	std::unordered_map< std::string_view, ComponentValue > values{};
+	ch_string       name;
+	ComponentValue* values     = nullptr;
+	u32             valueCount = 0;
+
+	// Returns nullptr if this component doesn't have a value with this name
+	const ComponentValue* Find( const char* valueName, u64 valueNameLen ) const
+	{
+		for ( u32 i = 0; i < valueCount; i++ )
+		{
+			if ( ch_str_equals( values[ i ].name, valueName, valueNameLen ) )
+				return &values[ i ];
+		}
+
+		return nullptr;
+	}
+
+	const ComponentValue* begin() const
+	{
+		return values;
+	}
+
+	const ComponentValue* end() const
+	{
+		return values + valueCount;
+	}
 };
 
 
@@ -89,7 +120,9 @@ struct Entity
 	glm::vec3                ang{};
 	glm::vec3                scale{};
 
-	std::vector< Component > components{};
+	// Components are in one flat array per scene too, each entity owns a range of it
+	Component*               components     = nullptr;
+	u32                      componentCount = 0;
 };
 
 
@@ -115,6 +148,12 @@ struct Scene
 
 	std::vector< NestedScene > nestedScenes{};
 	std::vector< Entity >      entites{};
+
+	// Compiled scene this was read from, all strings in the scene point into it instead of being owned
+	SceneFile*                 file               = nullptr;
+
+	// Component values and every string not in the compiled scene, freed all at once with the scene
+	SceneArena*                arena              = nullptr;
 };
 
 
@@ -148,4 +187,100 @@ void    DestroyScene( Map* map, Scene* scene );
 
 Entity* GetEntityParent( Entity& entity );
 
+
+// ======================================================================================================
+// Compiled Scenes
+// 
+// Scenes are authored as json5, and compiled to a flat binary file next to it (scenes/name.chscene) the first time they're loaded
+// The compiled file is memory mapped and read in place, every string in the scene points into its string pool
+// It's rebuilt whenever the size or write time of the json5 file changes, maps can also ship with only the compiled scenes
+// 
+// Layout: header, then the entity, component and value tables, then the string pool, each table aligned to 8 bytes
+// Entities own a range of the component table, and components own a range of the value table
+// ======================================================================================================
+
+
+// Offset and size of a string in the string pool, every string is followed by a null terminator
+// Identical strings are only stored once
+struct CompiledString
+{
+	u32 offset;
+	u32 size;
+};
+
+
+struct CompiledSceneHeader
+{
+	u32 magic;    // CH_MAP_COMPILED_MAGIC
+	u32 version;  // CH_MAP_COMPILED_VERSION
+	u32 sceneFormatVersion;
+	u32 changeNumber;
+	u64 dateCreated;
+	u64 dateModified;
+
+	// Size and write time of the json5 file this was compiled from
+	u64 sourceSize;
+	s64 sourceTime;
+
+	u32 entityCount;
+	u32 componentCount;
+	u32 valueCount;
+	u32 stringPoolSize;
+
+	// Offsets from the start of the file
+	u32 entityOffset;
+	u32 componentOffset;
+	u32 valueOffset;
+	u32 stringPoolOffset;
+};
+
+
+struct CompiledEntity
+{
+	u64            id;
+	u64            parent;
+	CompiledString name;
+
+	glm::vec3      pos;
+	glm::vec3      ang;
+	glm::vec3      scale;
+
+	u32            firstComponent;
+	u32            componentCount;
+};
+
+
+struct CompiledComponent
+{
+	CompiledString name;
+	u32            firstValue;
+	u32            valueCount;
+};
+
+
+struct CompiledValue
+{
+	CompiledString name;
+	u32            type;  // EComponentType
+	u32            padding;
+
+	union
+	{
+		s64            aInteger;
+		double         aDouble;
+		CompiledString aString;
+		float          aVec[ 4 ];  // Vec2 and Vec3 only use the first components
+	};
+};
+
+
+static_assert( sizeof( CompiledSceneHeader ) == 80 );
+static_assert( sizeof( CompiledEntity ) == 72 );
+static_assert( sizeof( CompiledComponent ) == 16 );
+static_assert( sizeof( CompiledValue ) == 32 );
+
+
+// Write a scene to a compiled scene file, sourceSize and sourceTime are from the json5 file it was loaded from
+bool    CompileScene( const Scene& scene, const char* path, u64 sourceSize, s64 sourceTime );
+
 }
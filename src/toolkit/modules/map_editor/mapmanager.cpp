@@ -203,23 +203,25 @@ static bool MapManager_LoadScene( chmap::Scene& scene )
 		ent->aTransform.aScale        = mapEntity.scale;
 
 		// Check Built in components (TODO: IMPROVE THIS)
-		for ( chmap::Component& comp : mapEntity.components )
+		for ( u32 compI = 0; compI < mapEntity.componentCount; compI++ )
 		{
+			chmap::Component& comp = mapEntity.components[ compI ];
+
 			// Load a renderable
 			// if ( ch_str_equals( comp.name, "renderable", 10 ) )
 			if ( CH_STR_EQUALS_STATIC( comp.name, "renderable" ) )
 			{
-				auto it = comp.values.find( "path" );
-				if ( it == comp.values.end() )
+				const chmap::ComponentValue* path = comp.Find( "path", 4 );
+				if ( !path )
 				{
 					Log_Error( gLC_Map, "Failed to find renderable model path in component\n" );
 					continue;
 				}
 
-				if ( it->second.type != chmap::EComponentType_String )
+				if ( path->type != chmap::EComponentType_String )
 					continue;
 
-				ent->aModel = graphics->LoadModel( it->second.aString.data );
+				ent->aModel = graphics->LoadModel( path->aString.data );
 
 				if ( ent->aModel == CH_INVALID_HANDLE )
 					continue;
@@ -227,31 +229,31 @@ static bool MapManager_LoadScene( chmap::Scene& scene )
 				ent->aRenderable = graphics->CreateRenderable( ent->aModel );
 
 				// Load other renderable data
-				// for ( const auto& [ name, compValue ] : comp.values )
+				// for ( const chmap::ComponentValue& compValue : comp )
 				// {
 				// }
 			}
 			else if ( ch_str_equals( comp.name, "light", 5 ) )
 			{
-				auto it = comp.values.find( "type" );
-				if ( it == comp.values.end() )
+				const chmap::ComponentValue* type = comp.Find( "type", 4 );
+				if ( !type )
 				{
 					Log_Error( gLC_Map, "Failed to find light type in component\n" );
 					continue;
 				}
 
-				if ( it->second.type != chmap::EComponentType_String )
+				if ( type->type != chmap::EComponentType_String )
 					continue;
 
-				if ( ch_str_equals( it->second.aString , "world", 5 ) )
+				if ( ch_str_equals( type->aString , "world", 5 ) )
 				{
 					ent->apLight = graphics->CreateLight( ELightType_World );
 				}
-				else if ( ch_str_equals( it->second.aString, "point", 5 ) )
+				else if ( ch_str_equals( type->aString, "point", 5 ) )
 				{
 					ent->apLight = graphics->CreateLight( ELightType_Point );
 				}
-				else if ( ch_str_equals( it->second.aString, "spot", 4 ) )
+				else if ( ch_str_equals( type->aString, "spot", 4 ) )
 				{
 					ent->apLight = graphics->CreateLight( ELightType_Spot );
 
@@ -264,21 +266,21 @@ static bool MapManager_LoadScene( chmap::Scene& scene )
 				// }
 				else
 				{
-					Log_ErrorF( gLC_Map, "Unknown Light Type: %s\n", it->second.aString.data );
+					Log_ErrorF( gLC_Map, "Unknown Light Type: %s\n", type->aString.data );
 					continue;
 				}
 
 				// Read the rest of the light data
-				for ( const auto& [ name, compValue ] : comp.values )
+				for ( const chmap::ComponentValue& compValue : comp )
 				{
-					if ( ch_str_equals( name.data(), name.size(), "color", 5 ) )
+					if ( ch_str_equals( compValue.name, "color", 5 ) )
 					{
 						if ( compValue.type != chmap::EComponentType_Vec4 )
 							continue;
 
 						ent->apLight->color = compValue.aVec4;
 					}
-					else if ( ch_str_equals( name.data(), name.size(), "radius", 6 ) )
+					else if ( ch_str_equals( compValue.name, "radius", 6 ) )
 					{
 						if ( compValue.type == chmap::EComponentType_Int )
 							ent->apLight->aRadius = compValue.aInteger;
@@ -290,15 +292,15 @@ static bool MapManager_LoadScene( chmap::Scene& scene )
 			}
 			else if ( ch_str_equals( comp.name, "phys_object", 11 ) )
 			{
-				auto it = comp.values.find( "path" );
-				if ( it == comp.values.end() )
+				const chmap::ComponentValue* path = comp.Find( "path", 4 );
+				if ( !path )
 				{
 					Log_Error( gLC_Map, "Failed to find physics object path in component\n" );
 					continue;
 				}
 
-				auto itType = comp.values.find( "type" );
-				if ( itType == comp.values.end() )
+				const chmap::ComponentValue* type = comp.Find( "type", 4 );
+				if ( !type )
 				{
 					Log_Error( gLC_Map, "Failed to find physics object type in component\n" );
 					continue;
@@ -307,17 +309,17 @@ static bool MapManager_LoadScene( chmap::Scene& scene )
 				PhysShapeType     shapeType;
 				PhysicsObjectInfo settings{};
 
-				if ( ch_str_equals( itType->second.aString, "convex", 6 ) )
+				if ( ch_str_equals( type->aString, "convex", 6 ) )
 				{
 					shapeType            = PhysShapeType::Convex;
 					settings.aMotionType = PhysMotionType::Dynamic;
 				}
-				else if ( ch_str_equals( itType->second.aString, "static_compound", 15 ) )
+				else if ( ch_str_equals( type->aString, "static_compound", 15 ) )
 				{
 					shapeType            = PhysShapeType::StaticCompound;
 					settings.aMotionType = PhysMotionType::Dynamic;
 				}
-				else if ( ch_str_equals( itType->second.aString, "mesh", 4 ) )
+				else if ( ch_str_equals( type->aString, "mesh", 4 ) )
 				{
 					shapeType            = PhysShapeType::Mesh;
 					settings.aMotionType = PhysMotionType::Static;
@@ -329,7 +331,7 @@ static bool MapManager_LoadScene( chmap::Scene& scene )
 				}
 
 
-				IPhysicsShape* shape = GetPhysEnv()->LoadShape( it->second.aString.data, it->second.aString.size, shapeType );
+				IPhysicsShape* shape = GetPhysEnv()->LoadShape( path->aString.data, path->aString.size, shapeType );
 
 				if ( !shape )
 					continue;